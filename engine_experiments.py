@@ -0,0 +1,54 @@
+import os
+import sys
+from itertools import product
+
+#
+# Generate SLURM scripts comparing the tree and linear engines.
+# Each run stops at the target rmse and prints the wall time it took.
+#
+base_str = """#!/bin/bash
+#SBATCH --mail-user={email}
+#SBATCH --mail-type=FAIL
+#SBATCH --time=01:00:00
+#SBATCH --ntasks-per-node=28
+#SBATCH --nodes=1
+#SBATCH --mem=96G
+#SBATCH --job-name={name}
+#SBATCH --array=0-9
+#SBATCH --account={buyin}
+#SBATCH --output={output}/%x_%A_%a.out
+
+cd ${{SLURM_SUBMIT_DIR}}
+
+export OMP_NUM_THREADS=28,1
+./run.out -m 0.1 -c 0.75 -s ${{SLURM_ARRAY_TASK_ID}} -f {func} -p 250 -g 10000 -e {engine} -t {target} -o ./{output}/
+
+scontrol show job ${{SLURM_JOB_ID}}
+"""
+
+try:
+    email, buyin, output = sys.argv[1], sys.argv[2], sys.argv[3]
+except IndexError:
+    print("Must provide email, buy-in group name, and output directory.")
+
+functions = [1, 2, 3, 4]
+engines = [0, 1]
+target_rmse = 0.1
+map_to_name = {1: "log", 2: "exp", 3: "sin", 4: "parabola"}
+engine_names = {0: "tree", 1: "linear"}
+
+for func, engine in product(functions, engines):
+    name = "{}_{}".format(map_to_name[func], engine_names[engine])
+    this_output = os.path.join(output, name)
+    os.makedirs(this_output, exist_ok=True)
+
+    with open(name + ".sb", "w") as fptr:
+        fptr.write(base_str.format(
+            email=email,
+            name=name,
+            buyin=buyin,
+            output=this_output,
+            func=func,
+            engine=engine,
+            target=target_rmse
+        ))
@@ -0,0 +1,142 @@
+#include <queue>
+#include <vector>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include "population.h"
+#include "linear_population.h"
+#include "engine.h"
+#include "balance.h"
+
+using std::vector;
+using std::shared_ptr;
+
+/**
+ * Estimated evaluation cost of every individual.
+ * @param  population  shared_ptr<PopulationType>
+ * @param  num_samples size_t, samples each individual is evaluated on.
+ * @return             vector<double>, one cost per individual.
+ */
+template <typename PopulationType>
+vector<double> Balance::costs(shared_ptr<PopulationType> population,
+        size_t num_samples) {
+    vector<double> costs(population->get_length());
+
+    for (size_t i = 0; i < population->get_length(); i++) {
+        costs[i] = (double)EngineTraits<PopulationType>::size((*population)[i])
+            * num_samples;
+    }
+
+    return costs;
+}
+
+template vector<double> Balance::costs<Population>(shared_ptr<Population>, size_t);
+template vector<double> Balance::costs<LinearPopulation>(
+    shared_ptr<LinearPopulation>, size_t);
+
+/**
+ * Indices ordered by decreasing cost, ties keep their original order.
+ * Spawning tasks in this order lets the largest programs start first, so
+ * the small ones fill in the gaps at the end.
+ * @param  costs vector<double>
+ * @return       vector<size_t>
+ */
+vector<size_t> Balance::largest_first(const vector<double> & costs) {
+    vector<size_t> order(costs.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    std::stable_sort(order.begin(), order.end(),
+        [&costs](const size_t & a, const size_t & b) -> bool
+        {
+            return costs[a] > costs[b];
+        });
+
+    return order;
+}
+
+/**
+ * Longest processing time first partitioning: each individual, largest first,
+ * goes to the part with the least cost so far. Within a part indices stay in
+ * decreasing cost order.
+ * @param  costs      vector<double>
+ * @param  parts      int, number of parts (ranks), > 0.
+ * @param  assignment vector<vector<int>>, resized to parts, indices per part.
+ * @return            vector<double>, estimated cost of each part.
+ */
+vector<double> Balance::partition(const vector<double> & costs, int parts,
+        vector<vector<int>> & assignment) {
+    typedef std::pair<double, int> load; // (cost so far, part)
+    std::priority_queue<load, vector<load>, std::greater<load>> lightest;
+    vector<double> loads(parts, 0);
+
+    assignment.assign(parts, vector<int>());
+    for (int p = 0; p < parts; p++) {
+        lightest.push(load(0, p));
+    }
+
+    for (size_t i : largest_first(costs)) {
+        load top = lightest.top();
+        lightest.pop();
+
+        assignment[top.second].push_back(i);
+        top.first += costs[i];
+        loads[top.second] = top.first;
+        lightest.push(top);
+    }
+
+    return loads;
+}
+
+/**
+ * Longest processing time first over parts of different capacity, such as
+ * nodes with different numbers of ranks: each individual, largest first,
+ * goes to the part that would finish it first, load over capacity. Equal
+ * capacities give the same split as partition(costs, parts, assignment).
+ * @param  costs      vector<double>
+ * @param  capacities vector<double>, relative speed of each part, > 0.
+ * @param  assignment vector<vector<int>>, resized to the parts, indices per part.
+ * @return            vector<double>, estimated cost of each part.
+ */
+vector<double> Balance::partition(const vector<double> & costs,
+        const vector<double> & capacities, vector<vector<int>> & assignment) {
+    size_t parts = capacities.size();
+    vector<double> loads(parts, 0);
+    assignment.assign(parts, vector<int>());
+
+    for (size_t i : largest_first(costs)) {
+        size_t best = 0;
+        for (size_t p = 1; p < parts; p++) {
+            if ((loads[p] + costs[i]) / capacities[p]
+                < (loads[best] + costs[i]) / capacities[best]) {
+                best = p;
+            }
+        }
+
+        assignment[best].push_back(i);
+        loads[best] += costs[i];
+    }
+
+    return loads;
+}
+
+/**
+ * Load imbalance, the largest load over the mean. 1 is perfectly balanced.
+ * @param  loads vector<double>, times or costs per rank or thread.
+ * @return       double
+ */
+double Balance::imbalance(const vector<double> & loads) {
+    if (loads.empty()) {
+        return 1;
+    }
+
+    double total = std::accumulate(loads.begin(), loads.end(), 0.0);
+    double largest = *std::max_element(loads.begin(), loads.end());
+
+    if (total <= 0) {
+        return 1;
+    }
+
+    return largest / (total / loads.size());
+}
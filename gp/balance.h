@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+using std::vector;
+
+/**
+ * Static load balancing from a cost model. An individual's estimated cost is
+ * its size (nodes or instructions) times the number of samples it is
+ * evaluated on, program sizes range from a few nodes to MAX_NUM_NODES so
+ * counting individuals alone leaves ranks and threads idle.
+ */
+struct Balance {
+    template <typename PopulationType>
+    static vector<double> costs(std::shared_ptr<PopulationType> population,
+                                size_t num_samples);
+    static vector<size_t> largest_first(const vector<double> & costs);
+    static vector<double> partition(const vector<double> & costs, int parts,
+                                    vector<vector<int>> & assignment);
+    static vector<double> partition(const vector<double> & costs,
+                                    const vector<double> & capacities,
+                                    vector<vector<int>> & assignment);
+    static double imbalance(const vector<double> & loads);
+
+private:
+    Balance() {}
+};
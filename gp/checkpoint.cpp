@@ -0,0 +1,262 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+#include "population.h"
+#include "linear_population.h"
+#include "individual.h"
+#include "linear.h"
+#include "engine.h"
+#include "serialization.h"
+#include "checkpoint.h"
+
+using std::cerr;
+using std::endl;
+
+static_assert(std::is_trivially_copyable<mt19937>::value,
+    "checkpoints store the master engine as raw bytes");
+
+static const char MAGIC[8] = {'G', 'P', 'C', 'K', 'P', 'T', '\0', '\0'};
+
+static volatile std::sig_atomic_t terminate_requested = 0;
+
+static void on_terminate(int /*signal*/) {
+    terminate_requested = 1;
+}
+
+/**
+ * Round an offset up to the next multiple of 8.
+ */
+static uint64_t aligned(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+Checkpoint::Checkpoint(const string & _file_name, int _engine, int _seed,
+        int _function, int _population_size, int _num_samples) :
+        file_name(_file_name) {
+    this->run = CheckpointHeader();
+    std::memcpy(this->run.magic, MAGIC, sizeof(MAGIC));
+    this->run.version = VERSION;
+    this->run.engine_bytes = sizeof(mt19937);
+    this->run.engine = _engine;
+    this->run.seed = _seed;
+    this->run.function = _function;
+    this->run.population_size = _population_size;
+    this->run.num_samples = _num_samples;
+}
+
+/**
+ * Snapshot the run before generation is evaluated and write it in the
+ * background. Waits for the previous write first, call wait to be sure this
+ * one is on disk.
+ * @param population PopulationType, updated for generation.
+ * @param engine     mt19937, master engine after the update.
+ * @param generation int, next generation to evaluate.
+ */
+template <typename PopulationType>
+void Checkpoint::save(PopulationType & population, const mt19937 & engine,
+        int generation) {
+    typedef EngineTraits<PopulationType> Traits;
+    this->wait();
+
+    size_t n = population.get_length();
+    CheckpointHeader header = this->run;
+    header.generation = generation;
+    header.state = population.get_state();
+    header.fitness_offset = aligned(sizeof(CheckpointHeader) + sizeof(mt19937));
+    header.records_offset = aligned(header.fitness_offset + n * sizeof(float));
+
+    vector<uint8_t> & buffer = this->pending;
+    buffer.assign(header.records_offset, 0);
+    GenomeWriter writer(buffer);
+    for (size_t i = 0; i < n; i++) {
+        Traits::encode(population[i], writer);
+    }
+    header.records_bytes = buffer.size() - header.records_offset;
+
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    std::memcpy(buffer.data() + sizeof(header), &engine, sizeof(mt19937));
+    for (size_t i = 0; i < n; i++) {
+        float fitness = population[i]->get_fitness();
+        std::memcpy(buffer.data() + header.fitness_offset + i * sizeof(float),
+            &fitness, sizeof(float));
+    }
+
+    this->writer = std::thread(&Checkpoint::write, this->file_name,
+        std::cref(this->pending));
+}
+
+/**
+ * Block until the last save is on disk.
+ */
+void Checkpoint::wait() {
+    if (this->writer.joinable()) {
+        this->writer.join();
+    }
+}
+
+/**
+ * Write buffer beside file_name and rename it into place once it is synced.
+ * @param file_name string
+ * @param buffer    vector<uint8_t>, a whole checkpoint.
+ */
+void Checkpoint::write(const string & file_name, const vector<uint8_t> & buffer) {
+    string partial = file_name + ".tmp";
+    FILE * file = fopen(partial.c_str(), "wb");
+    if (file == nullptr) {
+        cerr << "Could not write checkpoint " << partial << endl;
+        return;
+    }
+
+    bool written = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    written = fflush(file) == 0 && written;
+    written = fsync(fileno(file)) == 0 && written;
+    written = fclose(file) == 0 && written;
+
+    if (! written || rename(partial.c_str(), file_name.c_str()) != 0) {
+        cerr << "Could not write checkpoint " << file_name << endl;
+    }
+}
+
+/**
+ * Restore a run from a checkpoint. The file is mapped and the records are
+ * decoded in parallel where they lie, so call this outside of a parallel
+ * region.
+ * @param  resume_name string, checkpoint to read.
+ * @param  population  PopulationType, replaced by the checkpoint's.
+ * @param  engine      mt19937, set to the checkpoint's master engine.
+ * @param  generation  int, set to the next generation to evaluate.
+ * @return             bool, false (with the reason on stderr) if the file
+ *                     is not a checkpoint of this run.
+ */
+template <typename PopulationType>
+bool Checkpoint::load(const string & resume_name, PopulationType & population,
+        mt19937 & engine, int & generation) const {
+    typedef EngineTraits<PopulationType> Traits;
+
+    int fd = open(resume_name.c_str(), O_RDONLY);
+    struct stat sb;
+    if (fd == -1 || fstat(fd, &sb) == -1 || (size_t)sb.st_size < sizeof(CheckpointHeader)) {
+        cerr << "Could not read checkpoint " << resume_name << endl;
+        if (fd != -1) {
+            close(fd);
+        }
+        return false;
+    }
+
+    size_t size = sb.st_size;
+    void * mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        cerr << "Could not map checkpoint " << resume_name << endl;
+        return false;
+    }
+    const uint8_t * data = (const uint8_t *)mapped;
+
+    CheckpointHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    string problem = this->mismatch(header, size);
+
+    vector<GenomeView> genomes;
+    if (problem.empty()) {
+        GenomeReader reader(data + header.records_offset, header.records_bytes);
+        GenomeView genome;
+        while (reader.next(genome)) {
+            genomes.push_back(genome);
+        }
+        if (reader.get_offset() != header.records_bytes) {
+            problem = "a genome record is truncated";
+        }
+        else if (genomes.size() != (size_t)header.population_size) {
+            problem = "it holds " + std::to_string(genomes.size()) + " genomes";
+        }
+    }
+
+    // Records come from disk, check all of them before decoding any.
+    if (problem.empty()) {
+        bool valid = true;
+        #pragma omp parallel for schedule(dynamic, 64) reduction(&&: valid)
+        for (long i = 0; i < (long)genomes.size(); i++) {
+            valid = valid && Traits::valid(genomes[i]);
+        }
+        if (! valid) {
+            problem = "a genome record is corrupt";
+        }
+    }
+
+    if (! problem.empty()) {
+        cerr << "Cannot resume from " << resume_name << ": " << problem << endl;
+        munmap(mapped, size);
+        return false;
+    }
+
+    std::memcpy(&engine, data + sizeof(header), sizeof(mt19937));
+    generation = header.generation;
+
+    vector<typename Traits::individual_ptr> individuals(genomes.size());
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (long i = 0; i < (long)genomes.size(); i++) {
+        individuals[i] = Traits::decode(genomes[i]);
+        individuals[i]->set_fitness(Serialization::read_float(
+            data + header.fitness_offset + i * sizeof(float)));
+    }
+
+    munmap(mapped, size);
+    population.restore(header.state, individuals);
+    return true;
+}
+
+/**
+ * Why a checkpoint cannot resume this run.
+ * @param  header CheckpointHeader, as read.
+ * @param  size   size_t, bytes in the file.
+ * @return        string, empty if it can.
+ */
+string Checkpoint::mismatch(const CheckpointHeader & header, size_t size) const {
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        return "not a checkpoint";
+    }
+    if (header.version != VERSION || header.engine_bytes != sizeof(mt19937)) {
+        return "written by a different build";
+    }
+    if (header.engine != this->run.engine || header.seed != this->run.seed
+        || header.function != this->run.function
+        || header.population_size != this->run.population_size
+        || header.num_samples != this->run.num_samples) {
+        return "engine, seed, function, population size or samples differ";
+    }
+    // Compared without sums, so huge offsets cannot wrap around.
+    if (header.records_offset > size || header.records_bytes > size - header.records_offset
+        || header.fitness_offset < sizeof(CheckpointHeader) + sizeof(mt19937)
+        || header.fitness_offset > header.records_offset
+        || header.population_size * sizeof(float)
+            > header.records_offset - header.fitness_offset) {
+        return "file is truncated";
+    }
+    return "";
+}
+
+/**
+ * Turn SIGTERM into a request that terminated reports, so a run can write
+ * a checkpoint and stop at the end of the generation.
+ */
+void Checkpoint::watch_terminate() {
+    std::signal(SIGTERM, on_terminate);
+}
+
+bool Checkpoint::terminated() {
+    return terminate_requested != 0;
+}
+
+template void Checkpoint::save<Population>(Population &, const mt19937 &, int);
+template void Checkpoint::save<LinearPopulation>(LinearPopulation &, const mt19937 &, int);
+template bool Checkpoint::load<Population>(const string &, Population &,
+    mt19937 &, int &) const;
+template bool Checkpoint::load<LinearPopulation>(const string &, LinearPopulation &,
+    mt19937 &, int &) const;
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include <cstdint>
+
+using std::string; using std::vector; using std::mt19937;
+
+/**
+ * What a population carries from one update to the next besides its
+ * individuals.
+ */
+struct PopulationState {
+    uint32_t generation = 0;        // Updates so far, keys the breeding streams.
+    int32_t initial_size_limit = 0; // Largest initial individual, 0 before the first update.
+    int32_t size_limit = 0;         // Current dynamic size limit.
+};
+
+/**
+ * Start of a checkpoint file. The run fields must match the resuming run.
+ */
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t engine_bytes;   // sizeof(mt19937) of the writer.
+    int32_t engine;          // Run: Driver::Engine.
+    int32_t seed;            // Run: master seed.
+    int32_t function;        // Run: FunctionFactory::FunctionType.
+    int32_t population_size; // Run: individuals.
+    int32_t num_samples;     // Run: samples drawn each generation.
+    uint32_t generation;     // Next generation to evaluate.
+    PopulationState state;
+    uint32_t padding;        // Always 0, so every byte written is set.
+    uint64_t fitness_offset; // One float per individual.
+    uint64_t records_offset; // Genome records, see serialization.h.
+    uint64_t records_bytes;
+};
+
+/**
+ * Binary snapshots of a generational run, taken between the update of one
+ * generation and the evaluation of the next:
+ *
+ *  [CheckpointHeader][mt19937][fitnesses][genome records]
+ *
+ * The master engine is stored as raw bytes and every stream the run opens
+ * afterwards comes from it or from the generation counter, so a resumed run
+ * evolves exactly as the original would have. Sections are 8 byte aligned
+ * and in host byte order, a file is read back by mapping it and decoding
+ * the records in place.
+ *
+ * save only encodes the population, a background thread writes the file
+ * next to the old one and renames it over it, so the last complete
+ * checkpoint survives a crash mid-write.
+ */
+class Checkpoint {
+public:
+    static const uint32_t VERSION = 1;
+
+    /**
+     * Constructor.
+     * @param _file_name       string, where checkpoints are written.
+     * @param _engine          int, Driver::Engine of the run.
+     * @param _seed            int, master seed of the run.
+     * @param _function        int, FunctionFactory::FunctionType of the run.
+     * @param _population_size int
+     * @param _num_samples     int
+     */
+    Checkpoint(const string & _file_name, int _engine, int _seed, int _function,
+               int _population_size, int _num_samples);
+    ~Checkpoint() { this->wait(); }
+    Checkpoint(const Checkpoint &) = delete;
+    Checkpoint & operator=(const Checkpoint &) = delete;
+
+    template <typename PopulationType>
+    void save(PopulationType & population, const mt19937 & engine,
+              int generation);
+    void wait();
+
+    template <typename PopulationType>
+    bool load(const string & resume_name, PopulationType & population,
+              mt19937 & engine, int & generation) const;
+
+    static void watch_terminate();
+    static bool terminated();
+
+    const string & get_file_name() const { return this->file_name; }
+
+private:
+    static void write(const string & file_name, const vector<uint8_t> & buffer);
+    string mismatch(const CheckpointHeader & header, size_t size) const;
+
+    string file_name;
+    CheckpointHeader run;    // Run fields filled in, the rest per save.
+    vector<uint8_t> pending; // Bytes being written by writer.
+    std::thread writer;
+};
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include "decomposition.h"
+
+const size_t Decomposition::MIN_INDIVIDUALS;
+const size_t Decomposition::MIN_SAMPLES;
+
+/**
+ * Pick the grid for a run. Every grid gives each rank the same share of the
+ * work, so the choice is about overheads: splitting individuals needs no
+ * reduction but balances worse as blocks shrink, splitting samples
+ * balances perfectly but repeats the per program setup on every shard. The
+ * fewest sample shards that leave every block MIN_INDIVIDUALS wins. If no
+ * grid does, the one whose blocks and shards are both largest relative to
+ * their minimums.
+ * @param  individuals size_t, population size.
+ * @param  samples     size_t, fitness cases per generation.
+ * @param  ranks       int
+ * @return             Decomposition
+ */
+Decomposition Decomposition::choose(size_t individuals, size_t samples, int ranks) {
+    Decomposition best;
+    best.individual_blocks = ranks;
+    double best_score = -1;
+
+    for (int shards = 1; shards <= ranks; shards++) {
+        if (ranks % shards != 0) {
+            continue;
+        }
+
+        int blocks = ranks / shards;
+        double block_fill = (double)individuals / blocks / MIN_INDIVIDUALS;
+        double shard_fill = (double)samples / shards / MIN_SAMPLES;
+
+        if (block_fill >= 1) {
+            best.individual_blocks = blocks;
+            best.sample_shards = shards;
+            return best;
+        }
+
+        double score = std::min(block_fill, shard_fill);
+        if (score > best_score) {
+            best_score = score;
+            best.individual_blocks = blocks;
+            best.sample_shards = shards;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Samples of one shard.
+ * @param samples size_t, fitness cases per generation.
+ * @param shard   int
+ * @param shards  int
+ * @param begin   size_t, set to the first sample of the shard.
+ * @param end     size_t, set to one past its last sample.
+ */
+void Decomposition::shard_range(size_t samples, int shard, int shards,
+        size_t & begin, size_t & end) {
+    begin = samples * shard / shards;
+    end = samples * (shard + 1) / shards;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Split of the ranks into a grid of individual blocks by sample shards.
+ * Rank r evaluates individual block r / sample_shards on sample shard
+ * r % sample_shards, partial squared errors are summed over the shards.
+ */
+struct Decomposition {
+    // Below these a block or shard costs more in overhead than it saves.
+    static const size_t MIN_INDIVIDUALS = 32; // Per individual block.
+    static const size_t MIN_SAMPLES = 64;     // Per sample shard.
+
+    int individual_blocks = 1;
+    int sample_shards = 1;
+
+    static Decomposition choose(size_t individuals, size_t samples, int ranks);
+    static void shard_range(size_t samples, int shard, int shards, size_t & begin,
+                            size_t & end);
+};
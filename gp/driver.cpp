@@ -1,9 +1,11 @@
 #include <random>
 #include <memory>
 #include <vector>
-#include <sstream>
 #include <fstream>
-#include "mpi.h"
+#include <numeric>
+#include <list>
+#include <algorithm>
+#include "transport.h"
 #include "omp.h"
 #include "logger.h"
 #include "function.h"
@@ -11,6 +13,17 @@
 #include "evaluation.h"
 #include "population.h"
 #include "individual.h"
+#include "linear_population.h"
+#include "engine.h"
+#include "random.h"
+#include "balance.h"
+#include "duplicates.h"
+#include "selection.h"
+#include "exchange.h"
+#include "migration.h"
+#include "work_queue.h"
+#include "decomposition.h"
+#include "checkpoint.h"
 #include "driver.h"
 
 #include <iostream>
@@ -30,105 +43,294 @@ using std::shared_ptr;
  * @param _seed            int, random seed.
  * @param _population_size int, > 2
  * @param _generations     int, > 1
+ * @param _output_dir      string, where logs are written.
+ * @param _options         DriverOptions, optional settings.
  */
 Driver::Driver(float _mutation_rate, float _crossover_rate, int _seed, int _function,
-        int _population_size, int _generations, std::string _output_dir) :
+        int _population_size, int _generations, std::string _output_dir,
+        const DriverOptions & _options) :
              mutation_rate(_mutation_rate), crossover_rate(_crossover_rate),
-             function(_function), root_engine(_seed),
+             seed(_seed), function(_function), root_engine(_seed),
              population_size(_population_size),
-             generations(_generations) {
+             generations(_generations), options(_options) {
     this->logger = new Logger(_output_dir, _seed);
+    this->checkpoint_name = _output_dir + "/checkpoint" + std::to_string(_seed) + ".bin";
+}
+
+/**
+ * Destructor, the logger writes out what it still holds.
+ */
+Driver::~Driver() {
+    delete this->logger;
 }
 
 
 /**
- * Evaluates a group of individuals.
- * @param group vector of pointers to individuals.
+ * Encode a population once and group identical genomes.
+ * @param  population  shared_ptr<PopulationType>
+ * @param  num_samples size_t, samples each genome is evaluated on.
+ * @param  buffer      vector<uint8_t>, set to the records of every individual.
+ * @param  unique      vector<GenomeView>, one record per distinct genome.
+ * @param  costs       vector<double>, estimated cost of each distinct genome.
+ * @return             vector<size_t>, for each individual its index into unique.
  */
-void Driver::evaluate_population(shared_ptr<Population> population,
-    const vector<float> & samples, const vector<float> & ground_truth) {
+template <typename PopulationType>
+vector<size_t> encode_unique(shared_ptr<PopulationType> population,
+    size_t num_samples, vector<uint8_t> & buffer, vector<GenomeView> & unique,
+    vector<double> & costs) {
+    GenomeWriter writer(buffer);
+    buffer.clear();
+
+    for (size_t i = 0; i < population->get_length(); i++) {
+        EngineTraits<PopulationType>::encode((*population)[i], writer);
+    }
+
+    // Views are taken once the buffer is complete and will not move.
+    vector<GenomeView> genomes(population->get_length());
+    GenomeReader reader(buffer.data(), buffer.size());
+    for (size_t i = 0; i < genomes.size(); i++) {
+        reader.next(genomes[i]);
+    }
+
+    vector<size_t> representatives;
+    vector<size_t> groups = Duplicates::group(genomes, representatives);
+    vector<double> all_costs = Balance::costs(population, num_samples);
+
+    unique.resize(representatives.size());
+    costs.resize(representatives.size());
+    for (size_t u = 0; u < representatives.size(); u++) {
+        unique[u] = genomes[representatives[u]];
+        costs[u] = all_costs[representatives[u]];
+    }
+
+    return groups;
+}
 
-    for (int i = 0; i < population->get_length(); i++) {
-        #pragma omp task shared(population, samples, ground_truth)
+/**
+ * Lay out per-genome errors case major for the whole population, the
+ * layout lexicase filters candidates in.
+ * @param  unique_errors float pointer, num_cases errors per distinct genome.
+ * @param  groups        vector<size_t>, distinct genome of each individual.
+ * @param  num_cases     size_t
+ * @return               vector<float>, errors[c * n + i].
+ */
+vector<float> case_major(const float * unique_errors,
+    const vector<size_t> & groups, size_t num_cases) {
+    size_t n = groups.size();
+    vector<float> errors(n * num_cases);
+
+    for (size_t i = 0; i < n; i++) {
+        const float * row = &unique_errors[groups[i] * num_cases];
+        for (size_t c = 0; c < num_cases; c++) {
+            errors[c * n + i] = row[c];
+        }
+    }
+
+    return errors;
+}
+
+/**
+ * Evaluates a group of individuals. Identical genomes are evaluated once,
+ * and tasks are spawned largest estimated cost first so the long programs
+ * are not left until the end.
+ * @param  population   shared_ptr<PopulationType>
+ * @param  samples      vector<float>, random samples from domain
+ * @param  ground_truth vector<float>, function applied to samples
+ * @return              EvaluationStats
+ */
+template <typename PopulationType>
+EvaluationStats Driver::evaluate_population(shared_ptr<PopulationType> population,
+    const vector<float> & samples, const vector<float> & ground_truth) {
+    vector<uint8_t> buffer;
+    vector<GenomeView> unique;
+    vector<double> costs;
+    vector<size_t> groups = encode_unique(population, samples.size(), buffer,
+        unique, costs);
+
+    vector<size_t> order = Balance::largest_first(costs);
+    vector<float> fitnesses(unique.size(), 0);
+    vector<double> busy(omp_get_num_threads(), 0);
+
+    // Lexicase selection also needs the error on every sample.
+    const size_t num_cases = samples.size();
+    bool lexicase = this->options.selection == Selection::LEXICASE;
+    vector<float> unique_errors(lexicase ? unique.size() * num_cases : 0);
+
+    for (size_t k = 0; k < order.size(); k++) {
+        size_t u = order[k];
+
+        #pragma omp task shared(unique, samples, ground_truth, fitnesses, busy, \
+            unique_errors) firstprivate(u)
         {
-            // Set each individual's fitness.
-            (*population)[i]->set_fitness(
-                Evaluation::assign_rmse(
-                    (*population)[i]->get_tree()->get_rpn_string(),
-                    samples, ground_truth) + (*population)[i]->get_tree()->num_nodes()
-            );
+            double start_time = omp_get_wtime();
+
+            fitnesses[u] = EngineTraits<PopulationType>::fitness(unique[u],
+                samples, ground_truth,
+                lexicase ? &unique_errors[u * num_cases] : nullptr);
+
+            busy[omp_get_thread_num()] += omp_get_wtime() - start_time;
         }
     }
 
     #pragma omp taskwait
+
+    // Set each individual's fitness from its group.
+    for (size_t i = 0; i < population->get_length(); i++) {
+        (*population)[i]->set_fitness(fitnesses[groups[i]]);
+    }
+
+    if (lexicase) {
+        vector<float> errors = case_major(unique_errors.data(), groups, num_cases);
+        population->set_case_errors(errors, num_cases);
+    }
+
+    EvaluationStats stats;
+    stats.imbalance = Balance::imbalance(busy);
+    stats.unique_ratio = unique.size() / (double)population->get_length();
+    return stats;
 }
 
 
 /**
- * Evaluate a group of strings rather than individuals.
- * @param rpn_strings  vector<string>
+ * Evaluate a group of binary genome records rather than individuals.
+ * Tasks are spawned in record order, the master sends them largest first.
+ * @param genomes      vector<GenomeView>, records of a received payload.
  * @param samples      vector<float>, random samples from domain
  * @param ground_truth vector<float>, function applied to samples
  * @param fitnesses    vector<float>, results of RMSE calculation
+ * @param errors       vector<float>, if not empty set to the errors on each
+ *                     sample, one row per record.
  */
-void evaluate_group_strings(const vector<string> & rpn_strings,
+template <typename PopulationType>
+void evaluate_group_encoded(const vector<GenomeView> & genomes,
             const vector<float> & samples, const vector<float> & ground_truth,
-            vector<float> & fitnesses) {
-    for (int i = 0; i < rpn_strings.size(); i++) {
-        #pragma omp task shared(rpn_strings, samples, ground_truth, fitnesses)
-        {
-            // Get number of nodes.
-            std::stringstream ss(rpn_strings[i]);
-            string temp;
-            int count = 0;
-            while(getline(ss, temp, ' ')) { count++; }
+            vector<float> & fitnesses, vector<float> & errors) {
+    const size_t num_cases = samples.size();
+    bool with_errors = ! errors.empty();
 
+    for (int i = 0; i < genomes.size(); i++) {
+        #pragma omp task shared(genomes, samples, ground_truth, fitnesses, errors)
+        {
             // Set each individual's fitness.
-            fitnesses[i] = Evaluation::assign_rmse(rpn_strings[i],
-                samples, ground_truth) + count;
+            fitnesses[i] = EngineTraits<PopulationType>::fitness(genomes[i],
+                samples, ground_truth,
+                with_errors ? &errors[i * num_cases] : nullptr);
         }
     }
 
     #pragma omp taskwait
 }
 
+/**
+ * Sums of squared errors of some distinct genomes on one shard of the
+ * samples, to be summed over the shards.
+ * @param unique       vector<GenomeView>, distinct genomes.
+ * @param members      vector<int>, the ones to evaluate.
+ * @param samples      vector<float>, the shard's samples.
+ * @param ground_truth vector<float>, function applied to samples
+ * @param sums         vector<float>, set at each member's index.
+ * @param errors       vector<float>, if not empty one row of num_cases errors
+ *                     per distinct genome, the shard's part of each member's
+ *                     row is set.
+ * @param num_cases    size_t, samples over all shards.
+ * @param offset       size_t, first sample of the shard.
+ */
+template <typename PopulationType>
+void evaluate_shard(const vector<GenomeView> & unique, const vector<int> & members,
+        const vector<float> & samples, const vector<float> & ground_truth,
+        vector<float> & sums, vector<float> & errors, size_t num_cases,
+        size_t offset) {
+    bool with_errors = ! errors.empty();
+
+    for (size_t j = 0; j < members.size(); j++) {
+        #pragma omp task shared(unique, members, samples, ground_truth, sums, errors)
+        {
+            int u = members[j];
+            sums[u] = EngineTraits<PopulationType>::squared_error(unique[u],
+                samples, ground_truth,
+                with_errors ? &errors[u * num_cases + offset] : nullptr);
+        }
+    }
+
+    #pragma omp taskwait
+}
 
 /**
- * Translates indices for assigning fitnesses from distributed evaluation.
- * @param  rank               int, rank being considered.
- * @param  index_in_fitnesses int, index in array sent from evaluation.
- * @param  indvs_per_rank     vector<int>, number of individuals sent to each rank.
- * @return                    int, translated index.
+ * Check whether the best individual has reached the target rmse.
+ * Reports the wall time since the start of the run when it has.
+ * @param  population         shared_ptr<PopulationType>, evaluated population.
+ * @param  current_generation int
+ * @return                    bool, true if the run should stop.
  */
-int translate_index(int rank, int index_in_fitnesses,
-        const vector<int> & indvs_per_rank) {
-    // Rank 0 doesn't need to translate.
-    if (rank == 0) {
-        return index_in_fitnesses;
+template <typename PopulationType>
+bool Driver::reached_target(shared_ptr<PopulationType> population,
+        const int & current_generation) {
+    if (this->options.target_rmse < 0) {
+        return false;
     }
-    // Shifts index by how many individuals came before it in the population.
-    else {
-        int previous_indvs = 0;
-        for (int i = rank - 1; i < rank; i++) {
-            previous_indvs += indvs_per_rank[i];
-        }
-        return previous_indvs + index_in_fitnesses;
+
+    // Fitness is rmse plus size, so take the size back off.
+    float best_rmse = HUGE_VALF;
+    for (size_t i = 0; i < population->get_length(); i++) {
+        float rmse = (*population)[i]->get_fitness()
+            - EngineTraits<PopulationType>::size((*population)[i]);
+        best_rmse = std::min(best_rmse, rmse);
+    }
+
+    if (best_rmse <= this->options.target_rmse) {
+        cout << "Reached target rmse " << this->options.target_rmse
+             << " (best " << best_rmse << ") at generation " << current_generation
+             << " after " << omp_get_wtime() - this->run_start_time
+             << " seconds" << endl;
+        return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * Write a checkpoint after the update that led to next_generation, when one
+ * is due or the run was asked to terminate. Due checkpoints are written in
+ * the background, the one on termination before returning.
+ * @param  checkpoint      Checkpoint
+ * @param  population      shared_ptr<PopulationType>, updated population.
+ * @param  next_generation int, generation the population is bred for.
+ * @return                 bool, true if the run should stop.
+ */
+template <typename PopulationType>
+bool Driver::save_checkpoint(Checkpoint & checkpoint,
+        shared_ptr<PopulationType> population, int next_generation) {
+    if (this->options.checkpoint_interval <= 0) {
+        return false;
     }
+
+    bool terminated = Checkpoint::terminated();
+    if (terminated || next_generation % this->options.checkpoint_interval == 0) {
+        checkpoint.save(*population, this->root_engine, next_generation);
+    }
+
+    if (terminated) {
+        checkpoint.wait();
+        cout << "Terminated, checkpoint of generation " << next_generation
+             << " written to " << checkpoint.get_file_name() << endl;
+    }
+    return terminated;
 }
 
 /**
  * Generate random samples for a generation's evaluation.
- * @param samples      vector<float>, size of Evaluation::NUM_SAMPLES
- * @param ground_truth vector<float>, size of Evaluation::NUM_SAMPLES
+ * @param samples      vector<float>, one per sample to draw.
+ * @param ground_truth vector<float>, same size as samples.
  * @param domain       uniform_real_distribution<float>, domain of function.
- * @param engine       mt19937, Meresenne Twister random engine.
+ * @param engine       Philox, the generation's sample stream.
  */
 void Driver::generate_samples(vector<float> & samples,
     vector<float> & ground_truth, shared_ptr<Function> func,
     uniform_real_distribution<float> & domain,
-    mt19937 & engine) {
+    Philox & engine) {
     domain.reset();
-    for (int s = 0; s < Evaluation::NUM_SAMPLES; s++) {
+    for (size_t s = 0; s < samples.size(); s++) {
         samples[s] = domain(engine);
         ground_truth[s] = func->call(samples[s]);
     }
@@ -137,63 +339,92 @@ void Driver::generate_samples(vector<float> & samples,
 /**
  * Evolve with OpenMP only.
  */
+template <typename PopulationType>
 void Driver::evolve_openmp() {
-    // Make and initialize new population.
-    auto population = make_shared<Population>(this->population_size);
-    population->initialize(this->root_engine, 2, 6);
+    typedef EngineTraits<PopulationType> Traits;
+    this->run_start_time = omp_get_wtime();
+
+    // Make and initialize new population, or continue a checkpointed one.
+    auto population = make_shared<PopulationType>(this->population_size,
+        this->options.bloat_control, this->options.selection);
+    Checkpoint checkpoint(this->checkpoint_name, this->options.engine, this->seed,
+        this->function, this->population_size, this->options.num_samples);
+    int first_generation = 0;
+    if (this->options.resume_file.empty()) {
+        population->initialize(this->root_engine, Traits::MIN_INIT, Traits::MAX_INIT);
+    }
+    else if (! checkpoint.load(this->options.resume_file, *population,
+        this->root_engine, first_generation)) {
+        return;
+    }
+    if (this->options.checkpoint_interval > 0) {
+        Checkpoint::watch_terminate();
+    }
+    this->logger->add_column("imbalance");
+    this->logger->add_column("unique_ratio");
+    if (this->options.selection == Selection::PARETO) {
+        this->logger->archive_front();
+    }
     this->logger->initialize();
 
     // Construct the function we're using.
     auto func = FunctionFactory::make_function((FunctionFactory::FunctionType)this->function);
 
-    vector<float> samples(Evaluation::NUM_SAMPLES, 0);
-    vector<float> ground_truth(Evaluation::NUM_SAMPLES, 0);
+    vector<float> samples(this->options.num_samples, 0);
+    vector<float> ground_truth(this->options.num_samples, 0);
 
     // Construct a random distribution over the function's domain.
     auto dom = func->domain();
     uniform_real_distribution<float> domain(dom.first, dom.second);
 
     double start_time;
-    mt19937 gen_engine; // Reseeded each generation.
 
     // Start thread team to avoid creation and destruction at every generation.
     #pragma omp parallel
     #pragma omp single
     {
-        for (int current_generation = 0; current_generation <= this->generations;
-            current_generation++) {
+        for (int current_generation = first_generation;
+            current_generation <= this->generations; current_generation++) {
             // Evaluate each individual in the population.
             // Generate random samples for evaluation.
             // For consistency with the hybrid version we must use a different engine.
-            auto seed = this->root_engine();
-            gen_engine.seed(seed);
+            Philox gen_engine(this->root_engine(), current_generation, 0,
+                Philox::SAMPLE);
 
             this->generate_samples(samples, ground_truth, func, domain, gen_engine);
 
             start_time = omp_get_wtime();
-            this->evaluate_population(population, samples, ground_truth);
+            EvaluationStats stats = this->evaluate_population(population,
+                samples, ground_truth);
 
             // Log results of the evaluation.
             this->logger->log(population, current_generation,
-                omp_get_wtime() - start_time);
+                omp_get_wtime() - start_time, {stats.imbalance, stats.unique_ratio});
+
+            if (this->reached_target(population, current_generation)) {
+                break;
+            }
 
             // Do evolution step: selection, crossover, and mutation.
             population->update(this->root_engine, this->crossover_rate,
                 this->mutation_rate);
+
+            if (this->save_checkpoint(checkpoint, population, current_generation + 1)) {
+                break;
+            }
         }
     }
 }
 
 /**
- * Register incoming and outgoing datatypes.
+ * Register the outgoing datatype.
  * @param Outgoing_DT MPI_Datatype pointer
- * @param Incoming_DT MPI_Datatype pointer
  */
 void register_datatypes(MPI_Datatype * Outgoing_DT) {
-    MPI_Datatype outgoing_types[2] = {MPI_INT, MPI_INT};
+    MPI_Datatype outgoing_types[2] = {MPI_UINT32_T, MPI_INT};
     int block_lengths[2] = {1, 1};
     MPI_Aint outgoing_displacements[2] = {offsetof(OutgoingPayload, seed),
-        offsetof(OutgoingPayload, payload_length)};
+        offsetof(OutgoingPayload, terminate)};
 
     MPI_Type_create_struct(2, block_lengths, outgoing_displacements,
         outgoing_types, Outgoing_DT);
@@ -201,42 +432,225 @@ void register_datatypes(MPI_Datatype * Outgoing_DT) {
 }
 
 /**
- * Make payloads and store relevant information in outgoing pointer.
- * @param  payloads       vector<string>, reverse polish strings to evaluate.
- * @param  indvs_per_rank vector<int>, how many individuals per rank.
- * @param  population     shared_ptr<Population>
- * @param  outgoing       OutgoingPayload, pointer, updated after constructing.
+ * Place results gathered in rank order at their distinct genomes.
+ * @param gathered   float pointer, per_record values for each record, rank order.
+ * @param assignment vector<vector<int>>, indices into unique for each rank.
+ * @param per_record size_t, values per record.
+ * @param unique     vector<float>, per_record values for each distinct genome.
+ */
+void scatter_to_unique(const float * gathered, const vector<vector<int>> & assignment,
+        size_t per_record, vector<float> & unique) {
+    for (size_t i = 0; i < assignment.size(); i++) {
+        for (size_t j = 0; j < assignment[i].size(); j++) {
+            std::copy(gathered, gathered + per_record,
+                unique.begin() + assignment[i][j] * per_record);
+            gathered += per_record;
+        }
+    }
+}
+
+/**
+ * Renumber the distinct genomes so that each rank's share is one range of
+ * indices, ranks in order, and a rank's results can be written straight to
+ * their index. The records each rank gets do not change.
+ * @param assignment vector<vector<int>>, indices into unique for each rank,
+ *                   set to the new indices.
+ * @param unique     vector<GenomeView>, distinct genomes, reordered.
+ * @param groups     vector<size_t>, distinct genome of each individual,
+ *                   renumbered.
  */
-void make_payloads(vector<string> & payloads, const vector<int> & indvs_per_rank,
-    shared_ptr<Population> population, OutgoingPayload * outgoing,
-    mt19937 & root_engine) {
-    int max_payload_length = 0;
-    int previous_start = 0;
+void make_contiguous(vector<vector<int>> & assignment, vector<GenomeView> & unique,
+        vector<size_t> & groups) {
+    vector<size_t> renumber(unique.size());
+    vector<GenomeView> ordered;
+    ordered.reserve(unique.size());
+
+    for (vector<int> & share : assignment) {
+        for (int & u : share) {
+            renumber[u] = ordered.size();
+            ordered.push_back(unique[u]);
+            u = renumber[u];
+        }
+    }
 
-    // Build the strings to send to each rank.
-    for (int i = 0; i < indvs_per_rank.size(); i++) {
-        string payload = "";
+    unique.swap(ordered);
+    for (size_t & group : groups) {
+        group = renumber[group];
+    }
+}
 
-        //
-        // Each payload is a comma seperated string that contains
-        // each reverse polish string that must be evaluated.
-        //
-        for (int j = 0; j < indvs_per_rank[i]; j++) {
-            payload += (*population)[j + previous_start]->get_tree()->get_rpn_string() + ",";
+const int CHUNK_TAG = 4;  // Master to worker, records of a chunk.
+const int RESULT_TAG = 5; // Worker to master, results of the last chunk.
+
+/**
+ * Results of a chunk: its fitnesses, then its errors when lexicase is on.
+ * @param results    float pointer
+ * @param order      vector<Index>, distinct genome of each position.
+ * @param begin      size_t, first position of the chunk in order.
+ * @param end        size_t, one past the last position.
+ * @param num_cases  size_t, errors per record, 0 for none.
+ * @param fitnesses  vector<float>, fitness of each distinct genome.
+ * @param errors     vector<float>, num_cases errors per distinct genome.
+ */
+template <typename Index>
+void store_chunk(const float * results, const vector<Index> & order,
+        size_t begin, size_t end, size_t num_cases, vector<float> & fitnesses,
+        vector<float> & errors) {
+    const float * chunk_errors = results + (end - begin);
+
+    for (size_t k = begin; k < end; k++) {
+        fitnesses[order[k]] = results[k - begin];
+        if (num_cases > 0) {
+            std::copy(chunk_errors + (k - begin) * num_cases,
+                chunk_errors + (k - begin + 1) * num_cases,
+                errors.begin() + order[k] * num_cases);
         }
+    }
+}
 
-        // cout << "Payload length: " << payload.length() << endl;
+/**
+ * Master side of the work queue. Every result a worker returns is answered
+ * with its next chunk, or an empty one once the queue has run dry. While
+ * nobody is waiting the master evaluates a chunk itself.
+ * @param  queue        WorkQueue, reset with the costs of unique.
+ * @param  unique       vector<GenomeView>, distinct genomes.
+ * @param  size         int, number of ranks.
+ * @param  samples      vector<float>, random samples from domain
+ * @param  ground_truth vector<float>, function applied to samples
+ * @param  lexicase     bool, also collect the errors.
+ * @param  fitnesses    vector<float>, set to the fitness of each distinct genome.
+ * @param  errors       vector<float>, set to the errors of each distinct
+ *                      genome, lexicase only.
+ * @param  exchange     Exchange, counts the traffic.
+ * @return              double, time the master spent evaluating.
+ */
+template <typename PopulationType>
+double serve_chunks(WorkQueue & queue, const vector<GenomeView> & unique, int size,
+        const vector<float> & samples, const vector<float> & ground_truth,
+        bool lexicase, vector<float> & fitnesses, vector<float> & errors,
+        Exchange & exchange) {
+    const size_t num_cases = lexicase ? samples.size() : 0;
+    const vector<size_t> & order = queue.get_order();
+    fitnesses.assign(unique.size(), 0);
+    errors.assign(unique.size() * num_cases, 0);
+
+    vector<std::pair<size_t, size_t>> held(size); // Chunk each worker holds.
+    vector<uint8_t> chunk;
+    vector<float> results;
+    int active = size - 1; // Workers not yet sent an empty chunk.
+    double eval_time = 0;
+
+    while (active > 0 || ! queue.empty()) {
+        MPI_Status status;
+        int waiting = 0;
+        MPI_Iprobe(MPI_ANY_SOURCE, RESULT_TAG, MPI_COMM_WORLD, &waiting, &status);
+        if (! waiting && queue.empty()) {
+            MPI_Probe(MPI_ANY_SOURCE, RESULT_TAG, MPI_COMM_WORLD, &status);
+            waiting = 1;
+        }
 
-        if (payload.length() > max_payload_length) {
-            max_payload_length = payload.length();
+        size_t begin = 0, end = 0;
+        if (waiting) {
+            int worker = status.MPI_SOURCE, count;
+            double comm_start = omp_get_wtime();
+            MPI_Get_count(&status, MPI_FLOAT, &count);
+            results.resize(count);
+            MPI_Recv(results.data(), count, MPI_FLOAT, worker, RESULT_TAG,
+                MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            store_chunk(results.data(), order, held[worker].first,
+                held[worker].second, num_cases, fitnesses, errors);
+
+            chunk.clear();
+            GenomeWriter writer(chunk);
+            if (queue.next(begin, end)) {
+                for (size_t k = begin; k < end; k++) {
+                    writer.write_raw(unique[order[k]]);
+                }
+            }
+            else {
+                active--;
+            }
+            held[worker] = std::make_pair(begin, end);
+
+            MPI_Send(chunk.data(), chunk.size(), MPI_BYTE, worker, CHUNK_TAG,
+                MPI_COMM_WORLD);
+            exchange.add(sizeof(float) * (double)count + chunk.size(),
+                omp_get_wtime() - comm_start);
+        }
+        else {
+            // Nobody is waiting, the master takes a chunk itself.
+            queue.next(begin, end);
+            vector<GenomeView> group(end - begin);
+            for (size_t k = begin; k < end; k++) {
+                group[k - begin] = unique[order[k]];
+            }
+
+            vector<float> chunk_fitnesses(group.size(), 0);
+            vector<float> chunk_errors(group.size() * num_cases, 0);
+            double eval_start = omp_get_wtime();
+            evaluate_group_encoded<PopulationType>(group, samples, ground_truth,
+                chunk_fitnesses, chunk_errors);
+            eval_time += omp_get_wtime() - eval_start;
+
+            chunk_fitnesses.insert(chunk_fitnesses.end(), chunk_errors.begin(),
+                chunk_errors.end());
+            store_chunk(chunk_fitnesses.data(), order, begin, end, num_cases,
+                fitnesses, errors);
         }
-        payloads[i] = payload + '\0';
-        previous_start += indvs_per_rank[i];
     }
 
-    outgoing->seed = root_engine(); // Make a random seed to send to each rank.
-    outgoing->payload_length = max_payload_length + 1; // Each rank allocates enough space for the largest payload.
+    return eval_time;
+}
+
+/**
+ * Worker side of the work queue: return the results of the last chunk
+ * (nothing the first time) and evaluate the next, until an empty chunk.
+ * @param  master       int, rank of the master.
+ * @param  samples      vector<float>, random samples from domain
+ * @param  ground_truth vector<float>, function applied to samples
+ * @param  lexicase     bool, also return the errors.
+ * @return              double, time spent evaluating.
+ */
+template <typename PopulationType>
+double evaluate_chunks(int master, const vector<float> & samples,
+        const vector<float> & ground_truth, bool lexicase) {
+    const size_t num_cases = samples.size();
+    vector<float> results;
+    vector<uint8_t> chunk;
+    double eval_time = 0;
+
+    while (true) {
+        MPI_Send(results.data(), results.size(), MPI_FLOAT, master, RESULT_TAG,
+            MPI_COMM_WORLD);
+
+        MPI_Status status;
+        int length;
+        MPI_Probe(master, CHUNK_TAG, MPI_COMM_WORLD, &status);
+        MPI_Get_count(&status, MPI_BYTE, &length);
+        chunk.resize(length);
+        MPI_Recv(chunk.data(), length, MPI_BYTE, master, CHUNK_TAG,
+            MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+        if (length == 0) {
+            return eval_time;
+        }
 
+        GenomeReader reader(chunk.data(), chunk.size());
+        vector<GenomeView> group;
+        GenomeView genome;
+        while (reader.next(genome)) {
+            group.push_back(genome);
+        }
+
+        vector<float> errors(lexicase ? group.size() * num_cases : 0, 0);
+        results.assign(group.size(), 0);
+        double eval_start = omp_get_wtime();
+        evaluate_group_encoded<PopulationType>(group, samples, ground_truth,
+            results, errors);
+        eval_time += omp_get_wtime() - eval_start;
+
+        results.insert(results.end(), errors.begin(), errors.end());
+    }
 }
 
 /**
@@ -244,130 +658,1113 @@ void make_payloads(vector<string> & payloads, const vector<int> & indvs_per_rank
  * @param rank int, process rank.
  * @param size int, number of ranks.
  */
+template <typename PopulationType>
 void Driver::evolve_hybrid(const int & rank, const int & size) {
+    typedef EngineTraits<PopulationType> Traits;
+    this->run_start_time = omp_get_wtime();
+
     MPI_Datatype Outgoing_DT;
     register_datatypes(&Outgoing_DT);
 
-    const int MASTER_TO_SLAVE_TAG = 0;
-    const int SLAVE_TO_MASTER_TAG = 1;
-
-    mt19937 gen_engine; // Each rank has an engine to generate samples.
-                        // This will be seeded each evaluation for consistency.
-
     // Make sure everyone has the function we're using.
     auto func = FunctionFactory::make_function((FunctionFactory::FunctionType)this->function);
 
     // Initialize space for the samples and ground truth on each rank.
-    vector<float> samples(Evaluation::NUM_SAMPLES, 0);
-    vector<float> ground_truth(Evaluation::NUM_SAMPLES, 0);
+    vector<float> samples(this->options.num_samples, 0);
+    vector<float> ground_truth(this->options.num_samples, 0);
 
     // Construct a random distribution over the function's domain on each rank.
     auto dom = func->domain();
     uniform_real_distribution<float> domain(dom.first, dom.second);
 
-    vector<int> indvs_per_rank(size, this->population_size / size);
-    vector<string> payloads(size);
-    shared_ptr<Population> population;
+    vector<vector<int>> assignment(size); // Distinct genomes sent to each rank.
+    Exchange exchange(rank, size, this->MASTER);
+    exchange.set_chunks(this->options.pipeline_chunks);
+    if (this->options.share_nodes) {
+        exchange.share_nodes();
+        if (rank == this->MASTER) {
+            cout << "Sharing memory on " << exchange.get_num_nodes() << " nodes"
+                 << endl;
+        }
+    }
+    const size_t num_cases = this->options.num_samples;
+    bool lexicase = this->options.selection == Selection::LEXICASE;
+    // Fitnesses of at most every individual, then their errors.
+    if (this->options.put_results) {
+        exchange.open_window(this->population_size * (1 + (lexicase ? num_cases : 0)));
+    }
+    // The static split goes to nodes, their ranks split it again locally.
+    bool by_node = this->options.share_nodes;
+    vector<uint8_t> encoded;              // Every genome of the population.
+    vector<GenomeView> unique;            // Distinct genomes, views into encoded.
+    vector<double> costs;                 // Estimated cost of each distinct genome.
+    vector<size_t> groups;                // Distinct genome of each individual.
+    size_t num_unique = 0;                // Number of distinct genomes sent.
+    vector<double> rank_times(size, 0);   // Evaluation time of each rank.
+    vector<double> rank_timing(2 * size, 0); // Evaluation time and span of each rank.
+    WorkQueue queue(size);                // Distinct genomes not yet handed out.
+    shared_ptr<PopulationType> population;
+    vector<float> errors;                 // Errors of this rank's records, lexicase only.
+    vector<float> unique_fitnesses;       // Master, fitness of each distinct genome.
+    vector<float> unique_errors;          // Master, errors of each distinct genome.
+    const float * fitness_of;             // Master, where the fitnesses ended up.
+    const float * errors_of;
+    bool stop = false; // Set on the master once the target is reached.
+
+    // Every rank can build any part of the initial population from this seed.
+    uint64_t init_seed = 0;
+    if (rank == this->MASTER) {
+        init_seed = this->root_engine();
+        init_seed = (init_seed << 32) | this->root_engine();
+    }
+    MPI_Bcast(&init_seed, 1, MPI_UINT64_T, this->MASTER, MPI_COMM_WORLD);
 
-    // Only initialize the population on the master rank.
+    Checkpoint checkpoint(this->checkpoint_name, this->options.engine, this->seed,
+        this->function, this->population_size, this->options.num_samples);
+    int first_generation = 0;
+
+    // Only the master holds the whole population.
     if (rank == this->MASTER) {
+        this->logger->add_column("imbalance");
+        this->logger->add_column("unique_ratio");
+        this->logger->add_column("comm_bytes");
+        this->logger->add_column("comm_time");
+        for (int i = 0; i < size; i++) {
+            this->logger->add_column("idle_" + std::to_string(i));
+        }
+        if (this->options.selection == Selection::PARETO) {
+            this->logger->archive_front();
+        }
         this->logger->initialize();
 
-        population = make_shared<Population>(this->population_size);
-        population->initialize(this->root_engine, 2, 6);
+        population = make_shared<PopulationType>(this->population_size,
+            this->options.bloat_control, this->options.selection);
+        if (this->options.resume_file.empty()) {
+            population->initialize_shard(init_seed, Traits::MIN_INIT,
+                Traits::MAX_INIT, 0, 1);
+        }
+        else if (! checkpoint.load(this->options.resume_file, *population,
+            this->root_engine, first_generation)) {
+            first_generation = -1;
+        }
+    }
+    // Workers only follow the master's terminate flag, but must survive the
+    // signal too.
+    if (this->options.checkpoint_interval > 0) {
+        Checkpoint::watch_terminate();
+    }
 
-        // Determine how many individuals each rank gets.
-        int remainder = this->population_size % size;
-        for (int i = 0; i < size && remainder > 0; i++) {
-            indvs_per_rank[i]++;
-            remainder--;
+    // Everyone continues from the master's checkpoint.
+    if (! this->options.resume_file.empty()) {
+        MPI_Bcast(&first_generation, 1, MPI_INT, this->MASTER, MPI_COMM_WORLD);
+        if (first_generation < 0) {
+            MPI_Type_free(&Outgoing_DT);
+            return;
+        }
+    }
 
+    // The initial population is never sent, each rank builds and evaluates
+    // the strided shard rank, rank + size, ... itself. Striding spreads the
+    // depth ramp evenly over the ranks.
+    vector<uint8_t> initial_records;
+    if (first_generation == 0) {
+        PopulationType shard(this->population_size);
+        shard.initialize_shard(init_seed, Traits::MIN_INIT, Traits::MAX_INIT,
+            rank, size);
+
+        GenomeWriter writer(initial_records);
+        for (size_t k = 0; k < shard.get_length(); k++) {
+            Traits::encode(shard[k], writer);
         }
     }
+
     OutgoingPayload outgoing; // Root's outgoing payload.
 
-    string current_val; // Temp variable.
     double start_time;
 
     #pragma omp parallel
     #pragma omp single
     {
-        for (int current_generation = 0; current_generation <= this->generations;
-            current_generation++) {
+        for (int current_generation = first_generation;
+            current_generation <= this->generations; current_generation++) {
+
+            exchange.reset_stats();
 
             // Only the master process performs the main evolution loop.
             if (rank == this->MASTER) {
-                make_payloads(payloads, indvs_per_rank, population, &outgoing,
-                              this->root_engine);
-            }
+                if (! stop && current_generation == 0) {
+                    // Ranks evaluate their own shards, as built above.
+                    for (int i = 0; i < size; i++) {
+                        assignment[i].clear();
+                        for (int j = i; j < this->population_size; j += size) {
+                            assignment[i].push_back(j);
+                        }
+                    }
 
-            MPI_Bcast(&outgoing, 1, Outgoing_DT, this->MASTER, MPI_COMM_WORLD);
+                    groups.resize(this->population_size);
+                    std::iota(groups.begin(), groups.end(), 0);
+                    num_unique = this->population_size;
 
-            // Allocate space for the string to evaluate.
-            char string_to_eval[outgoing.payload_length];
+                    outgoing.seed = this->root_engine();
+                }
+                else if (! stop) {
+                    // Only distinct genomes are sent, split by estimated cost.
+                    groups = encode_unique(population, this->options.num_samples,
+                        encoded, unique, costs);
+                    num_unique = unique.size();
+                    if (this->options.work_queue) {
+                        queue.reset(costs);
+                    }
+                    else {
+                        if (by_node) {
+                            Balance::partition(costs, exchange.get_node_sizes(),
+                                assignment);
+                        }
+                        else {
+                            Balance::partition(costs, size, assignment);
+                        }
+                        if (this->options.put_results) {
+                            make_contiguous(assignment, unique, groups);
+                        }
+                        exchange.pack(assignment, unique);
+                    }
+                    outgoing.seed = this->root_engine();
+                }
+                outgoing.terminate = stop;
+            }
 
-            MPI_Request ignore;
             if (rank == this->MASTER) {
-                // Send out all the strings (even to self)
                 start_time = omp_get_wtime();
-                for (int i = 0; i < size; i++) {
-                    // cout << "Rank " << i << " gets payload with length " << payloads[i].length() << " (" << indvs_per_rank[i] << " individuals)" << endl;
-                    MPI_Isend(payloads[i].c_str(), payloads[i].length(), MPI_CHAR, i, MASTER_TO_SLAVE_TAG, MPI_COMM_WORLD, &ignore);
-                }
             }
 
-            // cout << "Recieving evaluation string on rank " << rank << endl;
-            MPI_Recv(string_to_eval, outgoing.payload_length, MPI_CHAR, this->MASTER, MASTER_TO_SLAVE_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            exchange.broadcast(&outgoing, 1, Outgoing_DT);
 
-            string evaluate_me(string_to_eval);
-            std::stringstream ss(string_to_eval);
-            vector<string> group;
+            if (outgoing.terminate) {
+                break;
+            }
 
-            gen_engine.seed(outgoing.seed);
+            // Every rank opens the same sample stream from the broadcast seed.
+            Philox gen_engine(outgoing.seed, current_generation, 0,
+                Philox::SAMPLE);
 
             this->generate_samples(samples, ground_truth, func, domain, gen_engine);
 
-            // Evaluate all the RPN strings.
-            while(getline(ss, current_val, ',')) {
-                group.push_back(current_val);
+            bool queued = this->options.work_queue && current_generation > 0;
+            bool streamed = ! queued && exchange.get_chunks() > 1
+                && current_generation > 0;
+            bool put = this->options.put_results && ! queued && ! streamed;
+            bool hierarchical = by_node && current_generation > 0;
+            size_t per_record = 1 + (lexicase ? num_cases : 0);
+            vector<float> fitnesses;   // This rank's results, static split only.
+            double phase_start = omp_get_wtime();
+            double eval_time = 0;
+
+            if (queued && rank == this->MASTER) {
+                eval_time = serve_chunks<PopulationType>(queue, unique, size,
+                    samples, ground_truth, lexicase, unique_fitnesses,
+                    unique_errors, exchange);
+            }
+            else if (queued) {
+                eval_time = evaluate_chunks<PopulationType>(this->MASTER,
+                    samples, ground_truth, lexicase);
             }
+            else if (streamed) {
+                // Each chunk is evaluated as soon as it lands and its results
+                // go straight back, the master evaluates its own in between.
+                if (rank == this->MASTER) {
+                    unique_fitnesses.assign(num_unique, 0);
+                    unique_errors.assign(lexicase ? num_unique * num_cases : 0, 0);
+                }
+                exchange.stream(assignment, per_record);
+
+                for (int c = 0; c < exchange.get_chunks(); c++) {
+                    int length;
+                    const uint8_t * records = exchange.chunk(c, length);
+                    GenomeReader reader(records, length);
+                    vector<GenomeView> group;
+                    GenomeView genome;
+                    while (reader.next(genome)) {
+                        group.push_back(genome);
+                    }
 
-            vector<float> fitnesses(group.size(), 0);
-            evaluate_group_strings(group, samples, ground_truth, fitnesses);
+                    vector<float> results(group.size(), 0);
+                    errors.assign(lexicase ? group.size() * num_cases : 0, 0);
+                    double eval_start = omp_get_wtime();
+                    evaluate_group_encoded<PopulationType>(group, samples,
+                        ground_truth, results, errors);
+                    eval_time += omp_get_wtime() - eval_start;
+                    results.insert(results.end(), errors.begin(), errors.end());
+
+                    if (rank == this->MASTER) {
+                        size_t begin, end;
+                        Exchange::chunk_range(assignment[rank].size(), c,
+                            exchange.get_chunks(), begin, end);
+                        store_chunk(results.data(), assignment[rank], begin, end,
+                            per_record - 1, unique_fitnesses, unique_errors);
+                    }
+                    else {
+                        exchange.send_results(c, results);
+                    }
+                }
 
-            // for (int i = 0; i < fitnesses.size(); i++) {
-            //     cout << "(Rank " << rank << "): fitnesses[" << i << "] = " << fitnesses[i] << endl;
-            // }
+                // Other ranks' chunks are stored in the order they complete.
+                int source, c;
+                const float * results;
+                while (rank == this->MASTER && exchange.collect(source, c, results)) {
+                    size_t begin, end;
+                    Exchange::chunk_range(assignment[source].size(), c,
+                        exchange.get_chunks(), begin, end);
+                    store_chunk(results, assignment[source], begin, end,
+                        per_record - 1, unique_fitnesses, unique_errors);
+                }
+                exchange.finish();
+            }
+            else if (hierarchical) {
+                // The node's ranks split its records by size, every rank
+                // finds the same split, and write results at record index.
+                int received;
+                const uint8_t * records = exchange.scatter_nodes(received);
+                GenomeReader reader(records, received);
+                vector<GenomeView> node_records;
+                vector<double> node_costs;
+                GenomeView genome;
+                while (reader.next(genome)) {
+                    node_records.push_back(genome);
+                    node_costs.push_back(genome.length);
+                }
 
-            // cout << "Rank " << rank << " sending " << fitnesses.size() << " fitnesses" << endl;
-            MPI_Isend(&fitnesses[0], fitnesses.size(), MPI_FLOAT, this->MASTER, SLAVE_TO_MASTER_TAG, MPI_COMM_WORLD, &ignore);
+                vector<vector<int>> local;
+                Balance::partition(node_costs, exchange.get_node_size(), local);
+                const vector<int> & mine = local[exchange.get_node_rank()];
+                vector<GenomeView> group(mine.size());
+                for (size_t j = 0; j < mine.size(); j++) {
+                    group[j] = node_records[mine[j]];
+                }
 
-            if (rank == this->MASTER) {
-                for (int i = 0; i < size; i++) {
-                    float fits_from_rank[indvs_per_rank[i]];
+                fitnesses.assign(group.size(), 0);
+                errors.assign(lexicase ? group.size() * num_cases : 0, 0);
+                double eval_start = omp_get_wtime();
+                evaluate_group_encoded<PopulationType>(group, samples, ground_truth,
+                    fitnesses, errors);
+                eval_time = omp_get_wtime() - eval_start;
+
+                // Every fitness of the node, then every error row.
+                size_t node_length = node_records.size();
+                float * results = exchange.node_results(node_length * per_record);
+                for (size_t j = 0; j < mine.size(); j++) {
+                    results[mine[j]] = fitnesses[j];
+                    std::copy(errors.begin() + j * (per_record - 1),
+                        errors.begin() + (j + 1) * (per_record - 1),
+                        results + node_length + mine[j] * (per_record - 1));
+                }
 
-                    // cout << "Recieving " << indvs_per_rank[i] <<  " fitnesses from rank " << i << endl;
+                if (put) {
+                    exchange.put_nodes(node_length, per_record - 1,
+                        this->population_size);
+                }
+            }
+            else {
+                // Generation 0 evaluates the shard built above, afterwards
+                // each rank gets its slice of the packed records.
+                const uint8_t * records = initial_records.data();
+                int received = initial_records.size();
+                if (current_generation > 0) {
+                    records = exchange.scatter(received);
+                }
+
+                // Walk the records in place, nothing is copied or parsed.
+                GenomeReader reader(records, received);
+                vector<GenomeView> group;
+                GenomeView genome;
+                while (reader.next(genome)) {
+                    group.push_back(genome);
+                }
 
-                    MPI_Recv(fits_from_rank, indvs_per_rank[i], MPI_FLOAT, i, SLAVE_TO_MASTER_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                fitnesses.assign(group.size(), 0);
+                errors.assign(lexicase ? group.size() * num_cases : 0, 0);
+                double eval_start = omp_get_wtime();
+                evaluate_group_encoded<PopulationType>(group, samples, ground_truth,
+                    fitnesses, errors);
+                eval_time = omp_get_wtime() - eval_start;
 
-                    for (int j = 0; j < indvs_per_rank[i]; j++) {
-                        (*population)[translate_index(i, j, indvs_per_rank)]
-                            ->set_fitness(fits_from_rank[j]);
+                if (current_generation == 0) {
+                    vector<uint8_t>().swap(initial_records);
+                }
+
+                // Results go straight to their distinct genome on the master:
+                // the strided shard in generation 0, a contiguous range after.
+                if (put) {
+                    size_t first = rank, stride = size;
+                    if (current_generation > 0) {
+                        first = exchange.record_offset(fitnesses.size());
+                        stride = 1;
+                    }
+                    exchange.put(fitnesses.data(), fitnesses.size(), 1, 0, first,
+                        stride);
+                    if (lexicase) {
+                        exchange.put(errors.data(), fitnesses.size(), num_cases,
+                            this->population_size, first, stride);
                     }
+                    exchange.flush();
+                }
+            }
+
+            // The master reports how evenly the evaluation time was spread
+            // and how long each rank sat idle. This also waits for the
+            // slowest rank, so the gathers below time communication alone.
+            double timing[2] = {eval_time, omp_get_wtime() - phase_start};
+            MPI_Gather(timing, 2, MPI_DOUBLE, rank_timing.data(), 2, MPI_DOUBLE,
+                this->MASTER, MPI_COMM_WORLD);
+
+            if (put) {
+                if (rank == this->MASTER) {
+                    const float * window = exchange.exposed(num_unique
+                        * (1 + (lexicase ? num_cases : 0)));
+                    fitness_of = window;
+                    errors_of = window + this->population_size;
+                }
+            }
+            else if (hierarchical) {
+                const float * gathered = exchange.gather_nodes(assignment, per_record);
+                if (rank == this->MASTER) {
+                    unique_fitnesses.assign(num_unique, 0);
+                    unique_errors.assign(lexicase ? num_unique * num_cases : 0, 0);
+                    for (size_t n = 0; n < assignment.size(); n++) {
+                        store_chunk(gathered, assignment[n], 0, assignment[n].size(),
+                            per_record - 1, unique_fitnesses, unique_errors);
+                        gathered += assignment[n].size() * per_record;
+                    }
+                }
+            }
+            else if (! queued && ! streamed) {
+                const float * gathered = exchange.gather(fitnesses, assignment, 1);
+                if (rank == this->MASTER) {
+                    unique_fitnesses.resize(num_unique);
+                    scatter_to_unique(gathered, assignment, 1, unique_fitnesses);
+                }
+
+                // Lexicase needs every error too.
+                if (lexicase) {
+                    gathered = exchange.gather(errors, assignment, num_cases);
+                }
+                if (lexicase && rank == this->MASTER) {
+                    unique_errors.resize(num_unique * num_cases);
+                    scatter_to_unique(gathered, assignment, num_cases, unique_errors);
+                }
+            }
+
+            if (rank == this->MASTER && ! put) {
+                fitness_of = unique_fitnesses.data();
+                errors_of = unique_errors.data();
+            }
+
+            if (rank == this->MASTER) {
+                for (size_t i = 0; i < population->get_length(); i++) {
+                    (*population)[i]->set_fitness(fitness_of[groups[i]]);
+                }
+
+                if (lexicase) {
+                    vector<float> case_errors = case_major(errors_of, groups,
+                        num_cases);
+                    population->set_case_errors(case_errors, num_cases);
+                }
+
+                // Idle is the time to the last rank finishing, less evaluation.
+                double span = 0;
+                for (int i = 0; i < size; i++) {
+                    rank_times[i] = rank_timing[2 * i];
+                    span = std::max(span, rank_timing[2 * i + 1]);
+                }
+                vector<double> extra = {Balance::imbalance(rank_times),
+                    num_unique / (double)population->get_length(),
+                    exchange.get_bytes(), exchange.get_time()};
+                for (int i = 0; i < size; i++) {
+                    extra.push_back(span - rank_times[i]);
                 }
 
                 // Log results of evaluation and do population update.
                 this->logger->log(population, current_generation,
-                    omp_get_wtime() - start_time);
+                    omp_get_wtime() - start_time, extra);
+
+                stop = this->reached_target(population, current_generation);
 
                 // Do evolution step.
                 population->update(this->root_engine, this->crossover_rate,
                     this->mutation_rate);
+
+                // Stopping is broadcast with the next generation's payload.
+                if (! stop && this->save_checkpoint(checkpoint, population,
+                    current_generation + 1)) {
+                    stop = true;
+                }
             }
         }
     }
 }
 
+/**
+ * Evolve with OpenMP and MPI, every rank keeping a replica of the population.
+ * Ranks start from the same seed and breed with the same random streams, so
+ * their populations stay identical without any genome being sent. Each rank
+ * evaluates its share of the distinct genomes and the fitnesses are shared
+ * with one MPI_Allgatherv, O(population) floats per generation.
+ *
+ * With shard_samples the ranks form a grid of individual blocks by sample
+ * shards instead (see Decomposition), each rank sums squared errors of its
+ * block on its shard and one MPI_Allreduce adds up the partial sums.
+ * @param rank int, process rank.
+ * @param size int, number of ranks.
+ */
+template <typename PopulationType>
+void Driver::evolve_replica(const int & rank, const int & size) {
+    typedef EngineTraits<PopulationType> Traits;
+    this->run_start_time = omp_get_wtime();
+
+    auto population = make_shared<PopulationType>(this->population_size,
+        this->options.bloat_control, this->options.selection);
+    population->initialize(this->root_engine, Traits::MIN_INIT, Traits::MAX_INIT);
+
+    if (rank == this->MASTER) {
+        this->logger->add_column("imbalance");
+        this->logger->add_column("unique_ratio");
+        this->logger->add_column("comm_bytes");
+        this->logger->add_column("comm_time");
+        if (this->options.selection == Selection::PARETO) {
+            this->logger->archive_front();
+        }
+        this->logger->initialize();
+    }
+
+    auto func = FunctionFactory::make_function((FunctionFactory::FunctionType)this->function);
+
+    vector<float> samples(this->options.num_samples, 0);
+    vector<float> ground_truth(this->options.num_samples, 0);
+
+    auto dom = func->domain();
+    uniform_real_distribution<float> domain(dom.first, dom.second);
+
+    Exchange exchange(rank, size, this->MASTER);
+    Decomposition grid;
+    grid.individual_blocks = size;
+    if (this->options.shard_samples) {
+        grid = Decomposition::choose(this->population_size,
+            this->options.num_samples, size);
+        if (rank == this->MASTER) {
+            cout << "Decomposition: " << grid.individual_blocks
+                 << " individual blocks by " << grid.sample_shards
+                 << " sample shards" << endl;
+        }
+    }
+    int block = rank / grid.sample_shards;
+    int shard = rank % grid.sample_shards;
+    size_t shard_begin, shard_end;
+    Decomposition::shard_range(this->options.num_samples, shard,
+        grid.sample_shards, shard_begin, shard_end);
+    vector<float> shard_samples(shard_end - shard_begin, 0);
+    vector<float> shard_truth(shard_end - shard_begin, 0);
+
+    vector<vector<int>> assignment(grid.individual_blocks); // Distinct genomes of each block.
+    vector<uint8_t> encoded;              // Every genome of the population.
+    vector<GenomeView> unique;            // Distinct genomes, views into encoded.
+    vector<double> costs;                 // Estimated cost of each distinct genome.
+    vector<double> rank_times(size, 0);   // Evaluation time of each rank.
+    bool lexicase = this->options.selection == Selection::LEXICASE;
+    const size_t num_cases = this->options.num_samples;
+    vector<float> errors;                 // Errors of this rank's genomes, lexicase only.
+
+    double start_time;
+
+    #pragma omp parallel
+    #pragma omp single
+    {
+        for (int current_generation = 0; current_generation <= this->generations;
+            current_generation++) {
+            exchange.reset_stats();
+
+            // Same stream as the OpenMP run, drawn on every rank.
+            Philox gen_engine(this->root_engine(), current_generation, 0,
+                Philox::SAMPLE);
+
+            this->generate_samples(samples, ground_truth, func, domain, gen_engine);
+
+            start_time = omp_get_wtime();
+
+            // Every rank finds the same distinct genomes and the same split.
+            vector<size_t> groups = encode_unique(population, num_cases, encoded,
+                unique, costs);
+            Balance::partition(costs, grid.individual_blocks, assignment);
+
+            if (this->options.shard_samples) {
+                std::copy(samples.begin() + shard_begin, samples.begin() + shard_end,
+                    shard_samples.begin());
+                std::copy(ground_truth.begin() + shard_begin,
+                    ground_truth.begin() + shard_end, shard_truth.begin());
+
+                // Zero outside this rank's block and shard, so the sum over
+                // every rank is the sum over every sample.
+                vector<float> sums(unique.size(), 0);
+                errors.assign(lexicase ? unique.size() * num_cases : 0, 0);
+                double eval_start = omp_get_wtime();
+                evaluate_shard<PopulationType>(unique, assignment[block],
+                    shard_samples, shard_truth, sums, errors, num_cases,
+                    shard_begin);
+                double eval_time = omp_get_wtime() - eval_start;
+
+                MPI_Gather(&eval_time, 1, MPI_DOUBLE, rank_times.data(), 1,
+                    MPI_DOUBLE, this->MASTER, MPI_COMM_WORLD);
+
+                exchange.all_reduce(sums);
+                for (size_t i = 0; i < population->get_length(); i++) {
+                    (*population)[i]->set_fitness(sqrt(sums[groups[i]] / num_cases)
+                        + Traits::size((*population)[i]));
+                }
+
+                if (lexicase) {
+                    exchange.all_reduce(errors);
+                    vector<float> case_errors = case_major(errors.data(), groups,
+                        num_cases);
+                    population->set_case_errors(case_errors, num_cases);
+                }
+            }
+            else {
+                vector<GenomeView> group(assignment[rank].size());
+                for (size_t j = 0; j < group.size(); j++) {
+                    group[j] = unique[assignment[rank][j]];
+                }
+
+                vector<float> fitnesses(group.size(), 0);
+                errors.assign(lexicase ? group.size() * num_cases : 0, 0);
+                double eval_start = omp_get_wtime();
+                evaluate_group_encoded<PopulationType>(group, samples, ground_truth,
+                    fitnesses, errors);
+                double eval_time = omp_get_wtime() - eval_start;
+
+                // Waits for the slowest rank, so the exchange below times
+                // communication alone.
+                MPI_Gather(&eval_time, 1, MPI_DOUBLE, rank_times.data(), 1,
+                    MPI_DOUBLE, this->MASTER, MPI_COMM_WORLD);
+
+                vector<float> unique_fitnesses(unique.size());
+                scatter_to_unique(exchange.all_gather(fitnesses, assignment, 1),
+                    assignment, 1, unique_fitnesses);
+
+                for (size_t i = 0; i < population->get_length(); i++) {
+                    (*population)[i]->set_fitness(unique_fitnesses[groups[i]]);
+                }
+
+                if (lexicase) {
+                    vector<float> unique_errors(unique.size() * num_cases);
+                    scatter_to_unique(exchange.all_gather(errors, assignment,
+                        num_cases), assignment, num_cases, unique_errors);
+
+                    vector<float> case_errors = case_major(unique_errors.data(), groups,
+                        num_cases);
+                    population->set_case_errors(case_errors, num_cases);
+                }
+            }
+
+            // The master decides when to stop so only it reports.
+            int stop = 0;
+            if (rank == this->MASTER) {
+                this->logger->log(population, current_generation,
+                    omp_get_wtime() - start_time,
+                    {Balance::imbalance(rank_times),
+                     unique.size() / (double)population->get_length(),
+                     exchange.get_bytes(), exchange.get_time()});
+
+                stop = this->reached_target(population, current_generation);
+            }
+            exchange.broadcast(&stop, 1, MPI_INT);
+
+            if (stop) {
+                break;
+            }
+
+            population->update(this->root_engine, this->crossover_rate,
+                this->mutation_rate);
+        }
+    }
+}
+
+/**
+ * Migrants on their way out, the records live until the send completes.
+ */
+struct Emigrants {
+    vector<uint8_t> records;
+    MPI_Request request;
+};
+
+/**
+ * Evolve with the island model, every rank evolves its own population of
+ * population_size and logs it to its own files. Every migration_interval
+ * generations copies of the best individuals are sent to the neighbours of
+ * the topology without waiting, and migrants that have arrived replace the
+ * worst individuals after the next evaluation. Reaching the target is voted
+ * on with a non-blocking reduction that completes at the next migration, so
+ * islands only ever wait on each other there.
+ * @param rank int, process rank.
+ * @param size int, number of ranks.
+ */
+template <typename PopulationType>
+void Driver::evolve_islands(const int & rank, const int & size) {
+    typedef EngineTraits<PopulationType> Traits;
+    typedef typename Traits::individual_ptr individual_ptr;
+    this->run_start_time = omp_get_wtime();
+
+    const int MIGRATION_TAG = 3;
+
+    // Every island shares the random topology, then gets its own stream.
+    uint64_t migration_seed = this->root_engine();
+    std::seed_seq island_seed = {(uint32_t)this->root_engine(), (uint32_t)rank};
+    this->root_engine.seed(island_seed);
+
+    auto population = make_shared<PopulationType>(this->population_size,
+        this->options.bloat_control, this->options.selection);
+    population->initialize(this->root_engine, Traits::MIN_INIT, Traits::MAX_INIT);
+
+    this->logger->set_island(rank);
+    this->logger->add_column("imbalance");
+    this->logger->add_column("unique_ratio");
+    this->logger->add_column("immigrants");
+    if (this->options.selection == Selection::PARETO) {
+        this->logger->archive_front();
+    }
+    this->logger->initialize();
+
+    auto func = FunctionFactory::make_function((FunctionFactory::FunctionType)this->function);
+
+    vector<float> samples(this->options.num_samples, 0);
+    vector<float> ground_truth(this->options.num_samples, 0);
+
+    auto dom = func->domain();
+    uniform_real_distribution<float> domain(dom.first, dom.second);
+
+    bool lexicase = this->options.selection == Selection::LEXICASE;
+    std::list<Emigrants> outbox;       // Sends not yet complete.
+    vector<int> sent(size, 0);         // Messages sent to each island.
+    vector<int> received(size, 0);     // Messages received from each island.
+    vector<uint8_t> inbox;
+    vector<uint8_t> arrivals;          // Records of migrants not yet in the population.
+    vector<GenomeView> immigrants;
+    vector<float> immigrant_fitnesses, immigrant_errors;
+
+    bool reached = false;              // This island reached the target.
+    int vote = 0, any_reached = 0;     // Buffers of the pending vote.
+    MPI_Request vote_request = MPI_REQUEST_NULL;
+
+    double start_time;
+
+    #pragma omp parallel
+    #pragma omp single
+    {
+        for (int current_generation = 0; current_generation <= this->generations;
+            current_generation++) {
+            Philox gen_engine(this->root_engine(), current_generation, 0,
+                Philox::SAMPLE);
+
+            this->generate_samples(samples, ground_truth, func, domain, gen_engine);
+
+            start_time = omp_get_wtime();
+            EvaluationStats stats = this->evaluate_population(population,
+                samples, ground_truth);
+
+            // Take whatever has arrived, without waiting for anything.
+            int waiting = 1;
+            while (waiting) {
+                MPI_Status status;
+                MPI_Iprobe(MPI_ANY_SOURCE, MIGRATION_TAG, MPI_COMM_WORLD,
+                    &waiting, &status);
+                if (! waiting) {
+                    break;
+                }
+
+                // Records of every message are appended, they need no header.
+                int length;
+                MPI_Get_count(&status, MPI_BYTE, &length);
+                size_t offset = arrivals.size();
+                arrivals.resize(offset + length);
+                MPI_Recv(arrivals.data() + offset, length, MPI_BYTE,
+                    status.MPI_SOURCE, MIGRATION_TAG, MPI_COMM_WORLD,
+                    MPI_STATUS_IGNORE);
+                received[status.MPI_SOURCE]++;
+            }
+
+            immigrants.clear();
+            GenomeReader reader(arrivals.data(), arrivals.size());
+            GenomeView genome;
+            while (reader.next(genome)) {
+                immigrants.push_back(genome);
+            }
+
+            // Migrants replace the worst, scored on this island's samples.
+            // Only they are evaluated, their errors go in the members' place.
+            size_t arrived = std::min(immigrants.size(), population->get_length() / 2);
+            if (arrived > 0) {
+                vector<float> fitnesses(population->get_length());
+                for (size_t i = 0; i < fitnesses.size(); i++) {
+                    fitnesses[i] = (*population)[i]->get_fitness();
+                }
+
+                immigrants.resize(arrived);
+                immigrant_fitnesses.assign(arrived, 0);
+                immigrant_errors.assign(lexicase ? arrived * samples.size() : 0, 0);
+                evaluate_group_encoded<PopulationType>(immigrants, samples,
+                    ground_truth, immigrant_fitnesses, immigrant_errors);
+
+                vector<size_t> worst = Migration::worst(fitnesses, arrived);
+                for (size_t j = 0; j < arrived; j++) {
+                    individual_ptr immigrant = Traits::decode(immigrants[j]);
+                    immigrant->set_fitness(immigrant_fitnesses[j]);
+                    (*population)[worst[j]] = immigrant;
+
+                    if (lexicase) {
+                        population->replace_case_errors(worst[j],
+                            &immigrant_errors[j * samples.size()]);
+                    }
+                }
+            }
+            arrivals.clear();
+
+            this->logger->log(population, current_generation,
+                omp_get_wtime() - start_time,
+                {stats.imbalance, stats.unique_ratio, (double)arrived});
+
+            if (! reached) {
+                reached = this->reached_target(population, current_generation);
+            }
+
+            // Drop the buffers of completed sends.
+            for (auto it = outbox.begin(); it != outbox.end(); ) {
+                int done;
+                MPI_Test(&it->request, &done, MPI_STATUS_IGNORE);
+                it = done ? outbox.erase(it) : std::next(it);
+            }
+
+            if (current_generation > 0
+                && current_generation % this->options.migration_interval == 0) {
+                // The vote from the last migration has had a whole interval.
+                if (vote_request != MPI_REQUEST_NULL) {
+                    MPI_Wait(&vote_request, MPI_STATUS_IGNORE);
+                    if (any_reached) {
+                        break;
+                    }
+                }
+                vote = reached;
+                MPI_Iallreduce(&vote, &any_reached, 1, MPI_INT, MPI_MAX,
+                    MPI_COMM_WORLD, &vote_request);
+
+                vector<float> fitnesses(population->get_length());
+                for (size_t i = 0; i < fitnesses.size(); i++) {
+                    fitnesses[i] = (*population)[i]->get_fitness();
+                }
+
+                vector<size_t> best = Migration::best(fitnesses,
+                    this->options.migrants);
+                vector<int> destinations = Migration::destinations(
+                    this->options.topology, rank, size, migration_seed,
+                    current_generation);
+
+                for (int destination : destinations) {
+                    outbox.emplace_back();
+                    GenomeWriter writer(outbox.back().records);
+                    for (size_t b : best) {
+                        Traits::encode((*population)[b], writer);
+                    }
+
+                    MPI_Isend(outbox.back().records.data(),
+                        outbox.back().records.size(), MPI_BYTE, destination,
+                        MIGRATION_TAG, MPI_COMM_WORLD, &outbox.back().request);
+                    sent[destination]++;
+                }
+            }
+
+            population->update(this->root_engine, this->crossover_rate,
+                this->mutation_rate);
+        }
+    }
+
+    // Finish the vote, then take every migrant still in flight so that all
+    // sends complete.
+    MPI_Wait(&vote_request, MPI_STATUS_IGNORE);
+
+    vector<int> expected(size, 0);
+    MPI_Alltoall(sent.data(), 1, MPI_INT, expected.data(), 1, MPI_INT,
+        MPI_COMM_WORLD);
+
+    for (int source = 0; source < size; source++) {
+        for (; received[source] < expected[source]; received[source]++) {
+            MPI_Status status;
+            int length;
+            MPI_Probe(source, MIGRATION_TAG, MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_BYTE, &length);
+            inbox.resize(length);
+            MPI_Recv(inbox.data(), length, MPI_BYTE, source, MIGRATION_TAG,
+                MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+    }
+
+    for (Emigrants & emigrants : outbox) {
+        MPI_Wait(&emigrants.request, MPI_STATUS_IGNORE);
+    }
+}
+
+/**
+ * Evolve with OpenMP in steady-state mode. Every thread loops on breed,
+ * evaluate and replace with no barrier between individuals, so a large
+ * program only holds up its own thread. Samples are drawn once so that
+ * fitnesses stay comparable across the run. The budget matches the
+ * generational run, and every population_size evaluations are logged as
+ * one generation along with the evaluation rate.
+ */
+template <typename PopulationType>
+void Driver::evolve_steady_state() {
+    typedef EngineTraits<PopulationType> Traits;
+    typedef typename Traits::individual_ptr individual_ptr;
+    this->run_start_time = omp_get_wtime();
+
+    auto population = make_shared<PopulationType>(this->population_size,
+        this->options.bloat_control, this->options.selection);
+    population->initialize(this->root_engine, Traits::MIN_INIT, Traits::MAX_INIT);
+    this->logger->use_evaluation_rate();
+    this->logger->initialize();
+
+    auto func = FunctionFactory::make_function((FunctionFactory::FunctionType)this->function);
+
+    vector<float> samples(this->options.num_samples, 0);
+    vector<float> ground_truth(this->options.num_samples, 0);
+
+    auto dom = func->domain();
+    uniform_real_distribution<float> domain(dom.first, dom.second);
+    Philox sample_engine(this->root_engine(), 0, 0, Philox::SAMPLE);
+    this->generate_samples(samples, ground_truth, func, domain, sample_engine);
+
+    const uint64_t breed_seed = this->root_engine();
+    const long pop = this->population_size;
+    const long budget = (long)this->generations * pop;
+    long issued = 0;    // Children handed out to threads.
+    long completed = 0; // Children evaluated and inserted.
+    long logged = 0;    // Generations logged after the initial one.
+    bool stop = false;
+    double epoch_start;
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            double start_time = omp_get_wtime();
+            this->evaluate_population(population, samples, ground_truth);
+            this->logger->log(population, 0, pop / (omp_get_wtime() - start_time));
+            stop = this->reached_target(population, 0);
+            epoch_start = omp_get_wtime();
+        }
+
+        while (true) {
+            long index, finished;
+            bool done;
+
+            #pragma omp atomic capture
+            index = issued++;
+            #pragma omp atomic read
+            done = stop;
+
+            if (done || index >= budget) {
+                break;
+            }
+
+            Philox engine(breed_seed, index / pop, index % pop, Philox::BREED);
+            individual_ptr child = population->breed_steady_state(engine,
+                this->crossover_rate, this->mutation_rate);
+            child->set_fitness(Traits::fitness(child, samples, ground_truth));
+
+            Philox replace_engine(breed_seed, index / pop, index % pop,
+                Philox::REPLACE);
+            population->replace(child, replace_engine);
+
+            #pragma omp atomic capture
+            finished = ++completed;
+
+            if (finished % pop == 0) {
+                // Same lock as breeding and replacement, the logger reads
+                // every individual.
+                #pragma omp critical (population)
+                if (finished / pop > logged) {
+                    double now = omp_get_wtime();
+                    logged = finished / pop;
+                    this->logger->log(population, logged, pop / (now - epoch_start));
+                    epoch_start = now;
+
+                    if (this->reached_target(population, logged)) {
+                        #pragma omp atomic write
+                        stop = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Evolve in steady-state mode across ranks. The master breeds batches and
+ * hands each to whichever worker comes back first, inserting the returned
+ * fitnesses with tournament replacement, so no rank waits on the slowest.
+ * @param rank int, process rank.
+ * @param size int, number of ranks, > 1.
+ */
+template <typename PopulationType>
+void Driver::evolve_steady_state_hybrid(const int & rank, const int & size) {
+    typedef EngineTraits<PopulationType> Traits;
+    typedef typename Traits::individual_ptr individual_ptr;
+    this->run_start_time = omp_get_wtime();
+
+    const int MASTER_TO_SLAVE_TAG = 0;
+    const int SLAVE_TO_MASTER_TAG = 1;
+    const int TERMINATE_TAG = 2;
+
+    auto func = FunctionFactory::make_function((FunctionFactory::FunctionType)this->function);
+
+    vector<float> samples(this->options.num_samples, 0);
+    vector<float> ground_truth(this->options.num_samples, 0);
+
+    // Samples are fixed for the run, every rank draws them from the same seed.
+    auto dom = func->domain();
+    uniform_real_distribution<float> domain(dom.first, dom.second);
+    uint32_t sample_seed = this->root_engine();
+    MPI_Bcast(&sample_seed, 1, MPI_UINT32_T, this->MASTER, MPI_COMM_WORLD);
+    Philox sample_engine(sample_seed, 0, 0, Philox::SAMPLE);
+    this->generate_samples(samples, ground_truth, func, domain, sample_engine);
+
+    // Workers evaluate whatever arrives until told to stop.
+    if (rank != this->MASTER) {
+        vector<uint8_t> records;
+        vector<GenomeView> group;
+        vector<float> fitnesses;
+        vector<float> no_errors; // Steady-state selection is always by tournament.
+
+        #pragma omp parallel
+        #pragma omp single
+        while (true) {
+            MPI_Status status;
+            int received;
+
+            MPI_Probe(this->MASTER, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_BYTE, &received);
+            records.resize(received);
+            MPI_Recv(records.data(), received, MPI_BYTE, this->MASTER,
+                status.MPI_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+            if (status.MPI_TAG == TERMINATE_TAG) {
+                break;
+            }
+
+            GenomeReader reader(records.data(), records.size());
+            GenomeView genome;
+            group.clear();
+            while (reader.next(genome)) {
+                group.push_back(genome);
+            }
+
+            fitnesses.assign(group.size(), 0);
+            evaluate_group_encoded<PopulationType>(group, samples, ground_truth,
+                fitnesses, no_errors);
+            MPI_Send(fitnesses.data(), fitnesses.size(), MPI_FLOAT, this->MASTER,
+                SLAVE_TO_MASTER_TAG, MPI_COMM_WORLD);
+        }
+
+        return;
+    }
+
+    this->logger->use_evaluation_rate();
+    this->logger->initialize();
+
+    auto population = make_shared<PopulationType>(this->population_size,
+        this->options.bloat_control, this->options.selection);
+    population->initialize(this->root_engine, Traits::MIN_INIT, Traits::MAX_INIT);
+
+    const uint64_t breed_seed = this->root_engine();
+    const long pop = this->population_size;
+    const long budget = (long)this->generations * pop;
+    const long batch = std::max(1L, pop / (4L * (size - 1)));
+
+    vector<vector<individual_ptr>> pending(size); // Children out on each worker.
+    vector<long> pending_start(size, 0);          // Index of their first child.
+    vector<vector<uint8_t>> payloads(size);
+    long issued = 0, completed = 0;
+    int busy = 0;
+    bool stop = false;
+
+    #pragma omp parallel
+    #pragma omp single
+    {
+        // The initial population is evaluated here, then workers take over.
+        double start_time = omp_get_wtime();
+        this->evaluate_population(population, samples, ground_truth);
+        this->logger->log(population, 0, pop / (omp_get_wtime() - start_time));
+        stop = this->reached_target(population, 0);
+        double epoch_start = omp_get_wtime();
+
+        auto send_batch = [&](int worker) {
+            long n = std::min(batch, budget - issued);
+            GenomeWriter writer(payloads[worker]);
+
+            payloads[worker].clear();
+            pending[worker].clear();
+            pending_start[worker] = issued;
+
+            for (long i = 0; i < n; i++, issued++) {
+                Philox engine(breed_seed, issued / pop, issued % pop, Philox::BREED);
+                individual_ptr child = population->breed_steady_state(engine,
+                    this->crossover_rate, this->mutation_rate);
+                Traits::encode(child, writer);
+                pending[worker].push_back(child);
+            }
+
+            MPI_Send(payloads[worker].data(), payloads[worker].size(), MPI_BYTE,
+                worker, MASTER_TO_SLAVE_TAG, MPI_COMM_WORLD);
+            busy++;
+        };
+
+        for (int worker = 1; worker < size && ! stop && issued < budget; worker++) {
+            send_batch(worker);
+        }
+
+        while (busy > 0) {
+            MPI_Status status;
+            MPI_Probe(MPI_ANY_SOURCE, SLAVE_TO_MASTER_TAG, MPI_COMM_WORLD, &status);
+            int worker = status.MPI_SOURCE;
+
+            vector<float> fitnesses(pending[worker].size());
+            MPI_Recv(fitnesses.data(), fitnesses.size(), MPI_FLOAT, worker,
+                SLAVE_TO_MASTER_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            busy--;
+
+            for (size_t i = 0; i < fitnesses.size(); i++) {
+                long index = pending_start[worker] + i;
+                Philox replace_engine(breed_seed, index / pop, index % pop,
+                    Philox::REPLACE);
+
+                pending[worker][i]->set_fitness(fitnesses[i]);
+                population->replace(pending[worker][i], replace_engine);
+
+                if (++completed % pop == 0 && ! stop) {
+                    double now = omp_get_wtime();
+                    this->logger->log(population, completed / pop,
+                        pop / (now - epoch_start));
+                    epoch_start = now;
+                    stop = this->reached_target(population, completed / pop);
+                }
+            }
+
+            if (! stop && issued < budget) {
+                send_batch(worker);
+            }
+        }
+
+        for (int worker = 1; worker < size; worker++) {
+            MPI_Send(nullptr, 0, MPI_BYTE, worker, TERMINATE_TAG, MPI_COMM_WORLD);
+        }
+    }
+}
+
 /**
  * Main evolution function.
  * @param argc int, argument count.
@@ -380,14 +1777,51 @@ void Driver::evolve(int argc, char ** argv) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
+    bool linear = this->options.engine == LINEAR;
+
     // More than one rank, enter hybrid mode.
     if (size > 1) {
-        this->evolve_hybrid(rank, size);
+        if (this->options.steady_state && linear) {
+            this->evolve_steady_state_hybrid<LinearPopulation>(rank, size);
+        }
+        else if (this->options.steady_state) {
+            this->evolve_steady_state_hybrid<Population>(rank, size);
+        }
+        else if (this->options.topology != Migration::NONE && linear) {
+            this->evolve_islands<LinearPopulation>(rank, size);
+        }
+        else if (this->options.topology != Migration::NONE) {
+            this->evolve_islands<Population>(rank, size);
+        }
+        else if ((this->options.replicate || this->options.shard_samples) && linear) {
+            this->evolve_replica<LinearPopulation>(rank, size);
+        }
+        else if (this->options.replicate || this->options.shard_samples) {
+            this->evolve_replica<Population>(rank, size);
+        }
+        else if (linear) {
+            this->evolve_hybrid<LinearPopulation>(rank, size);
+        }
+        else {
+            this->evolve_hybrid<Population>(rank, size);
+        }
     }
     // One rank, use OpenMP only.
     else {
         MPI_Finalize(); // Don't need MPI anymore.
-        this->evolve_openmp();
+
+        if (this->options.steady_state && linear) {
+            this->evolve_steady_state<LinearPopulation>();
+        }
+        else if (this->options.steady_state) {
+            this->evolve_steady_state<Population>();
+        }
+        else if (linear) {
+            this->evolve_openmp<LinearPopulation>();
+        }
+        else {
+            this->evolve_openmp<Population>();
+        }
         return; // Avoid calling MPI_Finalize twice.
     }
 
@@ -4,16 +4,49 @@
 #include <random>
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 class Logger;
 class Population;
 class Function;
+class Philox;
+class Checkpoint;
 
 struct OutgoingPayload {
-    uint_fast32_t seed; // Random seed to generate samples with.
-    int payload_length; // Length of incoming string.
+    uint32_t seed;  // Random seed to generate samples with.
+    int terminate;  // Non-zero once the master stops the run.
 };
 
+/**
+ * Optional settings, the defaults reproduce the original tree GP runs.
+ */
+struct DriverOptions {
+    int engine = 0;          // Representation, from Driver::Engine enum.
+    float target_rmse = -1;  // Stop once the best rmse reaches this, < 0 never stops.
+    bool steady_state = false; // Asynchronous steady-state instead of generations.
+    int bloat_control = 0;   // Evolution::BloatControl flags.
+    int selection = 0;       // Parent selection, from Selection::Method enum.
+    bool replicate = false;  // Hybrid mode breeds on every rank, only fitnesses are sent.
+    int topology = 0;        // Island model migration, from Migration::Topology enum.
+    int migration_interval = 10; // Generations between migrations.
+    int migrants = 2;        // Individuals each island sends per destination.
+    bool work_queue = false; // Hybrid mode hands out guided chunks on request.
+    int pipeline_chunks = 1; // Hybrid mode streams each rank's records in this many chunks.
+    int num_samples = 100;   // Fitness cases drawn each generation.
+    bool shard_samples = false; // Replicas split the samples as well as the individuals.
+    bool share_nodes = false; // Hybrid mode hands records out through per node shared memory.
+    bool put_results = false; // Hybrid ranks put results into an RMA window on the master.
+    int checkpoint_interval = 0; // Generations between checkpoints, 0 for none.
+    std::string resume_file; // Checkpoint to continue from, empty to start afresh.
+};
+
+/**
+ * Measurements from one evaluation of the population.
+ */
+struct EvaluationStats {
+    double imbalance = 1;    // Busiest thread or rank over the mean.
+    double unique_ratio = 1; // Distinct genomes over population size.
+};
 
 
 class Driver {
@@ -21,6 +54,14 @@ public:
 
     const int MASTER = 0; // Rank of the master process.
 
+    /**
+     * Genome representations.
+     */
+    enum Engine {
+        TREE = 0,
+        LINEAR = 1
+    };
+
     /**
      * Constructor.
      * @param _mutation_rate   float, [0, 1]
@@ -28,24 +69,50 @@ public:
      * @param _seed            int, random seed.
      * @param _population_size int, > 2
      * @param _generations     int, > 1
+     * @param _output_dir      string, where logs are written.
+     * @param _options         DriverOptions, optional settings.
      */
     Driver(float _mutation_rate, float _crossover_rate, int _seed, int _function,
-           int _population_size, int _generations, std::string _output_dir);
+           int _population_size, int _generations, std::string _output_dir,
+           const DriverOptions & _options = DriverOptions());
+    ~Driver();
+    Driver(const Driver &) = delete;
+    Driver & operator=(const Driver &) = delete;
 
     void evolve(int argc, char ** argv);
     void generate_samples(std::vector<float> & samples, std::vector<float> & ground_truth,
         std::shared_ptr<Function> func, std::uniform_real_distribution<float> & domain,
-        std::mt19937 & engine);
+        Philox & engine);
 private:
+    template <typename PopulationType>
     void evolve_hybrid(const int & rank, const int & size);
+    template <typename PopulationType>
+    void evolve_replica(const int & rank, const int & size);
+    template <typename PopulationType>
+    void evolve_islands(const int & rank, const int & size);
+    template <typename PopulationType>
     void evolve_openmp();
-    void evaluate_population(std::shared_ptr<Population> group,
+    template <typename PopulationType>
+    void evolve_steady_state();
+    template <typename PopulationType>
+    void evolve_steady_state_hybrid(const int & rank, const int & size);
+    template <typename PopulationType>
+    EvaluationStats evaluate_population(std::shared_ptr<PopulationType> population,
         const std::vector<float> & samples, const std::vector<float> & ground_truth);
+    template <typename PopulationType>
+    bool save_checkpoint(Checkpoint & checkpoint,
+        std::shared_ptr<PopulationType> population, int next_generation);
+    template <typename PopulationType>
+    bool reached_target(std::shared_ptr<PopulationType> population,
+        const int & current_generation);
 
     float mutation_rate, crossover_rate;
     int seed; // Global seed, only used to generate random samples for master.
     int population_size, generations;
     int function;
     std::mt19937 root_engine;
+    DriverOptions options;
+    double run_start_time; // Wall time the run started, for time to target.
+    std::string checkpoint_name; // Where checkpoints are written.
     Logger * logger;
 };
@@ -0,0 +1,80 @@
+#include <vector>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include "serialization.h"
+#include "duplicates.h"
+
+using std::vector;
+
+/**
+ * 64 bit FNV-1a hash of a record body.
+ * @param  genome GenomeView
+ * @return        uint64_t
+ */
+uint64_t Duplicates::hash(const GenomeView & genome) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (uint32_t i = 0; i < genome.length; i++) {
+        h ^= genome.body[i];
+        h *= 0x100000001b3ULL;
+    }
+
+    return h;
+}
+
+/**
+ * Group identical genomes. Records are sorted by hash and only records with
+ * equal hashes are compared byte by byte. The representative of each group
+ * is its lowest index, so the grouping does not depend on hash order.
+ * @param  genomes vector<GenomeView>
+ * @param  unique  vector<size_t>, set to the index of each group's
+ *                 representative, in increasing order.
+ * @return         vector<size_t>, for each genome its group, an index into unique.
+ */
+vector<size_t> Duplicates::group(const vector<GenomeView> & genomes,
+        vector<size_t> & unique) {
+    typedef std::pair<uint64_t, size_t> keyed; // (hash, genome index)
+    vector<keyed> keys(genomes.size());
+    vector<size_t> representative(genomes.size());
+
+    for (size_t i = 0; i < genomes.size(); i++) {
+        keys[i] = keyed(hash(genomes[i]), i);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    // Within a run of equal hashes, indices are increasing, so the first
+    // match found for a genome is the lowest index with the same bytes.
+    for (size_t start = 0, end; start < keys.size(); start = end) {
+        for (end = start; end < keys.size() && keys[end].first == keys[start].first; end++) {
+            const GenomeView & genome = genomes[keys[end].second];
+            representative[keys[end].second] = keys[end].second;
+
+            for (size_t k = start; k < end; k++) {
+                const GenomeView & other = genomes[keys[k].second];
+
+                if (representative[keys[k].second] == keys[k].second
+                    && other.length == genome.length
+                    && std::memcmp(other.body, genome.body, genome.length) == 0) {
+                    representative[keys[end].second] = keys[k].second;
+                    break;
+                }
+            }
+        }
+    }
+
+    vector<size_t> groups(genomes.size());
+    unique.clear();
+
+    for (size_t i = 0; i < genomes.size(); i++) {
+        if (representative[i] == i) {
+            groups[i] = unique.size();
+            unique.push_back(i);
+        }
+        else {
+            groups[i] = groups[representative[i]];
+        }
+    }
+
+    return groups;
+}
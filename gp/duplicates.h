@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "serialization.h"
+
+using std::vector;
+
+/**
+ * Finds byte identical genome records. Elitism, copies and mutations that
+ * undo themselves leave many identical genomes in a population, so each
+ * distinct genome is evaluated (and sent) once and its fitness fanned out.
+ */
+struct Duplicates {
+    static uint64_t hash(const GenomeView & genome);
+    static vector<size_t> group(const vector<GenomeView> & genomes,
+                                vector<size_t> & unique);
+
+private:
+    Duplicates() {}
+};
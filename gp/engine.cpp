@@ -0,0 +1,214 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include "evaluation.h"
+#include "individual.h"
+#include "linear.h"
+#include "engine.h"
+
+using std::string; using std::vector;
+
+/**
+ * Number of nodes in the tree.
+ * @param  indv indv_ptr
+ * @return      int
+ */
+int EngineTraits<Population>::size(const indv_ptr & indv) {
+    return indv->get_tree()->num_nodes();
+}
+
+/**
+ * Genome used for communication and archiving.
+ * @param  indv indv_ptr
+ * @return      string, reverse polish notation.
+ */
+string EngineTraits<Population>::genome(const indv_ptr & indv) {
+    return indv->get_tree()->get_rpn_string();
+}
+
+/**
+ * Human readable form of the genome.
+ * @param  indv indv_ptr
+ * @return      string, infix notation.
+ */
+string EngineTraits<Population>::description(const indv_ptr & indv) {
+    return indv->get_tree()->get_infix_string();
+}
+
+/**
+ * Fitness of an individual, rmse plus a parsimony term.
+ * @param  indv         indv_ptr
+ * @param  samples      vector<float>, random samples from domain
+ * @param  ground_truth vector<float>, function applied to samples
+ * @return              float
+ */
+float EngineTraits<Population>::fitness(const indv_ptr & indv,
+        const vector<float> & samples, const vector<float> & ground_truth) {
+    // Encoding once is far cheaper than re-parsing the rpn string per sample.
+    vector<uint8_t> buffer;
+    GenomeWriter writer(buffer);
+    writer.write(*(indv->get_tree()));
+
+    GenomeView genome;
+    GenomeReader(buffer.data(), buffer.size()).next(genome);
+    return fitness(genome, samples, ground_truth);
+}
+
+/**
+ * Append the binary record of an individual.
+ * @param indv   indv_ptr
+ * @param writer GenomeWriter
+ */
+void EngineTraits<Population>::encode(const indv_ptr & indv, GenomeWriter & writer) {
+    writer.write(*(indv->get_tree()));
+}
+
+/**
+ * Rebuild an individual from its binary record.
+ * @param  genome GenomeView, tree record.
+ * @return        indv_ptr, without a fitness.
+ */
+indv_ptr EngineTraits<Population>::decode(const GenomeView & genome) {
+    return std::make_shared<Individual>(Serialization::decode_tree(genome.body,
+        genome.length));
+}
+
+/**
+ * Whether a record from outside the run can be decoded.
+ * @param  genome GenomeView, tree record.
+ * @return        bool
+ */
+bool EngineTraits<Population>::valid(const GenomeView & genome) {
+    return Serialization::valid_tree(genome.body, genome.length);
+}
+
+/**
+ * Fitness of a communicated genome, evaluated without rebuilding the tree.
+ * @param  genome       GenomeView, tree record.
+ * @param  samples      vector<float>, random samples from domain
+ * @param  ground_truth vector<float>, function applied to samples
+ * @param  errors       float pointer, if not null set to the error on each sample.
+ * @return              float
+ */
+float EngineTraits<Population>::fitness(const GenomeView & genome,
+        const vector<float> & samples, const vector<float> & ground_truth,
+        float * errors) {
+    return Evaluation::assign_rmse(genome, samples, ground_truth, errors)
+        + Serialization::num_tokens(genome.body, genome.length);
+}
+
+/**
+ * Sum of squared errors of a communicated genome, without the parsimony
+ * term, for combining partial sums over sample shards.
+ * @param  genome       GenomeView, tree record.
+ * @param  samples      vector<float>, random samples from domain
+ * @param  ground_truth vector<float>, function applied to samples
+ * @param  errors       float pointer, if not null set to the error on each sample.
+ * @return              float
+ */
+float EngineTraits<Population>::squared_error(const GenomeView & genome,
+        const vector<float> & samples, const vector<float> & ground_truth,
+        float * errors) {
+    return Evaluation::squared_error(genome, samples, ground_truth, errors);
+}
+
+/**
+ * Number of instructions in the program.
+ * @param  indv linear_indv_ptr
+ * @return      int
+ */
+int EngineTraits<LinearPopulation>::size(const linear_indv_ptr & indv) {
+    return indv->get_program().length();
+}
+
+/**
+ * Genome used for communication and archiving.
+ * @param  indv linear_indv_ptr
+ * @return      string, serialized instructions.
+ */
+string EngineTraits<LinearPopulation>::genome(const linear_indv_ptr & indv) {
+    return indv->get_program().to_string();
+}
+
+/**
+ * Human readable form of the genome.
+ * @param  indv linear_indv_ptr
+ * @return      string, listing of the effective instructions.
+ */
+string EngineTraits<LinearPopulation>::description(const linear_indv_ptr & indv) {
+    return indv->get_program().get_listing();
+}
+
+/**
+ * Fitness of an individual, rmse plus a parsimony term.
+ * @param  indv         linear_indv_ptr
+ * @param  samples      vector<float>, random samples from domain
+ * @param  ground_truth vector<float>, function applied to samples
+ * @return              float
+ */
+float EngineTraits<LinearPopulation>::fitness(const linear_indv_ptr & indv,
+        const vector<float> & samples, const vector<float> & ground_truth) {
+    return Evaluation::assign_rmse(indv->get_program(), samples, ground_truth)
+        + indv->get_program().length();
+}
+
+/**
+ * Append the binary record of an individual.
+ * @param indv   linear_indv_ptr
+ * @param writer GenomeWriter
+ */
+void EngineTraits<LinearPopulation>::encode(const linear_indv_ptr & indv,
+        GenomeWriter & writer) {
+    writer.write(indv->get_program());
+}
+
+/**
+ * Rebuild an individual from its binary record.
+ * @param  genome GenomeView, linear record.
+ * @return        linear_indv_ptr, without a fitness.
+ */
+linear_indv_ptr EngineTraits<LinearPopulation>::decode(const GenomeView & genome) {
+    return std::make_shared<LinearIndividual>(Serialization::decode_linear(
+        genome.body, genome.length));
+}
+
+/**
+ * Whether a record from outside the run can be decoded.
+ * @param  genome GenomeView, linear record.
+ * @return        bool
+ */
+bool EngineTraits<LinearPopulation>::valid(const GenomeView & genome) {
+    return Serialization::valid_linear(genome.body, genome.length);
+}
+
+/**
+ * Fitness of a communicated genome.
+ * @param  genome       GenomeView, linear record.
+ * @param  samples      vector<float>, random samples from domain
+ * @param  ground_truth vector<float>, function applied to samples
+ * @param  errors       float pointer, if not null set to the error on each sample.
+ * @return              float
+ */
+float EngineTraits<LinearPopulation>::fitness(const GenomeView & genome,
+        const vector<float> & samples, const vector<float> & ground_truth,
+        float * errors) {
+    LinearProgram program = Serialization::decode_linear(genome.body, genome.length);
+    return Evaluation::assign_rmse(program, samples, ground_truth, errors)
+        + program.length();
+}
+
+/**
+ * Sum of squared errors of a communicated genome, without the parsimony
+ * term, for combining partial sums over sample shards.
+ * @param  genome       GenomeView, linear record.
+ * @param  samples      vector<float>, random samples from domain
+ * @param  ground_truth vector<float>, function applied to samples
+ * @param  errors       float pointer, if not null set to the error on each sample.
+ * @return              float
+ */
+float EngineTraits<LinearPopulation>::squared_error(const GenomeView & genome,
+        const vector<float> & samples, const vector<float> & ground_truth,
+        float * errors) {
+    LinearProgram program = Serialization::decode_linear(genome.body, genome.length);
+    return Evaluation::squared_error(program, samples, ground_truth, errors);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "population.h"
+#include "linear_population.h"
+#include "serialization.h"
+
+using std::string; using std::vector;
+
+/**
+ * Representation specific hooks. The driver and logger are written against
+ * these so tree and linear populations share the same evolution loops.
+ * Text genomes are for people (the archive), binary records from
+ * serialization.h are what gets communicated and stored.
+ * Specialized below for each population type.
+ */
+template <typename PopulationType>
+struct EngineTraits;
+
+/**
+ * Tree GP, text genomes are reverse polish strings.
+ */
+template <>
+struct EngineTraits<Population> {
+    typedef indv_ptr individual_ptr;
+
+    static const int MIN_INIT = 2; // Initial tree depths.
+    static const int MAX_INIT = 6;
+
+    static int size(const indv_ptr & indv);
+    static string genome(const indv_ptr & indv);
+    static string description(const indv_ptr & indv);
+    static float fitness(const indv_ptr & indv, const vector<float> & samples,
+                         const vector<float> & ground_truth);
+    static void encode(const indv_ptr & indv, GenomeWriter & writer);
+    static indv_ptr decode(const GenomeView & genome);
+    static bool valid(const GenomeView & genome);
+    static float fitness(const GenomeView & genome, const vector<float> & samples,
+                         const vector<float> & ground_truth, float * errors = nullptr);
+    static float squared_error(const GenomeView & genome, const vector<float> & samples,
+                               const vector<float> & ground_truth,
+                               float * errors = nullptr);
+};
+
+/**
+ * Linear GP, text genomes are LinearProgram::to_string output.
+ */
+template <>
+struct EngineTraits<LinearPopulation> {
+    typedef linear_indv_ptr individual_ptr;
+
+    static const int MIN_INIT = 4; // Initial program lengths.
+    static const int MAX_INIT = 24;
+
+    static int size(const linear_indv_ptr & indv);
+    static string genome(const linear_indv_ptr & indv);
+    static string description(const linear_indv_ptr & indv);
+    static float fitness(const linear_indv_ptr & indv, const vector<float> & samples,
+                         const vector<float> & ground_truth);
+    static void encode(const linear_indv_ptr & indv, GenomeWriter & writer);
+    static linear_indv_ptr decode(const GenomeView & genome);
+    static bool valid(const GenomeView & genome);
+    static float fitness(const GenomeView & genome, const vector<float> & samples,
+                         const vector<float> & ground_truth, float * errors = nullptr);
+    static float squared_error(const GenomeView & genome, const vector<float> & samples,
+                               const vector<float> & ground_truth,
+                               float * errors = nullptr);
+};
@@ -6,8 +6,12 @@
 #include<memory>
 #include<random>
 #include<sstream>
+#include<algorithm>
 #include "function.h"
 #include "evaluation.h"
+#include "linear.h"
+#include "serialization.h"
+#include "random.h"
 
 #include <iostream>
 using std::cout; using std::endl;
@@ -18,10 +22,11 @@ constexpr std::array<char, 4> Evaluation::OPERATIONS;
 /**
  * Return a random operation not equal to the given operation.
  * @param  operation string
- * @param  engine    mt19937, Mersenne twister random engine.
+ * @param  engine    Engine, mt19937 or Philox, advanced by the draws.
  * @return           string
  */
-string Evaluation::get_random_operation(string operation, std::mt19937 engine) {
+template <typename Engine>
+string Evaluation::get_random_operation(const string & operation, Engine & engine) {
     std::uniform_int_distribution<int> operation_dist(0, Evaluation::OPERATIONS.size() - 1);
     string new_operation = string(1, Evaluation::OPERATIONS[operation_dist(engine)]);
 
@@ -32,6 +37,10 @@ string Evaluation::get_random_operation(string operation, std::mt19937 engine) {
     return new_operation;
 }
 
+template string Evaluation::get_random_operation<std::mt19937>(const string &,
+    std::mt19937 &);
+template string Evaluation::get_random_operation<Philox>(const string &, Philox &);
+
 // void print_stack(std::stack<float> s) {
 //     std::stack<float> c = s; // Copy
 //     cout << "Stack: ";
@@ -143,3 +152,210 @@ float Evaluation::assign_rmse(const string & rpn,
 
     return sqrt(rmse / samples.size());
 }
+
+/**
+ * Absolute error on each sample, as used by lexicase selection. Errors that
+ * are not finite are stored as infinity so they still compare.
+ * @param predictions  float pointer, one prediction per sample.
+ * @param ground_truth vector<float>, function applied to samples.
+ * @param errors       float pointer, set to one error per sample.
+ */
+void Evaluation::case_errors(const float * predictions,
+                  const vector<float> & ground_truth, float * errors) {
+    for (size_t s = 0; s < ground_truth.size(); s++) {
+        float error = std::fabs(ground_truth[s] - predictions[s]);
+        errors[s] = std::isfinite(error) ? error : HUGE_VALF;
+    }
+}
+
+/**
+ * Evaluate a linear program on a vector of samples.
+ * The program runs over all samples at once, so no thread team is needed.
+ * @param  program      LinearProgram
+ * @param  samples      vector<float>, samples from the domain of a function.
+ * @param  ground_truth vector<float>, function applied to samples.
+ * @param  errors       float pointer, if not null set to the error on each sample.
+ * @return              float, rmse between samples and predictions.
+ */
+float Evaluation::assign_rmse(const LinearProgram & program,
+                  const vector<float> & samples,
+                  const vector<float> & ground_truth,
+                  float * errors) {
+    return sqrt(squared_error(program, samples, ground_truth, errors)
+        / samples.size());
+}
+
+/**
+ * Sum of squared errors of a linear program, partial sums over disjoint
+ * samples add up to the sum over all of them.
+ * @param  program      LinearProgram
+ * @param  samples      vector<float>, samples from the domain of a function.
+ * @param  ground_truth vector<float>, function applied to samples.
+ * @param  errors       float pointer, if not null set to the error on each sample.
+ * @return              float
+ */
+float Evaluation::squared_error(const LinearProgram & program,
+                  const vector<float> & samples,
+                  const vector<float> & ground_truth,
+                  float * errors) {
+    vector<float> predictions;
+    program.evaluate(samples, predictions);
+
+    float sum = 0;
+    float diff;
+    for (size_t i = 0; i < samples.size(); i++) {
+        diff = ground_truth[i] - predictions[i];
+        sum += diff * diff;
+    }
+
+    if (errors != nullptr) {
+        case_errors(predictions.data(), ground_truth, errors);
+    }
+
+    return sum;
+}
+
+/**
+ * Apply an operation opcode to the top two stack values.
+ * Same semantics as evaluate_rpn: a is the top of the stack, b below it.
+ * @param  op uint8_t, opcode from Serialization.
+ * @param  a  float
+ * @param  b  float
+ * @return    float
+ */
+static inline float apply_opcode(uint8_t op, float a, float b) {
+    switch (op) {
+        case Serialization::OP_ADD: return a + b;
+        case Serialization::OP_SUBTRACT: return b - a;
+        case Serialization::OP_MULTIPLY: return b * a;
+        default: return (a == 0) ? 1 : b / a; // Protected division.
+    }
+}
+
+/**
+ * Evaluate a binary encoded tree at x, no parsing involved.
+ * @param  tree GenomeView, tree record.
+ * @param  x    float
+ * @return      float
+ */
+float Evaluation::evaluate_encoded(const GenomeView & tree, const float & x) {
+    vector<float> stack;
+    stack.reserve(tree.length);
+    float a, b;
+
+    for (uint32_t i = 0; i < tree.length; i++) {
+        uint8_t op = tree.body[i];
+
+        if (op == Serialization::OP_VAR) {
+            stack.push_back(x);
+        }
+        else if (op == Serialization::OP_CONSTANT) {
+            stack.push_back(Serialization::read_float(tree.body + i + 1));
+            i += sizeof(float);
+        }
+        else {
+            a = stack.back();
+            stack.pop_back();
+            b = stack.back();
+            stack.back() = apply_opcode(op, a, b);
+        }
+    }
+
+    return stack.back();
+}
+
+/**
+ * Evaluate a binary encoded tree on a vector of samples.
+ * @param  tree         GenomeView, tree record.
+ * @param  samples      vector<float>, samples from the domain of a function.
+ * @param  ground_truth vector<float>, function applied to samples.
+ * @param  errors       float pointer, if not null set to the error on each sample.
+ * @return              float, rmse between samples and predictions.
+ */
+float Evaluation::assign_rmse(const GenomeView & tree,
+                  const vector<float> & samples,
+                  const vector<float> & ground_truth,
+                  float * errors) {
+    return sqrt(squared_error(tree, samples, ground_truth, errors)
+        / samples.size());
+}
+
+/**
+ * Sum of squared errors of a binary encoded tree.
+ * The stack holds one row per depth and each token is applied to every
+ * sample at once, so the tree is only walked once.
+ * @param  tree         GenomeView, tree record.
+ * @param  samples      vector<float>, samples from the domain of a function.
+ * @param  ground_truth vector<float>, function applied to samples.
+ * @param  errors       float pointer, if not null set to the error on each sample.
+ * @return              float
+ */
+float Evaluation::squared_error(const GenomeView & tree,
+                  const vector<float> & samples,
+                  const vector<float> & ground_truth,
+                  float * errors) {
+    const size_t n = samples.size();
+
+    // Find the deepest the stack gets to size the rows.
+    int depth = 0, max_depth = 0;
+    for (uint32_t i = 0; i < tree.length; i++) {
+        uint8_t op = tree.body[i];
+        if (op == Serialization::OP_VAR || op == Serialization::OP_CONSTANT) {
+            depth++;
+            max_depth = std::max(max_depth, depth);
+            i += (op == Serialization::OP_CONSTANT) ? sizeof(float) : 0;
+        }
+        else {
+            depth--;
+        }
+    }
+
+    vector<float> stack(max_depth * n);
+    int top = -1; // Row of the top of the stack.
+
+    for (uint32_t i = 0; i < tree.length; i++) {
+        uint8_t op = tree.body[i];
+
+        if (op == Serialization::OP_VAR) {
+            top++;
+            std::copy(samples.begin(), samples.end(), stack.begin() + top * n);
+        }
+        else if (op == Serialization::OP_CONSTANT) {
+            top++;
+            std::fill(stack.begin() + top * n, stack.begin() + (top + 1) * n,
+                Serialization::read_float(tree.body + i + 1));
+            i += sizeof(float);
+        }
+        else {
+            const float * a = &stack[top * n];
+            float * b = &stack[(top - 1) * n];
+            switch (op) {
+                case Serialization::OP_ADD:
+                    for (size_t s = 0; s < n; s++) b[s] = a[s] + b[s];
+                    break;
+                case Serialization::OP_SUBTRACT:
+                    for (size_t s = 0; s < n; s++) b[s] = b[s] - a[s];
+                    break;
+                case Serialization::OP_MULTIPLY:
+                    for (size_t s = 0; s < n; s++) b[s] = b[s] * a[s];
+                    break;
+                default:
+                    for (size_t s = 0; s < n; s++) b[s] = (a[s] == 0) ? 1 : b[s] / a[s];
+            }
+            top--;
+        }
+    }
+
+    float sum = 0;
+    float diff;
+    for (size_t s = 0; s < n; s++) {
+        diff = ground_truth[s] - stack[s];
+        sum += diff * diff;
+    }
+
+    if (errors != nullptr) {
+        case_errors(stack.data(), ground_truth, errors);
+    }
+
+    return sum;
+}
@@ -7,6 +7,9 @@
 
 using std::string; using std::vector;
 
+class LinearProgram;
+struct GenomeView;
+
 /**
  * struct for handling evaluation.
  */
@@ -24,13 +27,33 @@ struct Evaluation {
     // Constant to store the operation set.
     static constexpr std::array<char, 4> OPERATIONS = {'+', '-', '*', '/'};
 
-    static string get_random_operation(string operation, std::mt19937 engine);
+    template <typename Engine>
+    static string get_random_operation(const string & operation, Engine & engine);
     static float evaluate_rpn(const string & rpn, const float & x);
     static void get_ab(std::stack<float> & stack, float & a, float & b);
     static vector<string> tokenize_comm_string(const string & rpn_string);
     static float assign_rmse(const string & rpn,
                       const vector<float> & samples,
                       const vector<float> & ground_truth);
+    static float assign_rmse(const LinearProgram & program,
+                      const vector<float> & samples,
+                      const vector<float> & ground_truth,
+                      float * errors = nullptr);
+    static float squared_error(const LinearProgram & program,
+                      const vector<float> & samples,
+                      const vector<float> & ground_truth,
+                      float * errors = nullptr);
+    static float evaluate_encoded(const GenomeView & tree, const float & x);
+    static float assign_rmse(const GenomeView & tree,
+                      const vector<float> & samples,
+                      const vector<float> & ground_truth,
+                      float * errors = nullptr);
+    static float squared_error(const GenomeView & tree,
+                      const vector<float> & samples,
+                      const vector<float> & ground_truth,
+                      float * errors = nullptr);
+    static void case_errors(const float * predictions,
+                      const vector<float> & ground_truth, float * errors);
 
     /**
      * Determine if a string is an operation.
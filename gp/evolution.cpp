@@ -1,18 +1,20 @@
-#include <set>
 #include <random>
 #include <memory>
 #include <string>
 #include <vector>
 #include <functional>
+#include <algorithm>
 #include "evaluation.h"
 #include "individual.h"
 #include "population.h"
+#include "selection.h"
 #include "evolution.h"
 
 #include <iostream>
 using std::cout; using std::endl;
 
 using std::make_shared;
+using std::vector;
 using std::mt19937;
 using std::uniform_int_distribution;
 using std::uniform_real_distribution;
@@ -21,13 +23,19 @@ using std::bernoulli_distribution;
 
 /**
  * Cross parent_a with parent_b. Produces one new individual.
- * @param  parent_a indv_ptr
- * @param  parent_b indv_ptr
- * @param  engine   mt19937, Mersenne twister random engine.
- * @return          indv_ptr
+ * With SIZE_FAIR the subtree taken from parent_b is drawn only among those
+ * at most 1 + 2x the size of the subtree it replaces (Langdon's bound), so
+ * a child can at most roughly double the removed material. With DEPTH_LIMIT
+ * a child deeper than MAX_DEPTH is rejected like one over MAX_NUM_NODES.
+ * @param  parent_a      indv_ptr
+ * @param  parent_b      indv_ptr
+ * @param  engine        Engine, mt19937 or Philox.
+ * @param  bloat_control int, BloatControl flags.
+ * @return               indv_ptr
  */
+template <typename Engine>
 indv_ptr Evolution::crossover(indv_ptr parent_a, indv_ptr parent_b,
-                   mt19937 & engine) {
+                   Engine & engine, int bloat_control) {
     int size_a = parent_a->get_tree()->num_nodes();
     int size_b = parent_b->get_tree()->num_nodes();
 
@@ -41,8 +49,28 @@ indv_ptr Evolution::crossover(indv_ptr parent_a, indv_ptr parent_b,
     uniform_int_distribution<int> random_node_b(0, size_b - 1);
 
     // Be sure not to crossover the root of the parent a.
-    node_ptr cx_point_a = copy_a->node_at(random_node_a(engine));
-    node_ptr cx_point_b = copy_b->node_at(random_node_b(engine));
+    int index_a = random_node_a(engine);
+    node_ptr cx_point_a = copy_a->node_at(index_a);
+    node_ptr cx_point_b;
+
+    if (bloat_control & SIZE_FAIR) {
+        int removed = copy_a->get_tree()->subtree_sizes()[index_a];
+        vector<int> sizes_b = copy_b->get_tree()->subtree_sizes();
+        vector<int> candidates;
+
+        // Leaves always qualify, so there is at least one candidate.
+        for (int i = 0; i < size_b; i++) {
+            if (sizes_b[i] <= 1 + 2 * removed) {
+                candidates.push_back(i);
+            }
+        }
+
+        uniform_int_distribution<int> random_candidate(0, candidates.size() - 1);
+        cx_point_b = copy_b->node_at(candidates[random_candidate(engine)]);
+    }
+    else {
+        cx_point_b = copy_b->node_at(random_node_b(engine));
+    }
 
     // Do crossover.
     node_ptr cx_point_a_parent = cx_point_a->parent;
@@ -55,7 +83,9 @@ indv_ptr Evolution::crossover(indv_ptr parent_a, indv_ptr parent_b,
         cx_point_a_parent->left = cx_point_b;
     }
 
-    if (copy_a->get_tree()->num_nodes() > MAX_NUM_NODES) {
+    if (copy_a->get_tree()->num_nodes() > MAX_NUM_NODES
+        || ((bloat_control & DEPTH_LIMIT)
+            && copy_a->get_tree()->depth() > MAX_DEPTH)) {
         return make_shared<Individual>(*(parent_a));
     }
     else {
@@ -66,10 +96,11 @@ indv_ptr Evolution::crossover(indv_ptr parent_a, indv_ptr parent_b,
 /**
  * Carry out a point mutation on an individual.
  * @param  indv   indv_ptr
- * @param  engine mt19937, Mersenne twister random engine.
+ * @param  engine Engine, mt19937 or Philox.
  * @return        indv_ptr, pointer to the same individual, not a copy.
  */
-indv_ptr Evolution::mutation(indv_ptr indv, mt19937 & engine) {
+template <typename Engine>
+indv_ptr Evolution::mutation(indv_ptr indv, Engine & engine) {
     int size = indv->get_tree()->num_nodes();
     uniform_int_distribution<int> dist_nodes(0, size - 1);
     node_ptr point = indv->get_tree()->node_at(dist_nodes(engine));
@@ -85,7 +116,7 @@ indv_ptr Evolution::mutation(indv_ptr indv, mt19937 & engine) {
             point->value = Evaluation::VAR;
         }
         else {
-            point->value = std::to_string(EPHEMERAL_RANDOM_CONSTANTS(engine));
+            point->set_constant(EPHEMERAL_RANDOM_CONSTANTS(engine));
         }
     }
 
@@ -94,11 +125,16 @@ indv_ptr Evolution::mutation(indv_ptr indv, mt19937 & engine) {
 
 /**
  * Create an individual with the "grow" method.
- * @param  max_depth int, maximum depth of tree.
- * @param  engine    mt19937, Mersenne Twiseter random engine.
+ * @param  max_depth int, maximum depth of tree, capped at MAX_DEPTH.
+ * @param  engine    Engine, mt19937 or Philox.
  * @return           indv_ptr
  */
-indv_ptr Evolution::grow(int max_depth, mt19937 & engine) {
+template <typename Engine>
+indv_ptr Evolution::grow(int max_depth, Engine & engine) {
+    if (max_depth > MAX_DEPTH) {
+        max_depth = MAX_DEPTH;
+    }
+
     return make_shared<Individual>(
         make_shared<RPNTree>(
             grow_recursion(max_depth, engine, 1, nullptr)
@@ -109,12 +145,13 @@ indv_ptr Evolution::grow(int max_depth, mt19937 & engine) {
 /**
  * "Grow" initialization recursion.
  * @param  max_depth     int
- * @param  engine        mt19937, Mersenne Twister random engine.
+ * @param  engine        Engine, mt19937 or Philox.
  * @param  current_depth int, current depth of recursion.
  * @param  parent        parent
  * @return               node_ptr, root node.
  */
-node_ptr Evolution::grow_recursion(int max_depth, mt19937 & engine,
+template <typename Engine>
+node_ptr Evolution::grow_recursion(int max_depth, Engine & engine,
                         int current_depth, node_ptr parent) {
     node_ptr new_node;
 
@@ -147,11 +184,16 @@ node_ptr Evolution::grow_recursion(int max_depth, mt19937 & engine,
 
 /**
  * Create and individual with the "full" method.
- * @param  max_depth int, maximum depth of tree.
- * @param  engine    mt19937, Mersenne Twister random engine.
+ * @param  max_depth int, maximum depth of tree, capped at MAX_DEPTH.
+ * @param  engine    Engine, mt19937 or Philox.
  * @return           indv_ptr
  */
-indv_ptr Evolution::full(int max_depth, mt19937 & engine) {
+template <typename Engine>
+indv_ptr Evolution::full(int max_depth, Engine & engine) {
+    if (max_depth > MAX_DEPTH) {
+        max_depth = MAX_DEPTH;
+    }
+
     return make_shared<Individual>(
         make_shared<RPNTree>(
             full_recursion(max_depth, engine, 1, nullptr)
@@ -162,12 +204,13 @@ indv_ptr Evolution::full(int max_depth, mt19937 & engine) {
 /**
  * "Full" initialization recursion.
  * @param  max_depth     int
- * @param  engine        mt19937, Mersenne Twister random engine.
+ * @param  engine        Engine, mt19937 or Philox.
  * @param  current_depth int, current depth of recursion.
  * @param  parent        parent
  * @return               node_ptr, root node.
  */
-node_ptr Evolution::full_recursion(int max_depth, mt19937 & engine,
+template <typename Engine>
+node_ptr Evolution::full_recursion(int max_depth, Engine & engine,
                         int current_depth, node_ptr parent) {
     node_ptr new_node;
 
@@ -190,11 +233,12 @@ node_ptr Evolution::full_recursion(int max_depth, mt19937 & engine,
 
 /**
  * Make an operation node.
- * @param  engine mt19937, Mersenne Twister random generator.
+ * @param  engine Engine, mt19937 or Philox.
  * @param  parent node_ptr
  * @return        node_ptr
  */
-node_ptr Evolution::make_operation(mt19937 & engine, node_ptr parent) {
+template <typename Engine>
+node_ptr Evolution::make_operation(Engine & engine, node_ptr parent) {
     node_ptr node = make_shared<RPNNode>();
     node->value = Evaluation::get_random_operation("", engine);
     node->parent = parent;
@@ -204,11 +248,12 @@ node_ptr Evolution::make_operation(mt19937 & engine, node_ptr parent) {
 
 /**
  * Make a terminal node.
- * @param  engine mt19937, Mersenne Twister random generator.
+ * @param  engine Engine, mt19937 or Philox.
  * @param  parent node_ptr
  * @return        node_ptr
  */
-node_ptr Evolution::make_terminal(mt19937 & engine, node_ptr parent) {
+template <typename Engine>
+node_ptr Evolution::make_terminal(Engine & engine, node_ptr parent) {
     node_ptr node = make_shared<RPNNode>();
     node->parent = parent;
 
@@ -218,22 +263,27 @@ node_ptr Evolution::make_terminal(mt19937 & engine, node_ptr parent) {
     }
     // Use an ephemeral random constant as the terminal.
     else {
-        node->value = std::to_string(EPHEMERAL_RANDOM_CONSTANTS(engine));
+        node->set_constant(EPHEMERAL_RANDOM_CONSTANTS(engine));
     }
 
     return node;
 }
 
 /**
- * Select an individual from the population.
+ * Select an individual from the population, the best of tournament_size
+ * distinct random individuals. Contenders are kept on the stack and a
+ * repeated index is drawn again.
  * @param  population      shared_ptr<Population>
  * @param  tournament_size size_t, number of individuals in tournament.
  * @return                 indv_ptr, winner of tournament.
  */
+template <typename Engine>
 indv_ptr Evolution::tournament_selection(Population * population,
-                                         mt19937 & engine,
+                                         Engine & engine,
                                          size_t tournament_size) {
-    std::set<size_t> unique_indices;
+    size_t contenders[Selection::MAX_TOURNAMENT];
+    size_t k = std::min(std::min(tournament_size, Selection::MAX_TOURNAMENT),
+        population->get_length());
     uniform_int_distribution<size_t> random_indv(0, population->get_length() - 1);
 
     size_t index = random_indv(engine);
@@ -241,21 +291,41 @@ indv_ptr Evolution::tournament_selection(Population * population,
     float best_fitness = winner->get_fitness();
     float temp_fitness;
 
-    unique_indices.insert(index);
+    contenders[0] = index;
 
     // Chose and compare random individuals.
-    while(unique_indices.size() < tournament_size) {
+    for (size_t drawn = 1; drawn < k; ) {
         index = random_indv(engine);
 
+        if (std::find(contenders, contenders + drawn, index) != contenders + drawn) {
+            continue;
+        }
+        contenders[drawn++] = index;
+
         temp_fitness = (*population)[index]->get_fitness();
 
         if (temp_fitness < best_fitness) {
             winner = (*population)[index];
             best_fitness = temp_fitness;
         }
-
-        unique_indices.insert(random_indv(engine));
     }
 
     return winner;
 }
+
+template indv_ptr Evolution::crossover<mt19937>(indv_ptr, indv_ptr, mt19937 &, int);
+template indv_ptr Evolution::crossover<Philox>(indv_ptr, indv_ptr, Philox &, int);
+template indv_ptr Evolution::mutation<mt19937>(indv_ptr, mt19937 &);
+template indv_ptr Evolution::mutation<Philox>(indv_ptr, Philox &);
+template indv_ptr Evolution::grow<mt19937>(int, mt19937 &);
+template indv_ptr Evolution::grow<Philox>(int, Philox &);
+template indv_ptr Evolution::full<mt19937>(int, mt19937 &);
+template indv_ptr Evolution::full<Philox>(int, Philox &);
+template node_ptr Evolution::make_operation<mt19937>(mt19937 &, node_ptr);
+template node_ptr Evolution::make_operation<Philox>(Philox &, node_ptr);
+template node_ptr Evolution::make_terminal<mt19937>(mt19937 &, node_ptr);
+template node_ptr Evolution::make_terminal<Philox>(Philox &, node_ptr);
+template indv_ptr Evolution::tournament_selection<mt19937>(Population *, mt19937 &,
+    size_t);
+template indv_ptr Evolution::tournament_selection<Philox>(Population *, Philox &,
+    size_t);
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <memory>
+#include <random>
+#include <cstdint>
+#include "random.h"
 
 using std::mt19937;
 using std::uniform_int_distribution;
@@ -13,36 +16,66 @@ typedef std::shared_ptr<RPNNode> node_ptr;
 typedef std::shared_ptr<Individual> indv_ptr;
 
 struct Evolution {
-    static double COIN_FLIP(mt19937 & engine) {
+    template <typename Engine>
+    static double COIN_FLIP(Engine & engine) {
         bernoulli_distribution cf(0.5);
         return cf(engine);
     }
 
-    static double EPHEMERAL_RANDOM_CONSTANTS(mt19937 & engine) {
+    template <typename Engine>
+    static double EPHEMERAL_RANDOM_CONSTANTS(Engine & engine) {
         uniform_real_distribution<float> erc(-10, 10);
         return erc(engine);
     }
 
-    static double RAND(mt19937 & engine) {
+    template <typename Engine>
+    static double RAND(Engine & engine) {
         uniform_real_distribution<float> r(0, 1);
         return r(engine);
     }
 
+    // Philox draws skip the distribution objects.
+    static double COIN_FLIP(Philox & engine) { return engine.coin_flip(); }
+    static double EPHEMERAL_RANDOM_CONSTANTS(Philox & engine) {
+        return -10 + 20 * engine.uniform();
+    }
+    static double RAND(Philox & engine) { return engine.uniform(); }
+
     static const int MAX_NUM_NODES = 4096; // 2^12.
+    static const int MAX_DEPTH = 17;       // Koza's depth limit.
+
+    /**
+     * Bloat control flags, combined with | and selected with -b.
+     */
+    enum BloatControl {
+        SIZE_FAIR = 1,    // Inserted subtree at most 1 + 2x the one it replaces.
+        DEPTH_LIMIT = 2,  // Crossover children deeper than MAX_DEPTH are rejected.
+        DYNAMIC_LIMIT = 4 // Size limit only the best individual can move.
+    };
 
+    // The operators below are instantiated for mt19937 and Philox.
+    template <typename Engine>
     static indv_ptr crossover(indv_ptr parent_a, indv_ptr parent_b,
-                       mt19937 & engine);
-    static indv_ptr mutation(indv_ptr indv, mt19937 & engine);
-    static indv_ptr grow(int max_depth, mt19937 & engine);
-    static node_ptr grow_recursion(int max_depth, mt19937 & engine,
+                       Engine & engine, int bloat_control = 0);
+    template <typename Engine>
+    static indv_ptr mutation(indv_ptr indv, Engine & engine);
+    template <typename Engine>
+    static indv_ptr grow(int max_depth, Engine & engine);
+    template <typename Engine>
+    static node_ptr grow_recursion(int max_depth, Engine & engine,
                             int current_depth, node_ptr parent);
-    static indv_ptr full(int max_depth, mt19937 & engine);
-    static node_ptr full_recursion(int max_depth, mt19937 & engine,
+    template <typename Engine>
+    static indv_ptr full(int max_depth, Engine & engine);
+    template <typename Engine>
+    static node_ptr full_recursion(int max_depth, Engine & engine,
                             int current_depth, node_ptr parent);
-    static node_ptr make_operation(mt19937 & engine, node_ptr parent);
-    static node_ptr make_terminal(mt19937 & engine, node_ptr parent);
+    template <typename Engine>
+    static node_ptr make_operation(Engine & engine, node_ptr parent);
+    template <typename Engine>
+    static node_ptr make_terminal(Engine & engine, node_ptr parent);
+    template <typename Engine>
     static indv_ptr tournament_selection(Population * population,
-                                             mt19937 & engine,
+                                             Engine & engine,
                                              size_t tournament_size);
 private:
     Evolution() {}
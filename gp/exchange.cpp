@@ -0,0 +1,627 @@
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "transport.h"
+#include "omp.h"
+#include "serialization.h"
+#include "exchange.h"
+
+using std::vector;
+
+const int STREAM_TAG = 16; // Chunk c and its results are tagged STREAM_TAG + c.
+
+/**
+ * Release the node windows before the communicators they live on.
+ */
+Exchange::~Exchange() {
+    this->records_window.release();
+    this->results_window.release();
+
+    if (this->window != MPI_WIN_NULL) {
+        MPI_Win_unlock_all(this->window);
+        MPI_Win_free(&this->window);
+    }
+
+    if (this->leader_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&this->leader_comm);
+    }
+    if (this->node_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&this->node_comm);
+    }
+}
+
+/**
+ * Split the ranks by shared-memory node, collective. Lower ranks lead, so
+ * the root must be the lowest rank of its node, as rank 0 always is. Nodes
+ * are numbered in the order of their leaders.
+ */
+void Exchange::share_nodes() {
+    MPI_Comm_split_type(this->comm, MPI_COMM_TYPE_SHARED, this->rank,
+        MPI_INFO_NULL, &this->node_comm);
+    MPI_Comm_rank(this->node_comm, &this->node_rank);
+    MPI_Comm_size(this->node_comm, &this->node_size);
+
+    MPI_Comm_split(this->comm, this->node_rank == 0 ? 0 : MPI_UNDEFINED,
+        this->rank, &this->leader_comm);
+
+    if (this->leader_comm != MPI_COMM_NULL) {
+        MPI_Comm_rank(this->leader_comm, &this->node);
+        MPI_Comm_size(this->leader_comm, &this->num_nodes);
+    }
+    MPI_Bcast(&this->node, 1, MPI_INT, 0, this->node_comm);
+    MPI_Bcast(&this->num_nodes, 1, MPI_INT, 0, this->node_comm);
+
+    vector<int> node_of(this->size);
+    MPI_Gather(&this->node, 1, MPI_INT, node_of.data(), 1, MPI_INT, this->root,
+        this->comm);
+    this->leader_root = this->node;
+    MPI_Bcast(&this->leader_root, 1, MPI_INT, this->root, this->comm);
+
+    this->node_sizes.assign(this->num_nodes, 0);
+    if (this->rank == this->root) {
+        for (int n : node_of) {
+            this->node_sizes[n]++;
+        }
+    }
+}
+
+/**
+ * Broadcast from the root, counted like the other collectives.
+ * @param data  void pointer
+ * @param count int
+ * @param type  MPI_Datatype
+ */
+void Exchange::broadcast(void * data, int count, MPI_Datatype type) {
+    int type_size;
+    MPI_Type_size(type, &type_size);
+
+    double start = omp_get_wtime();
+    MPI_Bcast(data, count, type, this->root, this->comm);
+    this->time += omp_get_wtime() - start;
+    this->bytes += (double)count * type_size * ((this->rank == this->root) ? this->size - 1 : 1);
+}
+
+/**
+ * Root only. Write the records of each rank, or of each node for
+ * scatter_nodes, back to back as they will be scattered.
+ * @param assignment vector<vector<int>>, indices into unique for each rank
+ *                   or node.
+ * @param unique     vector<GenomeView>, distinct genomes of the population.
+ */
+void Exchange::pack(const vector<vector<int>> & assignment,
+        const vector<GenomeView> & unique) {
+    this->send_buffer.clear();
+    this->chunk_counts.resize(assignment.size() * this->chunks);
+    this->chunk_displacements.resize(assignment.size() * this->chunks);
+    GenomeWriter writer(this->send_buffer);
+
+    for (size_t i = 0; i < assignment.size(); i++) {
+        size_t before = this->send_buffer.size();
+
+        for (int c = 0; c < this->chunks; c++) {
+            size_t begin, end;
+            chunk_range(assignment[i].size(), c, this->chunks, begin, end);
+            size_t chunk_start = this->send_buffer.size();
+
+            for (size_t j = begin; j < end; j++) {
+                writer.write_raw(unique[assignment[i][j]]);
+            }
+
+            this->chunk_displacements[i * this->chunks + c] = chunk_start;
+            this->chunk_counts[i * this->chunks + c] = this->send_buffer.size()
+                - chunk_start;
+        }
+
+        this->send_displacements[i] = before;
+        this->send_counts[i] = this->send_buffer.size() - before;
+    }
+}
+
+/**
+ * Records of chunk c when a rank's records are split into chunks.
+ * @param records size_t, records of the rank.
+ * @param c       int, chunk.
+ * @param chunks  int, chunks per rank.
+ * @param begin   size_t, set to the first record of the chunk.
+ * @param end     size_t, set to one past its last record.
+ */
+void Exchange::chunk_range(size_t records, int c, int chunks, size_t & begin,
+        size_t & end) {
+    begin = records * c / chunks;
+    end = records * (c + 1) / chunks;
+}
+
+/**
+ * Start streaming the packed records, on every rank. Each rank learns its
+ * chunk sizes, then every chunk and every result is posted as its own
+ * non-blocking message. Follow with chunk, send_results or collect, and
+ * finish.
+ * @param assignment vector<vector<int>>, records of each rank, only read on
+ *                   the root.
+ * @param per_record size_t, result values per record.
+ */
+void Exchange::stream(const vector<vector<int>> & assignment, size_t per_record) {
+    double start = omp_get_wtime();
+    int k = this->chunks;
+    vector<int> counts(k);
+
+    MPI_Scatter(this->chunk_counts.data(), k, MPI_INT, counts.data(), k, MPI_INT,
+        this->root, this->comm);
+    this->bytes += sizeof(int) * (double)k * ((this->rank == this->root) ? this->size : 1);
+
+    this->chunk_requests.clear();
+    this->result_requests.clear();
+
+    if (this->rank == this->root) {
+        this->result_sources.clear();
+        this->result_indices.clear();
+        this->result_offsets.clear();
+        size_t total = 0;
+
+        for (int i = 0; i < this->size; i++) {
+            for (int c = 0; c < k && i != this->root; c++) {
+                size_t begin, end;
+                chunk_range(assignment[i].size(), c, k, begin, end);
+                this->result_sources.push_back(i);
+                this->result_indices.push_back(c);
+                this->result_offsets.push_back(total);
+                total += (end - begin) * per_record;
+            }
+        }
+
+        if (this->gather_buffer.size() < total) {
+            this->gather_buffer.resize(total);
+        }
+
+        // Results are posted first so nothing arrives unexpected.
+        for (size_t r = 0; r < this->result_sources.size(); r++) {
+            int i = this->result_sources[r], c = this->result_indices[r];
+            size_t begin, end;
+            chunk_range(assignment[i].size(), c, k, begin, end);
+
+            this->result_requests.emplace_back();
+            MPI_Irecv(this->gather_buffer.data() + this->result_offsets[r],
+                (end - begin) * per_record, MPI_FLOAT, i, STREAM_TAG + c, this->comm,
+                &this->result_requests.back());
+            this->bytes += sizeof(float) * (double)(end - begin) * per_record;
+        }
+
+        for (int i = 0; i < this->size; i++) {
+            for (int c = 0; c < k && i != this->root; c++) {
+                this->chunk_requests.emplace_back();
+                MPI_Isend(this->send_buffer.data() + this->chunk_displacements[i * k + c],
+                    this->chunk_counts[i * k + c], MPI_BYTE, i, STREAM_TAG + c, this->comm,
+                    &this->chunk_requests.back());
+                this->bytes += this->chunk_counts[i * k + c];
+            }
+        }
+    }
+    else {
+        size_t total = 0;
+        this->chunk_displacements.resize(k);
+        for (int c = 0; c < k; c++) {
+            this->chunk_displacements[c] = total;
+            total += counts[c];
+        }
+
+        if (this->receive_buffer.size() < total) {
+            this->receive_buffer.resize(total);
+        }
+
+        this->chunk_requests.resize(k);
+        for (int c = 0; c < k; c++) {
+            MPI_Irecv(this->receive_buffer.data() + this->chunk_displacements[c],
+                counts[c], MPI_BYTE, this->root, STREAM_TAG + c, this->comm,
+                &this->chunk_requests[c]);
+            this->bytes += counts[c];
+        }
+
+        this->chunk_counts.assign(counts.begin(), counts.end());
+        this->result_chunks.resize(k);
+        this->result_requests.assign(k, MPI_REQUEST_NULL);
+    }
+
+    this->time += omp_get_wtime() - start;
+}
+
+/**
+ * This rank's records of one chunk, waiting for them if still in flight.
+ * The root reads its own chunks straight from the send buffer.
+ * @param  c      int, chunk, in order.
+ * @param  length int, set to the length in bytes.
+ * @return        uint8_t pointer, valid until the next stream.
+ */
+const uint8_t * Exchange::chunk(int c, int & length) {
+    if (this->rank == this->root) {
+        int k = this->root * this->chunks + c;
+        length = this->chunk_counts[k];
+        return this->send_buffer.data() + this->chunk_displacements[k];
+    }
+
+    MPI_Wait(&this->chunk_requests[c], MPI_STATUS_IGNORE);
+    length = this->chunk_counts[c];
+    return this->receive_buffer.data() + this->chunk_displacements[c];
+}
+
+/**
+ * Send the results of a chunk to the root without waiting. Not for the root.
+ * @param c       int, chunk.
+ * @param results vector<float>, per_record values for each record, taken.
+ */
+void Exchange::send_results(int c, vector<float> & results) {
+    double start = omp_get_wtime();
+    this->result_chunks[c].swap(results);
+    MPI_Isend(this->result_chunks[c].data(), this->result_chunks[c].size(),
+        MPI_FLOAT, this->root, STREAM_TAG + c, this->comm,
+        &this->result_requests[c]);
+    this->bytes += sizeof(float) * (double)this->result_chunks[c].size();
+    this->time += omp_get_wtime() - start;
+}
+
+/**
+ * Root only. Wait for the next chunk of results from another rank, in
+ * whatever order they complete.
+ * @param  source  int, set to the rank.
+ * @param  c       int, set to the chunk.
+ * @param  results float pointer, set to per_record values for each record.
+ * @return         bool, false once every chunk has been collected.
+ */
+bool Exchange::collect(int & source, int & c, const float * & results) {
+    int index;
+    MPI_Waitany(this->result_requests.size(), this->result_requests.data(),
+        &index, MPI_STATUS_IGNORE);
+    if (index == MPI_UNDEFINED) {
+        return false;
+    }
+
+    source = this->result_sources[index];
+    c = this->result_indices[index];
+    results = this->gather_buffer.data() + this->result_offsets[index];
+    return true;
+}
+
+/**
+ * Complete this rank's sends of the stream.
+ */
+void Exchange::finish() {
+    if (this->rank == this->root) {
+        MPI_Waitall(this->chunk_requests.size(), this->chunk_requests.data(),
+            MPI_STATUSES_IGNORE);
+    }
+    else {
+        MPI_Waitall(this->result_requests.size(), this->result_requests.data(),
+            MPI_STATUSES_IGNORE);
+    }
+}
+
+/**
+ * Hand each rank its records. Every rank learns its byte count first, so the
+ * receive buffer is sized exactly.
+ * @param  received int, set to the number of bytes received.
+ * @return          uint8_t pointer, this rank's records, valid until the
+ *                  next scatter.
+ */
+const uint8_t * Exchange::scatter(int & received) {
+    double start = omp_get_wtime();
+
+    MPI_Scatter(this->send_counts.data(), 1, MPI_INT, &received, 1, MPI_INT,
+        this->root, this->comm);
+
+    if (this->receive_buffer.size() < (size_t)received) {
+        this->receive_buffer.resize(received);
+    }
+
+    MPI_Scatterv(this->send_buffer.data(), this->send_counts.data(),
+        this->send_displacements.data(), MPI_BYTE, this->receive_buffer.data(),
+        received, MPI_BYTE, this->root, this->comm);
+
+    this->time += omp_get_wtime() - start;
+    if (this->rank == this->root) {
+        this->bytes += sizeof(int) * this->size + (double)this->send_buffer.size();
+    }
+    else {
+        this->bytes += sizeof(int) + (double)received;
+    }
+
+    return this->receive_buffer.data();
+}
+
+/**
+ * Collect per record results on the root.
+ * @param  values     vector<float>, this rank's results, per_record for each
+ *                    of its records.
+ * @param  assignment vector<vector<int>>, records of each rank, only read on
+ *                    the root.
+ * @param  per_record size_t, values per record.
+ * @return            float pointer, on the root every rank's values in rank
+ *                    order, valid until the next gather. Null elsewhere.
+ */
+const float * Exchange::gather(const vector<float> & values,
+        const vector<vector<int>> & assignment, size_t per_record) {
+    size_t total = 0;
+    if (this->rank == this->root) {
+        total = this->layout(assignment, per_record);
+    }
+
+    double start = omp_get_wtime();
+    MPI_Gatherv(values.data(), values.size(), MPI_FLOAT, this->gather_buffer.data(),
+        this->gather_counts.data(), this->gather_displacements.data(), MPI_FLOAT,
+        this->root, this->comm);
+    this->time += omp_get_wtime() - start;
+
+    if (this->rank == this->root) {
+        this->bytes += sizeof(float) * (double)total;
+        return this->gather_buffer.data();
+    }
+
+    this->bytes += sizeof(float) * (double)values.size();
+    return nullptr;
+}
+
+/**
+ * Collect per record results on every rank, for replicated populations.
+ * @param  values     vector<float>, this rank's results, per_record for each
+ *                    of its records.
+ * @param  assignment vector<vector<int>>, records of each rank.
+ * @param  per_record size_t, values per record.
+ * @return            float pointer, every rank's values in rank order, valid
+ *                    until the next gather.
+ */
+const float * Exchange::all_gather(const vector<float> & values,
+        const vector<vector<int>> & assignment, size_t per_record) {
+    size_t total = this->layout(assignment, per_record);
+
+    double start = omp_get_wtime();
+    MPI_Allgatherv(values.data(), values.size(), MPI_FLOAT, this->gather_buffer.data(),
+        this->gather_counts.data(), this->gather_displacements.data(), MPI_FLOAT,
+        this->comm);
+    this->time += omp_get_wtime() - start;
+
+    // Each rank sends its share to every other rank and receives the rest.
+    this->bytes += sizeof(float) * ((double)values.size() * (this->size - 1)
+        + (double)(total - values.size()));
+    return this->gather_buffer.data();
+}
+
+/**
+ * Sum values over every rank, in place.
+ * @param values vector<float>, this rank's values, set to the sums.
+ */
+void Exchange::all_reduce(vector<float> & values) {
+    double start = omp_get_wtime();
+    MPI_Allreduce(MPI_IN_PLACE, values.data(), values.size(), MPI_FLOAT, MPI_SUM,
+        this->comm);
+    this->time += omp_get_wtime() - start;
+
+    // A ring reduction sends 2 (size - 1) / size of the values.
+    this->bytes += 2 * sizeof(float) * (double)values.size() * (this->size - 1)
+        / this->size;
+}
+
+/**
+ * Set the gather counts and displacements from the assignment and make
+ * room for the result.
+ * @param  assignment vector<vector<int>>, records of each rank or node.
+ * @param  per_record size_t, values per record.
+ * @return            size_t, total values gathered.
+ */
+size_t Exchange::layout(const vector<vector<int>> & assignment, size_t per_record) {
+    size_t total = 0;
+    for (size_t i = 0; i < assignment.size(); i++) {
+        this->gather_counts[i] = assignment[i].size() * per_record;
+        this->gather_displacements[i] = total;
+        total += this->gather_counts[i];
+    }
+
+    if (this->gather_buffer.size() < total) {
+        this->gather_buffer.resize(total);
+    }
+
+    return total;
+}
+
+/**
+ * Expose capacity floats on the root for the other ranks to put results
+ * into, collective. The window stays in one passive target epoch for the
+ * rest of the run, so putting never waits for the root.
+ * @param capacity size_t, floats on the root.
+ */
+void Exchange::open_window(size_t capacity) {
+    MPI_Aint bytes = (this->rank == this->root) ? capacity * sizeof(float) : 0;
+    MPI_Win_allocate(bytes, sizeof(float), MPI_INFO_NULL, this->comm,
+        &this->window_base, &this->window);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, this->window);
+}
+
+/**
+ * Records held by lower ranks, collective. With each rank's records a
+ * contiguous range in rank order, this is the index of its first record.
+ * @param  records size_t, records of this rank.
+ * @return         size_t, records of ranks below this one.
+ */
+size_t Exchange::record_offset(size_t records) {
+    uint64_t mine = records, offset = 0;
+
+    double start = omp_get_wtime();
+    MPI_Exscan(&mine, &offset, 1, MPI_UINT64_T, MPI_SUM, this->comm);
+    this->time += omp_get_wtime() - start;
+    this->bytes += sizeof(uint64_t);
+
+    return (this->rank == 0) ? 0 : offset;
+}
+
+/**
+ * Write this rank's results at their index in the root's window, record k
+ * going to index first + k * stride. The root stores its own directly.
+ * @param values     float pointer, per_record values for each record.
+ * @param records    size_t
+ * @param per_record size_t, values per record.
+ * @param region     size_t, floats into the window where the array starts.
+ * @param first      size_t, index of the first record.
+ * @param stride     size_t, indices between records.
+ */
+void Exchange::put(const float * values, size_t records, size_t per_record,
+        size_t region, size_t first, size_t stride) {
+    if (records == 0) {
+        return;
+    }
+
+    if (this->rank == this->root) {
+        for (size_t k = 0; k < records; k++) {
+            std::copy(values + k * per_record, values + (k + 1) * per_record,
+                this->window_base + region + (first + k * stride) * per_record);
+        }
+        return;
+    }
+
+    double start = omp_get_wtime();
+    MPI_Datatype target;
+    MPI_Type_vector(records, per_record, stride * per_record, MPI_FLOAT, &target);
+    MPI_Type_commit(&target);
+    MPI_Put(values, records * per_record, MPI_FLOAT, this->root,
+        region + first * per_record, 1, target, this->window);
+    MPI_Type_free(&target);
+    this->time += omp_get_wtime() - start;
+    this->bytes += sizeof(float) * (double)(records * per_record);
+}
+
+/**
+ * Complete this rank's puts at the root. Anything the root receives from
+ * this rank afterwards is ordered after the results.
+ */
+void Exchange::flush() {
+    if (this->rank == this->root) {
+        return;
+    }
+
+    double start = omp_get_wtime();
+    MPI_Win_flush(this->root, this->window);
+    this->time += omp_get_wtime() - start;
+}
+
+/**
+ * Root only. The exposed array, once every rank has flushed.
+ * @param  count size_t, floats the ranks put, for the byte count.
+ * @return       float pointer, valid until the ranks put again.
+ */
+const float * Exchange::exposed(size_t count) {
+    MPI_Win_sync(this->window);
+    this->bytes += sizeof(float) * (double)count;
+    return this->window_base;
+}
+
+/**
+ * Hand each node its records, collective. Only leaders take part in the
+ * scatter, they receive straight into the node's records window.
+ * @param  received int, set to the number of bytes of the node's records.
+ * @return          uint8_t pointer, the node's records, valid until the next
+ *                  scatter.
+ */
+const uint8_t * Exchange::scatter_nodes(int & received) {
+    double start = omp_get_wtime();
+
+    received = 0;
+    if (this->leader_comm != MPI_COMM_NULL) {
+        MPI_Scatter(this->send_counts.data(), 1, MPI_INT, &received, 1, MPI_INT,
+            this->leader_root, this->leader_comm);
+    }
+    MPI_Bcast(&received, 1, MPI_INT, 0, this->node_comm);
+    this->records_window.reserve(this->node_comm, received);
+
+    if (this->leader_comm != MPI_COMM_NULL) {
+        MPI_Scatterv(this->send_buffer.data(), this->send_counts.data(),
+            this->send_displacements.data(), MPI_BYTE, this->records_window.data(),
+            received, MPI_BYTE, this->leader_root, this->leader_comm);
+    }
+    this->records_window.synchronize(this->node_comm);
+
+    this->time += omp_get_wtime() - start;
+    if (this->rank == this->root) {
+        this->bytes += sizeof(int) * this->num_nodes + (double)this->send_buffer.size();
+    }
+    else if (this->node_rank == 0) {
+        this->bytes += sizeof(int) + (double)received;
+    }
+
+    return this->records_window.data();
+}
+
+/**
+ * Room for the node's results, collective over the node. Each rank writes
+ * the results of its records at their index.
+ * @param  count size_t, floats for the whole node.
+ * @return       float pointer, valid until the next call.
+ */
+float * Exchange::node_results(size_t count) {
+    this->node_count = count;
+    this->results_window.reserve(this->node_comm, count * sizeof(float));
+    return (float *)this->results_window.data();
+}
+
+/**
+ * Collect every node's results on the root, collective. Leaders send their
+ * node's window once every rank of the node has written its part.
+ * @param  assignment vector<vector<int>>, records of each node, only read on
+ *                    the root.
+ * @param  per_record size_t, values per record.
+ * @return            float pointer, on the root every node's values in node
+ *                    order, valid until the next gather. Null elsewhere.
+ */
+const float * Exchange::gather_nodes(const vector<vector<int>> & assignment,
+        size_t per_record) {
+    double start = omp_get_wtime();
+    this->results_window.synchronize(this->node_comm);
+
+    size_t total = 0;
+    if (this->rank == this->root) {
+        total = this->layout(assignment, per_record);
+    }
+
+    if (this->leader_comm != MPI_COMM_NULL) {
+        MPI_Gatherv(this->results_window.data(), this->node_count, MPI_FLOAT,
+            this->gather_buffer.data(), this->gather_counts.data(),
+            this->gather_displacements.data(), MPI_FLOAT, this->leader_root,
+            this->leader_comm);
+    }
+    this->time += omp_get_wtime() - start;
+
+    if (this->rank == this->root) {
+        this->bytes += sizeof(float) * (double)total;
+        return this->gather_buffer.data();
+    }
+
+    if (this->node_rank == 0) {
+        this->bytes += sizeof(float) * (double)this->node_count;
+    }
+    return nullptr;
+}
+
+/**
+ * Leaders put their node's results into the root's window, collective. The
+ * node's records are one range of indices, found by a scan over leaders,
+ * its window holds every fitness and then every error row.
+ * @param records   size_t, records of the node.
+ * @param num_cases size_t, errors per record, 0 for none.
+ * @param region    size_t, where errors start in the root's window.
+ */
+void Exchange::put_nodes(size_t records, size_t num_cases, size_t region) {
+    this->results_window.synchronize(this->node_comm);
+    if (this->leader_comm == MPI_COMM_NULL) {
+        return;
+    }
+
+    uint64_t mine = records, first = 0;
+    double start = omp_get_wtime();
+    MPI_Exscan(&mine, &first, 1, MPI_UINT64_T, MPI_SUM, this->leader_comm);
+    this->time += omp_get_wtime() - start;
+    if (this->node == 0) {
+        first = 0;
+    }
+
+    const float * results = (const float *)this->results_window.data();
+    this->put(results, records, 1, 0, first, 1);
+    if (num_cases > 0) {
+        this->put(results + records, records, num_cases, region, first, 1);
+    }
+    this->flush();
+}
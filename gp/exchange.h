@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "transport.h"
+#include "serialization.h"
+#include "shared_window.h"
+
+using std::vector;
+
+/**
+ * Collective exchange of one generation in hybrid mode. The root packs the
+ * records of every rank back to back in one buffer and hands them out with
+ * MPI_Scatterv, results come back with MPI_Gatherv. Buffers are members and
+ * only ever grow, so a run allocates them a handful of times. Bytes moved
+ * and time spent in the collectives are counted on every rank, the root's
+ * counts include every rank's share.
+ *
+ * With more than one chunk per rank the records are streamed instead: every
+ * chunk is its own non-blocking message, so a rank evaluates its first chunk
+ * while the rest are in flight and returns each chunk's results as soon as
+ * they are ready.
+ *
+ * After share_nodes the split can be made in two levels: the root only
+ * talks to one leader rank per node, so its traffic scales with the number
+ * of nodes. A node's records land in a shared-memory window that the ranks
+ * of the node read in place, they write their results into a second window
+ * that the leader sends on.
+ *
+ * After open_window results can skip the gather: the root exposes one array
+ * of floats as an RMA window and every rank puts its results straight at
+ * their final index, completed by a single flush.
+ */
+class Exchange {
+public:
+    Exchange(int _rank, int _size, int _root, MPI_Comm _comm = MPI_COMM_WORLD) :
+        rank(_rank), size(_size), root(_root), comm(_comm),
+        send_counts(_size, 0), send_displacements(_size, 0),
+        gather_counts(_size, 0), gather_displacements(_size, 0) {}
+    ~Exchange();
+    Exchange(const Exchange &) = delete;
+    Exchange & operator=(const Exchange &) = delete;
+
+    void share_nodes();
+    const uint8_t * scatter_nodes(int & received);
+    float * node_results(size_t count);
+    const float * gather_nodes(const vector<vector<int>> & assignment,
+                               size_t per_record);
+    void put_nodes(size_t records, size_t num_cases, size_t region);
+
+    int get_num_nodes() const { return this->num_nodes; }
+    int get_node_rank() const { return this->node_rank; }
+    int get_node_size() const { return this->node_size; }
+
+    /**
+     * Root only. Ranks on each node, the weights of a split over nodes.
+     */
+    const vector<double> & get_node_sizes() const { return this->node_sizes; }
+
+    void broadcast(void * data, int count, MPI_Datatype type);
+    void pack(const vector<vector<int>> & assignment,
+              const vector<GenomeView> & unique);
+    void stream(const vector<vector<int>> & assignment, size_t per_record);
+    const uint8_t * chunk(int c, int & length);
+    void send_results(int c, vector<float> & results);
+    bool collect(int & source, int & c, const float * & results);
+    void finish();
+    static void chunk_range(size_t records, int c, int chunks, size_t & begin,
+                            size_t & end);
+    const uint8_t * scatter(int & received);
+    const float * gather(const vector<float> & values,
+                         const vector<vector<int>> & assignment,
+                         size_t per_record);
+    const float * all_gather(const vector<float> & values,
+                             const vector<vector<int>> & assignment,
+                             size_t per_record);
+    void all_reduce(vector<float> & values);
+
+    void open_window(size_t capacity);
+    size_t record_offset(size_t records);
+    void put(const float * values, size_t records, size_t per_record,
+             size_t region, size_t first, size_t stride);
+    void flush();
+    const float * exposed(size_t count);
+
+    /**
+     * Messages each rank's records are streamed in, 1 scatters them whole.
+     */
+    void set_chunks(int _chunks) { this->chunks = _chunks; }
+    int get_chunks() const { return this->chunks; }
+
+    /**
+     * Count traffic that went around the collectives.
+     */
+    void add(double _bytes, double _time) { this->bytes += _bytes; this->time += _time; }
+
+    /**
+     * Start counting a new generation.
+     */
+    void reset_stats() { this->bytes = 0; this->time = 0; }
+    double get_bytes() const { return this->bytes; }
+    double get_time() const { return this->time; }
+
+private:
+    int rank;
+    int size;
+    int root;
+    MPI_Comm comm;
+
+    vector<uint8_t> send_buffer;      // Root, records of every rank.
+    vector<int> send_counts;          // Root, bytes for each rank.
+    vector<int> send_displacements;
+    vector<uint8_t> receive_buffer;   // This rank's records.
+    vector<float> gather_buffer;      // Results of every rank in rank order.
+    vector<int> gather_counts;
+    vector<int> gather_displacements;
+
+    int chunks = 1;
+    vector<int> chunk_counts;          // Bytes of each chunk, rank major.
+    vector<int> chunk_displacements;   // Offsets into the send or receive buffer.
+    vector<MPI_Request> chunk_requests;
+    vector<MPI_Request> result_requests;
+    vector<vector<float>> result_chunks;  // This rank's results in flight.
+    vector<int> result_sources;        // Root, rank and chunk of each result
+    vector<int> result_indices;        // request.
+    vector<size_t> result_offsets;     // Root, offsets into gather_buffer.
+
+    // Node aware exchange, see share_nodes.
+    MPI_Comm node_comm = MPI_COMM_NULL;   // Ranks sharing memory.
+    MPI_Comm leader_comm = MPI_COMM_NULL; // Rank 0 of every node.
+    int node = 0;                      // Index of this node, leaders in rank order.
+    int node_rank = 0;
+    int node_size = 1;
+    int num_nodes = 1;
+    int leader_root = 0;               // Root's rank in leader_comm.
+    vector<double> node_sizes;         // Ranks on each node.
+    size_t node_count = 0;             // Results of this node, node_results.
+    SharedWindow records_window;       // This node's records.
+    SharedWindow results_window;       // This node's results.
+
+    MPI_Win window = MPI_WIN_NULL;     // Results put on the root, see open_window.
+    float * window_base = nullptr;     // Root, the exposed array.
+
+    size_t layout(const vector<vector<int>> & assignment, size_t per_record);
+
+    double bytes = 0; // Since reset_stats.
+    double time = 0;  // Seconds in collectives since reset_stats.
+};
@@ -1,17 +1,31 @@
 #include<set>
 #include<cmath>
+#include<cstdlib>
 #include<stack>
 #include<memory>
 #include<string>
+#include<vector>
 #include<sstream>
+#include<algorithm>
 #include<iostream>
 #include "evaluation.h"
 #include "individual.h"
+#include "serialization.h"
 
 using std::endl; using std::cout;
 using std::string; using std::make_shared; using std::shared_ptr;
 
 
+/**
+ * Make this node a constant. The value is the shortest text that parses
+ * back to the same float, so text and binary genomes agree exactly.
+ * @param _constant float
+ */
+void RPNNode::set_constant(float _constant) {
+    this->constant = _constant;
+    this->value = Serialization::format_constant(_constant);
+}
+
 // void print_stack(std::stack<node_ptr> s) {
 //     std::stack<node_ptr> c = s; // Copy
 //     cout << "Stack: ";
@@ -48,6 +62,9 @@ void RPNTree::build_tree(const string & rpn_string) {
             // Variable or constant, push onto stack.
             a = make_shared<RPNNode>();
             a->value = current_val;
+            if (! Evaluation::is_variable(current_val)) {
+                a->constant = strtof(current_val.c_str(), nullptr);
+            }
 
             node_stack.push(a);
         }
@@ -82,6 +99,7 @@ node_ptr RPNTree::copy_of(node_ptr current, node_ptr parent) {
     // Make a copy of the current node.
     node_ptr new_current = make_shared<RPNNode>();
     new_current->value = current->value;
+    new_current->constant = current->constant;
     new_current->parent = parent;
 
     // Recursively copy.
@@ -171,6 +189,56 @@ int RPNTree::num_nodes() {
     return num_nodes_recursive(this->root);
 }
 
+/**
+ * Depth of the subtree at a node.
+ * @param  node node_ptr, current node.
+ * @return      int, 1 for a leaf.
+ */
+int depth_recursive(const node_ptr node) {
+    int left = (node->left != nullptr) ? depth_recursive(node->left) : 0;
+    int right = (node->right != nullptr) ? depth_recursive(node->right) : 0;
+
+    return 1 + std::max(left, right);
+}
+
+/**
+ * Return the depth of the tree, a single node has depth 1.
+ * @return int
+ */
+int RPNTree::depth() {
+    return depth_recursive(this->root);
+}
+
+/**
+ * Post order traversal that records the size of every subtree.
+ * @param  node  node_ptr, current node.
+ * @param  sizes vector<int>, appended in post order.
+ * @return       int, size of the subtree at node.
+ */
+int subtree_sizes_recursive(const node_ptr node, std::vector<int> & sizes) {
+    int count = 1;
+
+    if (node->left != nullptr) {
+        count += subtree_sizes_recursive(node->left, sizes);
+    }
+    if (node->right != nullptr) {
+        count += subtree_sizes_recursive(node->right, sizes);
+    }
+
+    sizes.push_back(count);
+    return count;
+}
+
+/**
+ * Size of the subtree rooted at each node, indexed like node_at.
+ * @return vector<int>
+ */
+std::vector<int> RPNTree::subtree_sizes() {
+    std::vector<int> sizes;
+    subtree_sizes_recursive(this->root, sizes);
+    return sizes;
+}
+
 
 
 /**
@@ -4,6 +4,7 @@
 #include<stack>
 #include<memory>
 #include<string>
+#include<vector>
 #include<iostream>
 #include<sstream>
 
@@ -41,7 +42,10 @@ struct RPNNode {
 
     bool is_leaf() const { return this->left == nullptr && this->right == nullptr; }
 
+    void set_constant(float _constant);
+
     string value;
+    float constant = 0; // Full precision value, when value is a constant.
     node_ptr parent = nullptr;
     node_ptr left = nullptr;
     node_ptr right = nullptr;
@@ -76,6 +80,8 @@ public:
     static void post_order_traversal(node_ptr node, string & out);
     string post_order() const;
     int num_nodes();
+    int depth();
+    std::vector<int> subtree_sizes();
     node_ptr node_at(int idx);
 
     node_ptr get_root() const { return this->root; }
@@ -0,0 +1,250 @@
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <iostream>
+#include "evaluation.h"
+#include "linear.h"
+
+using std::endl;
+using std::string; using std::vector;
+const uint8_t LinearProgram::NUM_REGISTERS;
+const uint8_t LinearProgram::CONSTANT;
+const int LinearProgram::MAX_LENGTH;
+
+/**
+ * Determine if the second operand is the instruction's constant.
+ * @return bool
+ */
+bool Instruction::uses_constant() const {
+    return this->src_b == LinearProgram::CONSTANT;
+}
+
+/**
+ * Instructions are equal when they compute the same thing.
+ * @param  other Instruction
+ * @return       bool
+ */
+bool Instruction::operator==(const Instruction & other) const {
+    return this->op == other.op && this->dst == other.dst
+        && this->src_a == other.src_a && this->src_b == other.src_b
+        && this->constant == other.constant;
+}
+
+/**
+ * Apply a single operation, division is protected like in the tree engine.
+ * @param  op uint8_t, index into Evaluation::OPERATIONS.
+ * @param  a  float
+ * @param  b  float
+ * @return    float
+ */
+static inline float apply(uint8_t op, float a, float b) {
+    switch (op) {
+        case 0: return a + b;
+        case 1: return a - b;
+        case 2: return a * b;
+        default: return (b == 0) ? 1 : a / b;
+    }
+}
+
+/**
+ * Mark the instructions that can influence the output register.
+ * This is a single backward pass, everything not marked is an intron.
+ * @return vector<bool>, true at effective instructions.
+ */
+vector<bool> LinearProgram::effective_instructions() const {
+    vector<bool> effective(this->instructions.size(), false);
+    bool needed[NUM_REGISTERS] = {false};
+    needed[0] = true; // Output register.
+
+    for (int i = this->instructions.size() - 1; i >= 0; i--) {
+        const Instruction & instr = this->instructions[i];
+
+        if (needed[instr.dst]) {
+            effective[i] = true;
+            needed[instr.dst] = false;
+            needed[instr.src_a] = true;
+
+            if (! instr.uses_constant()) {
+                needed[instr.src_b] = true;
+            }
+        }
+    }
+
+    return effective;
+}
+
+/**
+ * Count the effective (non-intron) instructions.
+ * @return int
+ */
+int LinearProgram::num_effective() const {
+    vector<bool> effective = this->effective_instructions();
+    int count = 0;
+
+    for (size_t i = 0; i < effective.size(); i++) {
+        count += effective[i];
+    }
+
+    return count;
+}
+
+/**
+ * Run the program on a single input.
+ * @param  x float
+ * @return   float, value left in register 0.
+ */
+float LinearProgram::evaluate(const float & x) const {
+    float registers[NUM_REGISTERS];
+    for (int r = 0; r < NUM_REGISTERS; r++) {
+        registers[r] = x;
+    }
+
+    for (size_t i = 0; i < this->instructions.size(); i++) {
+        const Instruction & instr = this->instructions[i];
+        float b = instr.uses_constant() ? instr.constant : registers[instr.src_b];
+        registers[instr.dst] = apply(instr.op, registers[instr.src_a], b);
+    }
+
+    return registers[0];
+}
+
+/**
+ * Run the program on every sample at once, skipping introns.
+ * Each instruction is applied across all samples so the inner loops vectorize.
+ * @param samples vector<float>
+ * @param out     vector<float>, resized to the number of samples.
+ */
+void LinearProgram::evaluate(const vector<float> & samples, vector<float> & out) const {
+    const size_t n = samples.size();
+    vector<float> registers(NUM_REGISTERS * n);
+    vector<bool> effective = this->effective_instructions();
+
+    for (int r = 0; r < NUM_REGISTERS; r++) {
+        std::copy(samples.begin(), samples.end(), registers.begin() + r * n);
+    }
+
+    for (size_t i = 0; i < this->instructions.size(); i++) {
+        if (! effective[i]) {
+            continue;
+        }
+
+        const Instruction & instr = this->instructions[i];
+        float * dst = &registers[instr.dst * n];
+        const float * a = &registers[instr.src_a * n];
+
+        if (instr.uses_constant()) {
+            const float c = instr.constant;
+            switch (instr.op) {
+                case 0: for (size_t s = 0; s < n; s++) dst[s] = a[s] + c; break;
+                case 1: for (size_t s = 0; s < n; s++) dst[s] = a[s] - c; break;
+                case 2: for (size_t s = 0; s < n; s++) dst[s] = a[s] * c; break;
+                default: for (size_t s = 0; s < n; s++) dst[s] = (c == 0) ? 1 : a[s] / c;
+            }
+        }
+        else {
+            const float * b = &registers[instr.src_b * n];
+            switch (instr.op) {
+                case 0: for (size_t s = 0; s < n; s++) dst[s] = a[s] + b[s]; break;
+                case 1: for (size_t s = 0; s < n; s++) dst[s] = a[s] - b[s]; break;
+                case 2: for (size_t s = 0; s < n; s++) dst[s] = a[s] * b[s]; break;
+                default: for (size_t s = 0; s < n; s++) dst[s] = (b[s] == 0) ? 1 : a[s] / b[s];
+            }
+        }
+    }
+
+    out.assign(registers.begin(), registers.begin() + n);
+}
+
+/**
+ * Serialize the program, one "op dst src_a src_b constant" group per
+ * instruction, separated by ';'. Constants are printed with full precision.
+ * @return string
+ */
+string LinearProgram::to_string() const {
+    string out = "";
+    char buffer[64];
+
+    for (size_t i = 0; i < this->instructions.size(); i++) {
+        const Instruction & instr = this->instructions[i];
+        snprintf(buffer, sizeof(buffer), "%c %d %d %d %.9g;",
+            Evaluation::OPERATIONS[instr.op], instr.dst, instr.src_a,
+            instr.src_b, instr.constant);
+        out += buffer;
+    }
+
+    return out;
+}
+
+/**
+ * Human readable listing of the effective instructions.
+ * @return string, e.g. "r1 = r0 * 2.5; r0 = r1 + r2; "
+ */
+string LinearProgram::get_listing() const {
+    vector<bool> effective = this->effective_instructions();
+    std::stringstream ss;
+
+    for (size_t i = 0; i < this->instructions.size(); i++) {
+        if (! effective[i]) {
+            continue;
+        }
+
+        const Instruction & instr = this->instructions[i];
+        ss << "r" << (int)instr.dst << " = r" << (int)instr.src_a << " "
+           << Evaluation::OPERATIONS[instr.op] << " ";
+
+        if (instr.uses_constant()) {
+            ss << instr.constant;
+        }
+        else {
+            ss << "r" << (int)instr.src_b;
+        }
+        ss << "; ";
+    }
+
+    return ss.str();
+}
+
+/**
+ * Parse the output of to_string.
+ * @param text string
+ */
+void LinearProgram::parse(const string & text) {
+    std::stringstream ss(text);
+    string current;
+
+    while (getline(ss, current, ';')) {
+        if (current.empty()) {
+            continue;
+        }
+
+        Instruction instr;
+        char op;
+        int dst, src_a, src_b;
+        std::stringstream fields(current);
+        fields >> op >> dst >> src_a >> src_b;
+        instr.constant = strtof(current.substr(fields.tellg()).c_str(), nullptr);
+
+        for (size_t o = 0; o < Evaluation::OPERATIONS.size(); o++) {
+            if (Evaluation::OPERATIONS[o] == op) {
+                instr.op = o;
+            }
+        }
+        instr.dst = dst;
+        instr.src_a = src_a;
+        instr.src_b = src_b;
+
+        this->instructions.push_back(instr);
+    }
+}
+
+/**
+ * Ostream definition for printing linear individuals.
+ */
+std::ostream & operator<<(std::ostream & os, const LinearIndividual & indv) {
+    os << "Program: " << indv.get_program().to_string() <<
+        "\nEffective: " << indv.get_program().get_listing() << endl;
+    return os;
+}
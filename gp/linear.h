@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+
+using std::string; using std::vector; using std::shared_ptr;
+
+class LinearIndividual;
+typedef shared_ptr<LinearIndividual> linear_indv_ptr;
+
+/**
+ * A single register machine instruction:
+ *     r[dst] = r[src_a] op r[src_b]
+ * When src_b is LinearProgram::CONSTANT the instruction's constant is used in
+ * place of the second register.
+ */
+struct Instruction {
+    uint8_t op = 0;      // Index into Evaluation::OPERATIONS.
+    uint8_t dst = 0;     // Destination register.
+    uint8_t src_a = 0;   // First operand register.
+    uint8_t src_b = 0;   // Second operand register or CONSTANT.
+    float constant = 0;  // Only meaningful when src_b == CONSTANT.
+
+    bool uses_constant() const;
+    bool operator==(const Instruction & other) const;
+};
+
+/**
+ * Linear genetic program, a sequence of register machine instructions.
+ * Every register starts out holding x and the output is read from register 0.
+ */
+class LinearProgram {
+public:
+    static const uint8_t NUM_REGISTERS = 4;
+    static const uint8_t CONSTANT = NUM_REGISTERS; // Marks a constant operand.
+    static const int MAX_LENGTH = 256;
+
+    LinearProgram() {}
+
+    /**
+     * Constructor with instructions.
+     * @param _instructions vector<Instruction>
+     */
+    LinearProgram(const vector<Instruction> & _instructions) :
+        instructions(_instructions) {}
+
+    /**
+     * Constructor, parses the output of to_string.
+     * @param text string, ';' separated instructions.
+     */
+    explicit LinearProgram(const string & text) { this->parse(text); }
+
+    vector<bool> effective_instructions() const;
+    int num_effective() const;
+    float evaluate(const float & x) const;
+    void evaluate(const vector<float> & samples, vector<float> & out) const;
+    string to_string() const;
+    string get_listing() const;
+
+    int length() const { return this->instructions.size(); }
+    vector<Instruction> & get_instructions() { return this->instructions; }
+    const vector<Instruction> & get_instructions() const { return this->instructions; }
+
+private:
+    void parse(const string & text);
+
+    vector<Instruction> instructions;
+};
+
+class LinearIndividual {
+public:
+    /**
+     * Constructor with a program.
+     * @param _program LinearProgram
+     */
+    LinearIndividual(const LinearProgram & _program) : program(_program) {}
+
+    /**
+     * Constructor, parses the output of LinearProgram::to_string.
+     * @param text string
+     */
+    LinearIndividual(const string & text) : program(text) {}
+
+    LinearProgram & get_program() { return this->program; }
+    const LinearProgram & get_program() const { return this->program; }
+    float get_fitness() const { return this->fitness; }
+    void set_fitness(float f) { this->fitness = f; }
+    friend std::ostream & operator<<(std::ostream & os, const LinearIndividual & indv);
+
+private:
+    LinearProgram program;
+    float fitness = HUGE_VALF;
+};
@@ -0,0 +1,187 @@
+#include <random>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include "evaluation.h"
+#include "evolution.h"
+#include "linear.h"
+#include "linear_population.h"
+#include "linear_evolution.h"
+
+using std::make_shared;
+using std::mt19937;
+using std::uniform_int_distribution;
+
+/**
+ * Make a random instruction. Half of the instructions use a constant operand.
+ * @param  engine Engine, mt19937 or Philox.
+ * @return        Instruction
+ */
+template <typename Engine>
+Instruction LinearEvolution::random_instruction(Engine & engine) {
+    uniform_int_distribution<int> random_op(0, Evaluation::OPERATIONS.size() - 1);
+    uniform_int_distribution<int> random_register(0, LinearProgram::NUM_REGISTERS - 1);
+
+    Instruction instr;
+    instr.op = random_op(engine);
+    instr.dst = random_register(engine);
+    instr.src_a = random_register(engine);
+
+    if (Evolution::COIN_FLIP(engine)) {
+        instr.src_b = LinearProgram::CONSTANT;
+        instr.constant = Evolution::EPHEMERAL_RANDOM_CONSTANTS(engine);
+    }
+    else {
+        instr.src_b = random_register(engine);
+    }
+
+    return instr;
+}
+
+/**
+ * Create a random program of a given length.
+ * @param  length int, number of instructions.
+ * @param  engine Engine, mt19937 or Philox.
+ * @return        linear_indv_ptr
+ */
+template <typename Engine>
+linear_indv_ptr LinearEvolution::random_program(int length, Engine & engine) {
+    vector<Instruction> instructions(length);
+
+    for (int i = 0; i < length; i++) {
+        instructions[i] = random_instruction(engine);
+    }
+
+    return make_shared<LinearIndividual>(LinearProgram(instructions));
+}
+
+/**
+ * Two point crossover. A random segment of parent_a is replaced with a random
+ * segment of parent_b. Produces one new individual. With SIZE_FAIR the
+ * inserted segment is at most 1 + 2x the length of the one it replaces.
+ * @param  parent_a      linear_indv_ptr
+ * @param  parent_b      linear_indv_ptr
+ * @param  engine        Engine, mt19937 or Philox.
+ * @param  bloat_control int, Evolution::BloatControl flags.
+ * @return               linear_indv_ptr
+ */
+template <typename Engine>
+linear_indv_ptr LinearEvolution::crossover(linear_indv_ptr parent_a,
+                                           linear_indv_ptr parent_b,
+                                           Engine & engine, int bloat_control) {
+    const vector<Instruction> & a = parent_a->get_program().get_instructions();
+    const vector<Instruction> & b = parent_b->get_program().get_instructions();
+
+    // Segment [start_a, start_a + length_a) of a is replaced.
+    int start_a = uniform_int_distribution<int>(0, a.size() - 1)(engine);
+    int length_a = uniform_int_distribution<int>(1, a.size() - start_a)(engine);
+    int start_b = uniform_int_distribution<int>(0, b.size() - 1)(engine);
+    int max_length_b = b.size() - start_b;
+
+    if (bloat_control & Evolution::SIZE_FAIR) {
+        max_length_b = std::min(max_length_b, 1 + 2 * length_a);
+    }
+
+    int length_b = uniform_int_distribution<int>(1, max_length_b)(engine);
+
+    if (a.size() - length_a + length_b > LinearProgram::MAX_LENGTH) {
+        return make_shared<LinearIndividual>(*parent_a);
+    }
+
+    vector<Instruction> child;
+    child.reserve(a.size() - length_a + length_b);
+    child.insert(child.end(), a.begin(), a.begin() + start_a);
+    child.insert(child.end(), b.begin() + start_b, b.begin() + start_b + length_b);
+    child.insert(child.end(), a.begin() + start_a + length_a, a.end());
+
+    return make_shared<LinearIndividual>(LinearProgram(child));
+}
+
+/**
+ * Mutate an individual. With equal probability either one field of a random
+ * instruction is changed (micro mutation) or an instruction is inserted or
+ * deleted (macro mutation).
+ * @param  indv   linear_indv_ptr
+ * @param  engine Engine, mt19937 or Philox.
+ * @return        linear_indv_ptr, pointer to the same individual, not a copy.
+ */
+template <typename Engine>
+linear_indv_ptr LinearEvolution::mutation(linear_indv_ptr indv, Engine & engine) {
+    vector<Instruction> & instructions = indv->get_program().get_instructions();
+    uniform_int_distribution<int> random_index(0, instructions.size() - 1);
+    int index = random_index(engine);
+
+    // Micro mutation.
+    if (Evolution::COIN_FLIP(engine)) {
+        Instruction & instr = instructions[index];
+        Instruction fresh = random_instruction(engine);
+
+        switch (uniform_int_distribution<int>(0, 3)(engine)) {
+            case 0:
+                instr.op = fresh.op;
+                break;
+            case 1:
+                instr.dst = fresh.dst;
+                break;
+            case 2:
+                instr.src_a = fresh.src_a;
+                break;
+            default:
+                instr.src_b = fresh.src_b;
+                instr.constant = fresh.constant;
+        }
+    }
+    // Macro mutation, insertion.
+    else if (instructions.size() < LinearProgram::MAX_LENGTH
+             && (instructions.size() == 1 || Evolution::COIN_FLIP(engine))) {
+        instructions.insert(instructions.begin() + index, random_instruction(engine));
+    }
+    // Macro mutation, deletion.
+    else if (instructions.size() > 1) {
+        instructions.erase(instructions.begin() + index);
+    }
+
+    return indv;
+}
+
+/**
+ * Select an individual from the population.
+ * @param  population      LinearPopulation pointer
+ * @param  engine          Engine, mt19937 or Philox.
+ * @param  tournament_size size_t, number of individuals in tournament.
+ * @return                 linear_indv_ptr, winner of tournament.
+ */
+template <typename Engine>
+linear_indv_ptr LinearEvolution::tournament_selection(LinearPopulation * population,
+                                                      Engine & engine,
+                                                      size_t tournament_size) {
+    uniform_int_distribution<size_t> random_indv(0, population->get_length() - 1);
+    linear_indv_ptr winner = (*population)[random_indv(engine)];
+
+    for (size_t i = 1; i < tournament_size; i++) {
+        linear_indv_ptr contender = (*population)[random_indv(engine)];
+
+        if (contender->get_fitness() < winner->get_fitness()) {
+            winner = contender;
+        }
+    }
+
+    return winner;
+}
+
+template Instruction LinearEvolution::random_instruction<mt19937>(mt19937 &);
+template Instruction LinearEvolution::random_instruction<Philox>(Philox &);
+template linear_indv_ptr LinearEvolution::random_program<mt19937>(int, mt19937 &);
+template linear_indv_ptr LinearEvolution::random_program<Philox>(int, Philox &);
+template linear_indv_ptr LinearEvolution::crossover<mt19937>(linear_indv_ptr,
+    linear_indv_ptr, mt19937 &, int);
+template linear_indv_ptr LinearEvolution::crossover<Philox>(linear_indv_ptr,
+    linear_indv_ptr, Philox &, int);
+template linear_indv_ptr LinearEvolution::mutation<mt19937>(linear_indv_ptr,
+    mt19937 &);
+template linear_indv_ptr LinearEvolution::mutation<Philox>(linear_indv_ptr,
+    Philox &);
+template linear_indv_ptr LinearEvolution::tournament_selection<mt19937>(
+    LinearPopulation *, mt19937 &, size_t);
+template linear_indv_ptr LinearEvolution::tournament_selection<Philox>(
+    LinearPopulation *, Philox &, size_t);
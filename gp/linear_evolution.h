@@ -0,0 +1,33 @@
+#pragma once
+
+#include <random>
+#include <memory>
+#include "linear.h"
+#include "random.h"
+
+using std::mt19937;
+
+class LinearPopulation;
+
+/**
+ * Genetic operators for linear programs, mirrors Evolution for trees.
+ */
+struct LinearEvolution {
+    // Instantiated for mt19937 and Philox.
+    template <typename Engine>
+    static Instruction random_instruction(Engine & engine);
+    template <typename Engine>
+    static linear_indv_ptr random_program(int length, Engine & engine);
+    template <typename Engine>
+    static linear_indv_ptr crossover(linear_indv_ptr parent_a,
+                                     linear_indv_ptr parent_b, Engine & engine,
+                                     int bloat_control = 0);
+    template <typename Engine>
+    static linear_indv_ptr mutation(linear_indv_ptr indv, Engine & engine);
+    template <typename Engine>
+    static linear_indv_ptr tournament_selection(LinearPopulation * population,
+                                                Engine & engine,
+                                                size_t tournament_size);
+private:
+    LinearEvolution() {}
+};
@@ -0,0 +1,274 @@
+#include <cmath>
+#include <vector>
+#include <random>
+#include <memory>
+#include <algorithm>
+
+#include "evolution.h"
+#include "linear.h"
+#include "linear_evolution.h"
+#include "linear_population.h"
+
+using std::mt19937;
+using std::make_shared;
+using std::vector;
+
+/**
+ * Randomly initialize the population. Program lengths are ramped evenly
+ * between min_length and max_length, the linear analogue of ramped
+ * half-and-half. Built in parallel like Population::initialize.
+ * @param  engine     mt19937, Mersenne Twister random generator.
+ * @param  min_length int, shortest initial program.
+ * @param  max_length int, longest initial program.
+ */
+void LinearPopulation::initialize(mt19937 & engine, int min_length, int max_length) {
+    uint64_t seed = engine();
+    seed = (seed << 32) | engine();
+
+    this->initialize_shard(seed, min_length, max_length, 0, 1);
+}
+
+/**
+ * Build programs first, first + stride, ... of the population, see
+ * Population::initialize_shard. Program i has length min_length + i modulo
+ * the number of lengths.
+ * @param seed       uint64_t, key of the initialization streams.
+ * @param min_length int, shortest initial program.
+ * @param max_length int, longest initial program.
+ * @param first      size_t, index of the first program to build.
+ * @param stride     size_t, distance between built programs, 1 for all.
+ */
+void LinearPopulation::initialize_shard(uint64_t seed, int min_length,
+        int max_length, size_t first, size_t stride) {
+    int num_lengths = max_length - min_length + 1;
+    long count = (first < this->length) ? (this->length - first + stride - 1) / stride : 0;
+
+    this->population.assign(count, nullptr);
+
+    #pragma omp parallel for schedule(dynamic, INIT_CHUNK)
+    for (long k = 0; k < count; k++) {
+        size_t i = first + k * stride;
+        Philox engine(seed, 0, i, Philox::INITIALIZE);
+
+        this->population[k] = LinearEvolution::random_program(
+            min_length + i % num_lengths, engine);
+    }
+}
+
+/**
+ * Sorts the population.
+ */
+void LinearPopulation::sort() {
+    std::sort(this->population.begin(), this->population.end(),
+        [](const linear_indv_ptr & a, const linear_indv_ptr & b) -> bool
+        {
+            return a->get_fitness() < b->get_fitness();
+        });
+}
+
+/**
+ * Pick two parents by tournament over the live population (steady-state).
+ * @param engine   Philox
+ * @param parent_a linear_indv_ptr, set to the first winner.
+ * @param parent_b linear_indv_ptr, set to the second winner.
+ */
+void LinearPopulation::select_parents(Philox & engine, linear_indv_ptr & parent_a,
+        linear_indv_ptr & parent_b) {
+    parent_a = LinearEvolution::tournament_selection(this, engine,
+        this->TOURNAMENT_SIZE);
+    parent_b = LinearEvolution::tournament_selection(this, engine,
+        this->TOURNAMENT_SIZE);
+}
+
+/**
+ * Crossover or copy, then mutation. Parents are only read.
+ * @param  parent_a       linear_indv_ptr
+ * @param  parent_b       linear_indv_ptr
+ * @param  engine         Philox
+ * @param  crossover_rate float, [0, 1]
+ * @param  mutation_rate  float, [0, 1]
+ * @return                linear_indv_ptr, new individual.
+ */
+linear_indv_ptr LinearPopulation::vary(const linear_indv_ptr & parent_a,
+        const linear_indv_ptr & parent_b, Philox & engine,
+        const float & crossover_rate, const float & mutation_rate) {
+    linear_indv_ptr child;
+
+    // Copying a linear program is a single vector copy.
+    if (Evolution::RAND(engine) < crossover_rate) {
+        child = LinearEvolution::crossover(parent_a, parent_b, engine,
+            this->bloat_control);
+    }
+    else {
+        child = make_shared<LinearIndividual>(*parent_a);
+    }
+
+    if (Evolution::RAND(engine) < mutation_rate) {
+        child = LinearEvolution::mutation(child, engine);
+    }
+
+    return child;
+}
+
+/**
+ * Produce the children of places [start, end), see Population::breed.
+ * @param generation_seed uint64_t, key of this update's streams.
+ * @param start           size_t, first place.
+ * @param end             size_t, one past the last place.
+ * @param children        linear_pop_type, the new population, places set.
+ * @param crossover_rate  float, [0, 1]
+ * @param mutation_rate   float, [0, 1]
+ */
+void LinearPopulation::breed(uint64_t generation_seed, size_t start, size_t end,
+        linear_pop_type & children, const float & crossover_rate,
+        const float & mutation_rate) {
+    vector<Philox> engines;
+    vector<size_t> parents(2 * (end - start));
+    for (size_t i = start; i < end; i++) {
+        engines.emplace_back(generation_seed, this->generation, i, Philox::BREED);
+    }
+
+    this->selection.select_pairs(engines.data(), parents.data(), end - start);
+
+    for (size_t k = 0; k < end - start; k++) {
+        children[start + k] = this->vary(this->population[parents[2 * k]],
+            this->population[parents[2 * k + 1]], engines[k], crossover_rate,
+            mutation_rate);
+    }
+}
+
+/**
+ * Steady-state breeding, see Population::breed_steady_state.
+ * @param  engine         Philox, the child's own random stream.
+ * @param  crossover_rate float, [0, 1]
+ * @param  mutation_rate  float, [0, 1]
+ * @return                linear_indv_ptr
+ */
+linear_indv_ptr LinearPopulation::breed_steady_state(Philox & engine,
+        const float & crossover_rate, const float & mutation_rate) {
+    linear_indv_ptr parent_a, parent_b;
+
+    #pragma omp critical (population)
+    this->select_parents(engine, parent_a, parent_b);
+
+    return this->vary(parent_a, parent_b, engine, crossover_rate, mutation_rate);
+}
+
+/**
+ * Steady-state replacement, see Population::replace.
+ * @param child  linear_indv_ptr, with its fitness set.
+ * @param engine Philox
+ */
+void LinearPopulation::replace(const linear_indv_ptr & child, Philox & engine) {
+    #pragma omp critical (population)
+    {
+        size_t loser = engine.below(this->length);
+
+        for (int i = 1; i < this->TOURNAMENT_SIZE; i++) {
+            size_t contender = engine.below(this->length);
+
+            if (this->population[contender]->get_fitness()
+                > this->population[loser]->get_fitness()) {
+                loser = contender;
+            }
+        }
+
+        this->population[loser] = child;
+    }
+}
+
+/**
+ * Dynamic size limit in instructions, see Population::apply_size_limit.
+ * @param best_index size_t, index of the best individual.
+ */
+void LinearPopulation::apply_size_limit(const size_t & best_index) {
+    vector<int> sizes(this->length);
+
+    for (size_t i = 0; i < this->length; i++) {
+        sizes[i] = this->population[i]->get_program().length();
+    }
+
+    if (this->initial_size_limit == 0) {
+        this->initial_size_limit = *std::max_element(sizes.begin(), sizes.end());
+    }
+
+    this->size_limit = std::max(this->initial_size_limit, sizes[best_index]);
+
+    for (size_t i = 0; i < this->length; i++) {
+        if (sizes[i] > this->size_limit && i != best_index) {
+            this->population[i]->set_fitness(HUGE_VALF);
+        }
+    }
+}
+
+/**
+ * Update the population based on fitness. This is the reproduction step.
+ * Bred in parallel like Population::update, one random stream per child.
+ * @param engine         mt19937
+ * @param crossover_rate float, [0, 1]
+ * @param mutation_rate  float, [0, 1]
+ */
+void LinearPopulation::update(mt19937 & engine, const float & crossover_rate,
+        const float & mutation_rate) {
+    float best_fitness = HUGE_VALF;
+    size_t best_index = 0;
+    vector<linear_indv_ptr> new_population(this->length);
+    uint64_t generation_seed = engine();
+    generation_seed = (generation_seed << 32) | engine();
+
+    // Best individual and packed fitnesses, same as the tree population.
+    vector<float> fitnesses(this->length);
+    for (size_t i = 0; i < this->length; i++) {
+        fitnesses[i] = this->population[i]->get_fitness();
+
+        if (fitnesses[i] < best_fitness) {
+            best_fitness = fitnesses[i];
+            best_index = i;
+        }
+    }
+
+    if (this->bloat_control & Evolution::DYNAMIC_LIMIT) {
+        this->apply_size_limit(best_index);
+
+        for (size_t i = 0; i < this->length; i++) {
+            fitnesses[i] = this->population[i]->get_fitness();
+        }
+    }
+
+    // Pareto selection takes error and size apart, fitness is their sum.
+    if (this->selection.get_method() == Selection::PARETO) {
+        vector<float> errors(this->length), sizes(this->length);
+        for (size_t i = 0; i < this->length; i++) {
+            sizes[i] = this->population[i]->get_program().length();
+            errors[i] = fitnesses[i] - sizes[i];
+        }
+        this->selection.set_objectives(errors, sizes);
+    }
+
+    this->selection.prepare(fitnesses);
+
+    // Elitism of 1, or the first front under Pareto selection.
+    vector<size_t> elites = this->selection.elites(this->length / 2);
+    if (elites.empty()) {
+        elites.push_back(best_index);
+    }
+    for (size_t e = 0; e < elites.size(); e++) {
+        new_population[e] = this->population[elites[e]];
+    }
+
+    for (size_t start = elites.size(); start < this->length;
+        start += this->BREED_CHUNK) {
+        #pragma omp task shared(new_population, crossover_rate, mutation_rate) \
+            firstprivate(start)
+        {
+            size_t end = std::min(start + this->BREED_CHUNK, this->length);
+            this->breed(generation_seed, start, end, new_population,
+                crossover_rate, mutation_rate);
+        }
+    }
+
+    #pragma omp taskwait
+
+    this->population.swap(new_population);
+    this->generation++;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <memory>
+#include <cstdint>
+#include "linear.h"
+#include "random.h"
+#include "selection.h"
+#include "checkpoint.h"
+
+using std::mt19937;
+
+typedef std::vector<linear_indv_ptr> linear_pop_type;
+
+/**
+ * Population of linear programs, same interface as Population.
+ */
+class LinearPopulation {
+public:
+    const int TOURNAMENT_SIZE = 3;
+    const size_t BREED_CHUNK = 64; // Children bred per task.
+    const size_t INIT_CHUNK = 256; // Programs built per scheduling chunk.
+
+    LinearPopulation(size_t _length, int _bloat_control = 0,
+               int _selection_method = Selection::TOURNAMENT) :
+        length(_length), bloat_control(_bloat_control),
+        selection(_selection_method, TOURNAMENT_SIZE) {}
+
+    void initialize(mt19937 & engine, int min_length, int max_length);
+    void initialize_shard(uint64_t seed, int min_length, int max_length,
+        size_t first, size_t stride);
+    void update(mt19937 & engine, const float & crossover_rate,
+        const float & mutation_rate);
+    linear_indv_ptr breed_steady_state(Philox & engine,
+        const float & crossover_rate, const float & mutation_rate);
+    void replace(const linear_indv_ptr & child, Philox & engine);
+
+    /**
+     * Errors on each sample for lexicase selection, see Selection::set_case_errors.
+     * @param errors    vector<float>, case major. Swapped in.
+     * @param num_cases size_t
+     */
+    void set_case_errors(vector<float> & errors, size_t num_cases) {
+        this->selection.set_case_errors(errors, num_cases);
+    }
+
+    /**
+     * Errors of an individual that replaced another since they were set.
+     * @param i      size_t
+     * @param errors float pointer, one per case.
+     */
+    void replace_case_errors(size_t i, const float * errors) {
+        this->selection.replace_case_errors(i, errors);
+    }
+
+    /**
+     * Counters carried from one update to the next, for checkpoints.
+     * @return PopulationState
+     */
+    PopulationState get_state() const {
+        PopulationState state;
+        state.generation = this->generation;
+        state.initial_size_limit = this->initial_size_limit;
+        state.size_limit = this->size_limit;
+        return state;
+    }
+
+    /**
+     * Continue from a checkpoint.
+     * @param state       PopulationState, from get_state.
+     * @param individuals linear_pop_type, swapped in.
+     */
+    void restore(const PopulationState & state, linear_pop_type & individuals) {
+        this->generation = state.generation;
+        this->initial_size_limit = state.initial_size_limit;
+        this->size_limit = state.size_limit;
+        this->population.swap(individuals);
+    }
+
+    size_t get_length() const { return this->population.size(); }
+    linear_indv_ptr & operator[](const size_t & idx) { return this->population[idx]; }
+    void sort();
+
+private:
+    void select_parents(Philox & engine, linear_indv_ptr & parent_a,
+        linear_indv_ptr & parent_b);
+    linear_indv_ptr vary(const linear_indv_ptr & parent_a,
+        const linear_indv_ptr & parent_b, Philox & engine,
+        const float & crossover_rate, const float & mutation_rate);
+    void breed(uint64_t generation_seed, size_t start, size_t end,
+        linear_pop_type & children, const float & crossover_rate,
+        const float & mutation_rate);
+
+    void apply_size_limit(const size_t & best_index);
+
+    size_t length;
+    int bloat_control;       // Evolution::BloatControl flags.
+    int initial_size_limit = 0; // Largest initial individual, set on the first update.
+    int size_limit = 0;      // Current dynamic size limit.
+    Selection selection;     // Prepared at each update from the fitnesses.
+    uint32_t generation = 0; // Updates so far, keys the breeding streams.
+    linear_pop_type population;
+};
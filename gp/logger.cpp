@@ -1,6 +1,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <csignal>
+#include <mutex>
+#include <chrono>
+#include <sstream>
 #include <string>
 #include <memory>
 #include <iostream>
@@ -10,9 +14,14 @@
 #include <algorithm>
 
 #include "population.h"
+#include "linear_population.h"
 #include "individual.h"
 #include "evolution.h"
+#include "engine.h"
+#include "pareto.h"
+#include "statistics.h"
 #include "logger.h"
+#include "omp.h"
 
 using std::cout;
 using std::endl;
@@ -23,104 +32,239 @@ using std::string;
 
 /**
  * Log information about the current generation.
- * @param population         shared_ptr<Population>, curent population.
+ * @param population         shared_ptr<PopulationType>, curent population.
  * @param current_generation int, current generation.
- * @param evaluation_time    double, how long the evaluation took at current_generation.
+ * @param evaluation_time    double, how long the evaluation took at current_generation,
+ *                           or evaluations per second after use_evaluation_rate.
+ * @param extra              vector<double>, values of the add_column columns.
  */
-void Logger::log(std::shared_ptr<Population> population, const int & current_generation,
-         const double & evaluation_time) {
-    // Gather summary statistics.
-    float fit_sum = 0;
-    float fit_sumsq = 0; // Sum of squares.
-    float fitness = 0;   // Temp variable.
-    size_t n = population->get_length();
-
-    int node_sum = 0;
-    int node_sumsq = 0;
-    int max_nodes = -1;
-    int min_nodes = 0x7fffffff; // Max signed int.
-    vector<int> nodes(population->get_length(), 0);
-
-    for (size_t i = 0; i < population->get_length(); i++) {
-        nodes[i] = (*population)[i]->get_tree()->num_nodes();
-        node_sum += nodes[i];
-        node_sumsq += nodes[i] * nodes[i];
-
-        fitness = (*population)[i]->get_fitness() / nodes[i]; // Divide by nodes to get RMSE.
-        fit_sum += fitness;
-        fit_sumsq += fitness * fitness;
-
-        if (nodes[i] > max_nodes) {
-         max_nodes = nodes[i];
+template <typename PopulationType>
+void Logger::log(std::shared_ptr<PopulationType> population, const int & current_generation,
+         const double & evaluation_time, const vector<double> & extra) {
+    typedef EngineTraits<PopulationType> Traits;
+
+    // Pack fitnesses and sizes once, every statistic comes from them.
+    vector<float> fitnesses;
+    vector<int> nodes;
+    Statistics::pack(population, fitnesses, nodes);
+    Summary summary = Statistics::summarize(fitnesses, nodes);
+
+    vector<typename Traits::individual_ptr> front;
+    vector<float> front_rmses;
+    if (this->front_archive) {
+        vector<float> rmses(fitnesses.size()), sizes(nodes.begin(), nodes.end());
+        for (size_t i = 0; i < rmses.size(); i++) {
+            rmses[i] = fitnesses[i] - nodes[i];
         }
-        if (nodes[i] < min_nodes) {
-         min_nodes = nodes[i];
+        for (size_t i : Pareto::front(rmses, sizes)) {
+            front.push_back((*population)[i]);
+            front_rmses.push_back(rmses[i]);
         }
-     }
-
-     float fit_stdev = n * fit_sumsq - (fit_sum * fit_sum);
-     fit_stdev /= n * (n - 1);
-     fit_stdev = sqrt(fit_stdev);
+    }
 
-     float nodes_stdev = n * node_sumsq - (node_sum * node_sum);
-     nodes_stdev /= (float)(n * (n - 1));
-     nodes_stdev = sqrt(nodes_stdev);
+    // Get the best performing individual.
+    auto best = (*population)[summary.best];
 
-     // Sort population and nodes.
-     population->sort();
-     std::sort(nodes.begin(), nodes.end());
+     // Log stats about the population.
+     Record record;
+     std::ostringstream log_line;
+     log_line << current_generation << ","
+              << summary.max_rmse << ","
+              << summary.min_rmse << "," // Lower is better.
+              << summary.mean_rmse << ","
+              << summary.rmse_std << ","
+              << summary.median_rmse << ","
+              << summary.max_nodes << ","
+              << summary.min_nodes << ","
+              << summary.mean_nodes << ","
+              << summary.nodes_std << ","
+              << summary.median_nodes << ","
+              << summary.total_nodes << ","
+              << evaluation_time;
+     for (size_t i = 0; i < extra.size(); i++) {
+         log_line << "," << extra[i];
+     }
+     log_line << "\n";
+     record.log = log_line.str();
 
-     float fit_median;
-     float nodes_median;
-     // Even number of indiviuals.
-     if (n % 2 == 0) {
-         fit_median = (*population)[n / 2]->get_fitness();
-         nodes_median = nodes[n / 2];
+     // Archive best genome, or every point of the front.
+     std::ostringstream archive_lines;
+     if (! this->front_archive) {
+         archive_lines << current_generation << ","
+                       << Traits::size(best) << ","
+                       << Traits::genome(best) << ","
+                       << Traits::description(best) << "\n";
      }
-     // Odd number of individuals.
-     else {
-         fit_median = (*population)[n / 2]->get_fitness() + (*population)[(n + 1) / 2]->get_fitness();
-         fit_median /= 2;
+     for (size_t k = 0; k < front.size(); k++) {
+         // Copies of the same point are written once.
+         if (k > 0 && front_rmses[k] == front_rmses[k - 1]
+             && Traits::size(front[k]) == Traits::size(front[k - 1])) {
+             continue;
+         }
 
-         nodes_median = nodes[n / 2] + nodes[(n + 1) / 2];
-         nodes_median /= (float)2;
+         archive_lines << current_generation << ","
+                       << Traits::size(front[k]) << ","
+                       << front_rmses[k] << ","
+                       << Traits::genome(front[k]) << ","
+                       << Traits::description(front[k]) << "\n";
      }
+     record.archive = archive_lines.str();
 
-     // Get the best performing individual.
-     indv_ptr best = (*population)[0];
-     indv_ptr worst = (*population)[population->get_length() - 1];
+     this->records.push(std::move(record));
+}
 
-     // Log stats about the population.
-     ofstream log_file;
-     log_file.open(this->log_name, std::ios::app);
-     log_file << current_generation << ","
-              << worst->get_fitness() / worst->get_tree()->num_nodes() << "," // Max RMSE
-              << best->get_fitness() / best->get_tree()->num_nodes() << ","   // Min RMSE (lower better)
-              << fit_sum / n << ","
-              << fit_stdev << ","
-              << fit_median << ","
-              << max_nodes << ","
-              << min_nodes << ","
-              << node_sum / (float)n << ","
-              << nodes_stdev << ","
-              << nodes_median << ","
-              << node_sum << ","
-              << evaluation_time << endl;
-     log_file.close();
-
-     // Archive best genome.
-     ofstream archive_file;
-     archive_file.open(this->archive_name, std::ios::app);
-     archive_file << current_generation << ","
-                  << best->get_tree()->num_nodes() << ","
-                  << best->get_tree()->get_rpn_string() << ","
-                  << best->get_tree()->get_infix_string() << endl;
-     archive_file.close();
+template void Logger::log<Population>(std::shared_ptr<Population>,
+    const int &, const double &, const vector<double> &);
+template void Logger::log<LinearPopulation>(std::shared_ptr<LinearPopulation>,
+    const int &, const double &, const vector<double> &);
+
+/**
+ * Set when one of the signals the logger watches arrives, to that signal.
+ */
+static volatile std::sig_atomic_t received_signal = 0;
+
+void Logger::on_signal(int signal) {
+    received_signal = signal;
+}
+
+// Initialized loggers share the handlers, several run at once with thread
+// rank islands. A received signal is raised again only once every live
+// writer has flushed, by whichever is last.
+static std::mutex registry_mutex;
+static int live_loggers = 0;        // Initialized, not yet destroyed.
+static int flushed_loggers = 0;     // Of those, flushed since the signal.
+static bool signal_raised = false;
+static const int WATCHED[3] = {SIGINT, SIGTERM, SIGHUP};
+static struct sigaction saved_actions[3];
+static bool installed[3] = {false, false, false};
+
+/**
+ * Check, under registry_mutex, whether every live logger has flushed since
+ * the signal, which is then raised by the caller alone.
+ * @return bool, whether the caller must raise the signal.
+ */
+static bool last_to_flush() {
+    bool last = received_signal != 0 && ! signal_raised
+        && flushed_loggers == live_loggers;
+    signal_raised = signal_raised || last;
+    return last;
+}
+
+/**
+ * End the process with the received signal's default action.
+ */
+static void raise_received() {
+    int signal = received_signal;
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
 }
 
+/**
+ * Create the files and start the writer. Signals that would end the process
+ * without a handler of the run's own are first passed to the writers, so
+ * queued lines reach the files. The first logger installs the handlers and
+ * the last one destroyed puts the saved ones back.
+ */
 void Logger::initialize() {
     this->make_dir();
     this->make_unique_output_names();
+
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        if (live_loggers++ == 0) {
+            for (int k = 0; k < 3; k++) {
+                sigaction(WATCHED[k], nullptr, &saved_actions[k]);
+                installed[k] = saved_actions[k].sa_handler == SIG_DFL;
+                if (installed[k]) {
+                    std::signal(WATCHED[k], Logger::on_signal);
+                }
+            }
+        }
+    }
+
+    this->writer = std::thread(&Logger::write_records, this);
+}
+
+/**
+ * Write what is still queued, flush and close the files.
+ */
+Logger::~Logger() {
+    if (! this->writer.joinable()) {
+        return;
+    }
+    this->closing.store(true, std::memory_order_release);
+    this->writer.join();
+
+    bool last;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        live_loggers--;
+        if (this->signal_flushed) {
+            flushed_loggers--;
+        }
+        if (live_loggers == 0) {
+            for (int k = 0; k < 3; k++) {
+                if (installed[k]) {
+                    sigaction(WATCHED[k], &saved_actions[k], nullptr);
+                    installed[k] = false;
+                }
+            }
+        }
+        last = last_to_flush();
+    }
+    if (last) {
+        raise_received();
+    }
+}
+
+/**
+ * Writer thread, appends queued records until the logger is destroyed.
+ * A watched signal is raised again, with its default action, once the files
+ * of every live logger are flushed.
+ */
+void Logger::write_records() {
+    ofstream log_file(this->log_name, std::ios::app);
+    ofstream archive_file(this->archive_name, std::ios::app);
+    double last_flush = omp_get_wtime();
+    Record record;
+
+    while (true) {
+        // Read before draining, so records pushed before closing are written.
+        bool closed = this->closing.load(std::memory_order_acquire);
+
+        string log_batch, archive_batch;
+        while (this->records.pop(record)) {
+            log_batch += record.log;
+            archive_batch += record.archive;
+        }
+        log_file << log_batch;
+        archive_file << archive_batch;
+
+        int signal = received_signal;
+        double now = omp_get_wtime();
+        if (closed || signal != 0 || now - last_flush >= FLUSH_INTERVAL) {
+            log_file.flush();
+            archive_file.flush();
+            last_flush = now;
+        }
+
+        if (signal != 0 && ! this->signal_flushed) {
+            this->signal_flushed = true;
+            bool last;
+            {
+                std::lock_guard<std::mutex> lock(registry_mutex);
+                flushed_loggers++;
+                last = last_to_flush();
+            }
+            if (last) {
+                raise_received();
+            }
+        }
+        if (closed) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+    }
 }
 
 /**
@@ -144,6 +288,11 @@ void Logger::make_unique_output_names() {
     string archive = this->output_dir + "/" + "archive" + std::to_string(this->seed);
     string log = this->output_dir + "/" + "log" + std::to_string(this->seed);
 
+    if (this->island >= 0) {
+        archive += "_island" + std::to_string(this->island);
+        log += "_island" + std::to_string(this->island);
+    }
+
     int unique_id = 1;
 
     // Output files don't exist.
@@ -162,7 +311,11 @@ void Logger::make_unique_output_names() {
 
     // Write the csv header to the log file.
     string log_header =
-        "generation,max_rmse,min_rmse,mean_rmse,rmse_std,median_rmse,max_nodes,min_nodes,mean_nodes,nodes_std,median_nodes,total_nodes,evaluation_time";
+        "generation,max_rmse,min_rmse,mean_rmse,rmse_std,median_rmse,max_nodes,min_nodes,mean_nodes,nodes_std,median_nodes,total_nodes,"
+        + this->time_column;
+    for (size_t i = 0; i < this->extra_columns.size(); i++) {
+        log_header += "," + this->extra_columns[i];
+    }
 
     ofstream log_file;
     log_file.open(this->log_name);
@@ -171,6 +324,9 @@ void Logger::make_unique_output_names() {
 
     // Write the header to the archive file.
     string archive_header = "generation,best_nodes,best_genome_rpn,best_genome_infix";
+    if (this->front_archive) {
+        archive_header = "generation,nodes,rmse,genome_rpn,genome_infix";
+    }
     ofstream archive_file;
     archive_file.open(this->archive_name);
     archive_file << archive_header << endl;
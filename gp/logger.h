@@ -1,29 +1,92 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <memory>
+#include <thread>
+#include <atomic>
+#include "spsc_queue.h"
 
 using std::string;
 
 class Population;
 
+/**
+ * Writes the per generation log and archive csv files. log computes the
+ * statistics and formats the text on the calling thread, then hands it to a
+ * writer thread that keeps both files open, appends whatever has queued up
+ * in one write and flushes every FLUSH_INTERVAL seconds, when the logger is
+ * destroyed and before SIGINT, SIGTERM or SIGHUP end the process. Such a
+ * signal ends it once every live logger has flushed.
+ */
 class Logger {
 public:
 
     const int ARCHIVE_INTERVAL = 50;
+    const double FLUSH_INTERVAL = 1.0; // Seconds between flushes of the files.
+    const int POLL_MS = 20;            // Writer sleep while nothing is queued.
 
     Logger(const string & _output_dir, const int & _seed) :
     output_dir(_output_dir), seed(_seed) {}
+    ~Logger();
+    Logger(const Logger &) = delete;
+    Logger & operator=(const Logger &) = delete;
 
     void initialize();
     void make_dir();
     void make_unique_output_names();
-    void log(std::shared_ptr<Population> population, const int & current_generation,
-             const double & evaluation_time);
+
+    /**
+     * Log evaluations per second instead of evaluation time (steady-state
+     * runs have no per generation evaluation). Call before initialize.
+     */
+    void use_evaluation_rate() { this->time_column = "evaluations_per_second"; }
+
+    /**
+     * Add a column after the time column. Call before initialize, then pass
+     * the values to log in the order the columns were added.
+     */
+    void add_column(const string & name) { this->extra_columns.push_back(name); }
+
+    /**
+     * Archive the whole Pareto front of error and size every generation
+     * instead of the best individual. Call before initialize.
+     */
+    void archive_front() { this->front_archive = true; }
+
+    /**
+     * Log one island of an island model run, each gets its own files.
+     * Call before initialize.
+     */
+    void set_island(int island) { this->island = island; }
+
+    template <typename PopulationType>
+    void log(std::shared_ptr<PopulationType> population, const int & current_generation,
+             const double & evaluation_time,
+             const std::vector<double> & extra = std::vector<double>());
 
 private:
+    /**
+     * Text one log call appends to each file.
+     */
+    struct Record {
+        string log;
+        string archive;
+    };
+
+    void write_records();
+    static void on_signal(int signal);
+
     int seed;               // Random seed of master process.
     string output_dir;      // Directory to output below files.
     string archive_name;    // Archive, stores population every so often.
     string log_name;        // Log, stores population info every generation.
+    string time_column = "evaluation_time"; // Name of the time column.
+    std::vector<string> extra_columns;      // Added with add_column.
+    bool front_archive = false;             // Set with archive_front.
+    int island = -1;                        // Set with set_island.
+    SpscQueue<Record> records;              // Filled by log, drained by writer.
+    std::thread writer;                     // Started by initialize.
+    std::atomic<bool> closing{false};       // Set once no more records come.
+    bool signal_flushed = false;            // Writer flushed after a watched signal.
 };
@@ -0,0 +1,91 @@
+#include <cmath>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include "random.h"
+#include "migration.h"
+
+using std::vector;
+
+/**
+ * Ranks an island sends its migrants to. Never includes the island itself.
+ * @param  topology   int, from the Topology enum.
+ * @param  rank       int, the sending island.
+ * @param  size       int, number of islands.
+ * @param  seed       uint64_t, shared by every island, for RANDOM.
+ * @param  generation uint32_t, for RANDOM.
+ * @return            vector<int>
+ */
+vector<int> Migration::destinations(int topology, int rank, int size,
+        uint64_t seed, uint32_t generation) {
+    vector<int> destinations;
+    if (size < 2) {
+        return destinations;
+    }
+
+    if (topology == RING) {
+        destinations.push_back((rank + 1) % size);
+    }
+    else if (topology == TORUS) {
+        // Rows is the largest divisor of size not above its square root.
+        int rows = (int)std::sqrt((double)size);
+        while (size % rows != 0) {
+            rows--;
+        }
+        int columns = size / rows;
+        int row = rank / columns, column = rank % columns;
+
+        int east = row * columns + (column + 1) % columns;
+        int south = ((row + 1) % rows) * columns + column;
+        for (int neighbour : {east, south}) {
+            if (neighbour != rank && std::find(destinations.begin(),
+                    destinations.end(), neighbour) == destinations.end()) {
+                destinations.push_back(neighbour);
+            }
+        }
+    }
+    else if (topology == RANDOM) {
+        Philox engine(seed, generation, rank, Philox::MIGRATE);
+        int other = engine.below(size - 1);
+        destinations.push_back(other >= rank ? other + 1 : other);
+    }
+
+    return destinations;
+}
+
+/**
+ * Indices of the lowest fitnesses, best first. NaN counts as worst.
+ * @param  fitnesses vector<float>
+ * @param  count     size_t, at most the number of fitnesses.
+ * @return           vector<size_t>
+ */
+vector<size_t> Migration::best(const vector<float> & fitnesses, size_t count) {
+    vector<size_t> order(fitnesses.size());
+    std::iota(order.begin(), order.end(), 0);
+    count = std::min(count, order.size());
+
+    auto key = [&](size_t i) {
+        return std::isnan(fitnesses[i]) ? HUGE_VALF : fitnesses[i];
+    };
+    std::partial_sort(order.begin(), order.begin() + count, order.end(),
+        [&](size_t a, size_t b) {
+            return key(a) < key(b) || (key(a) == key(b) && a < b);
+        });
+
+    order.resize(count);
+    return order;
+}
+
+/**
+ * Indices of the highest fitnesses, worst first. NaN counts as worst.
+ * @param  fitnesses vector<float>
+ * @param  count     size_t, at most the number of fitnesses.
+ * @return           vector<size_t>
+ */
+vector<size_t> Migration::worst(const vector<float> & fitnesses, size_t count) {
+    vector<float> negated(fitnesses.size());
+    for (size_t i = 0; i < fitnesses.size(); i++) {
+        negated[i] = std::isnan(fitnesses[i]) ? -HUGE_VALF : -fitnesses[i];
+    }
+    return best(negated, count);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using std::vector;
+
+/**
+ * Island model: each rank evolves its own population and every few
+ * generations sends copies of its best individuals to its neighbours, where
+ * they replace the worst. Neighbours are given by the topology.
+ */
+struct Migration {
+    /**
+     * Who sends to whom. NONE keeps the master-worker hybrid mode.
+     */
+    enum Topology {
+        NONE = 0,
+        RING = 1,   // To the next rank.
+        TORUS = 2,  // East and south on the most square grid of the ranks.
+        RANDOM = 3  // To one other rank, drawn afresh each migration.
+    };
+
+    static vector<int> destinations(int topology, int rank, int size,
+                                    uint64_t seed, uint32_t generation);
+    static vector<size_t> best(const vector<float> & fitnesses, size_t count);
+    static vector<size_t> worst(const vector<float> & fitnesses, size_t count);
+
+private:
+    Migration() {}
+};
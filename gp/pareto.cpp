@@ -0,0 +1,155 @@
+#include <cmath>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include "pareto.h"
+
+using std::vector;
+
+/**
+ * Objective value used for ordering, NaN (a program that produced nothing
+ * usable) counts as infinitely bad.
+ * @param  value float
+ * @return       float
+ */
+static inline float objective(float value) {
+    return std::isnan(value) ? HUGE_VALF : value;
+}
+
+/**
+ * Whether a dominates b: no worse on both objectives and better on one.
+ * @param  a_first  float
+ * @param  a_second float
+ * @param  b_first  float
+ * @param  b_second float
+ * @return          bool
+ */
+bool Pareto::dominates(float a_first, float a_second,
+        float b_first, float b_second) {
+    return a_first <= b_first && a_second <= b_second
+        && (a_first < b_first || a_second < b_second);
+}
+
+/**
+ * Non-dominated sort. Individuals are visited by first objective (then
+ * second), so nobody visited later can dominate anyone visited earlier, and
+ * within a front the second objective only falls. An individual is therefore
+ * dominated by a front exactly when it is dominated by the front's last
+ * member, and since that holds for a prefix of the fronts the right front is
+ * found by binary search. Crowding distance comes from the same order, the
+ * neighbors of each member along the front, boundaries are infinite.
+ * @param  _first   vector<float>, first objective of each individual.
+ * @param  _second  vector<float>, second objective of each individual.
+ * @param  crowding vector<float>, set to the crowding distance of each individual.
+ * @return          vector<int>, front of each individual, 0 is non-dominated.
+ */
+vector<int> Pareto::sort(const vector<float> & _first, const vector<float> & _second,
+        vector<float> & crowding) {
+    size_t n = _first.size();
+
+    vector<float> first(n), second(n);
+    for (size_t i = 0; i < n; i++) {
+        first[i] = objective(_first[i]);
+        second[i] = objective(_second[i]);
+    }
+
+    vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+        [&first, &second](const size_t & a, const size_t & b) -> bool
+        {
+            if (first[a] != first[b]) return first[a] < first[b];
+            if (second[a] != second[b]) return second[a] < second[b];
+            return a < b;
+        });
+
+    vector<int> fronts(n);
+    vector<vector<size_t>> members; // Of each front, in visiting order.
+
+    for (size_t i : order) {
+        // First front whose last member does not dominate i.
+        size_t low = 0, high = members.size();
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            size_t last = members[mid].back();
+
+            if (dominates(first[last], second[last], first[i], second[i])) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+
+        if (low == members.size()) {
+            members.emplace_back();
+        }
+        members[low].push_back(i);
+        fronts[i] = low;
+    }
+
+    // Each objective is normalized by its finite range over the population.
+    float ranges[2] = {0, 0};
+    const vector<float> * objectives[2] = {&first, &second};
+    for (int k = 0; k < 2; k++) {
+        float low = HUGE_VALF, high = -HUGE_VALF;
+        for (float value : *objectives[k]) {
+            if (std::isfinite(value)) {
+                low = std::min(low, value);
+                high = std::max(high, value);
+            }
+        }
+        ranges[k] = (high > low) ? high - low : 0;
+    }
+
+    crowding.assign(n, 0);
+    for (const vector<size_t> & front : members) {
+        size_t m = front.size();
+        crowding[front[0]] = HUGE_VALF;
+        crowding[front[m - 1]] = HUGE_VALF;
+
+        for (size_t j = 1; j + 1 < m; j++) {
+            float distance = 0;
+            for (int k = 0; k < 2; k++) {
+                float gap = std::fabs((*objectives[k])[front[j + 1]]
+                    - (*objectives[k])[front[j - 1]]);
+
+                if (ranges[k] > 0 && std::isfinite(gap)) {
+                    distance += gap / ranges[k];
+                }
+            }
+            crowding[front[j]] = distance;
+        }
+    }
+
+    return fronts;
+}
+
+/**
+ * The non-dominated individuals, by increasing first objective.
+ * @param  first  vector<float>, first objective of each individual.
+ * @param  second vector<float>, second objective of each individual.
+ * @return        vector<size_t>, indices of the first front.
+ */
+vector<size_t> Pareto::front(const vector<float> & first,
+        const vector<float> & second) {
+    vector<float> crowding;
+    vector<int> fronts = sort(first, second, crowding);
+
+    vector<size_t> members;
+    for (size_t i = 0; i < fronts.size(); i++) {
+        if (fronts[i] == 0) {
+            members.push_back(i);
+        }
+    }
+
+    std::sort(members.begin(), members.end(),
+        [&first, &second](const size_t & a, const size_t & b) -> bool
+        {
+            float a_first = objective(first[a]), b_first = objective(first[b]);
+            if (a_first != b_first) return a_first < b_first;
+            return objective(second[a]) < objective(second[b])
+                || (objective(second[a]) == objective(second[b]) && a < b);
+        });
+    return members;
+}
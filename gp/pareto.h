@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+using std::vector;
+
+/**
+ * Two objective non-dominated sorting and crowding distance (NSGA-II), for
+ * selecting on error and size separately instead of their sum. Both
+ * objectives are minimized. With two objectives a single sort is enough, so
+ * a population of n is ranked in O(n log n) instead of the general O(n^2).
+ */
+struct Pareto {
+    static bool dominates(float a_first, float a_second,
+                          float b_first, float b_second);
+    static vector<int> sort(const vector<float> & first,
+                            const vector<float> & second,
+                            vector<float> & crowding);
+    static vector<size_t> front(const vector<float> & first,
+                                const vector<float> & second);
+
+private:
+    Pareto() {}
+};
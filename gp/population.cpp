@@ -21,38 +21,66 @@ using std::vector;
  * See:
  *  https://www.win.tue.nl/ipa/archive/falldays2007/HandoutEggermont.pdf
  * for more information on ramped half-and-half.
+ * Individuals are built in parallel, see initialize_shard.
  * @param  engine    mt19937, Mersenne Twister random generator.
  * @param  min_depth int, min tree depth.
  * @param  max_depth int, max tree depth.
- * @param  length    size_t, size of population.
- * @return           vector<indv_ptr>
  */
 void Population::initialize(mt19937 & engine, int min_depth, int max_depth) {
-    int num_initializations;
-    int num_depths = max_depth - min_depth + 1; // Number of depth categories.
-    int remainder = this->length % num_depths;
-
-    //
-    // For each depth, create half the individuals with the grow method
-    // and the other half with the full method.
-    //
-    for (int current_depth = min_depth; current_depth <= max_depth; current_depth++) {
-        num_initializations = this->length / num_depths;
-
-        // Account for remainder.
-        if (remainder > 0) {
-            num_initializations++;
-            remainder--;
+    uint64_t seed = engine();
+    seed = (seed << 32) | engine();
+
+    this->initialize_shard(seed, min_depth, max_depth, 0, 1);
+}
+
+/**
+ * Build individuals first, first + stride, ... of a ramped half-and-half
+ * population of this->length individuals. Individual i is built from its
+ * own Philox stream keyed by seed and i, so the population is the same for
+ * any thread count and ranks can each build a strided shard of it. The
+ * population is allocated once and filled in place by a thread team, so
+ * call this outside of a parallel region.
+ * Each depth gets an equal share (the first depths take the remainder),
+ * the first half of a share is grown and the rest full.
+ * @param seed      uint64_t, key of the initialization streams.
+ * @param min_depth int, min tree depth.
+ * @param max_depth int, max tree depth.
+ * @param first     size_t, index of the first individual to build.
+ * @param stride    size_t, distance between built individuals, 1 for all.
+ */
+void Population::initialize_shard(uint64_t seed, int min_depth, int max_depth,
+        size_t first, size_t stride) {
+    size_t num_depths = max_depth - min_depth + 1; // Number of depth categories.
+    size_t per_depth = this->length / num_depths;
+    size_t remainder = this->length % num_depths;
+    long count = (first < this->length) ? (this->length - first + stride - 1) / stride : 0;
+
+    this->population.assign(count, nullptr);
+
+    #pragma omp parallel for schedule(dynamic, INIT_CHUNK)
+    for (long k = 0; k < count; k++) {
+        size_t i = first + k * stride;
+        size_t band_start = 0;
+        size_t band;
+        int depth = min_depth;
+
+        // Find the depth whose share contains i.
+        while (true) {
+            band = per_depth + ((depth - min_depth) < remainder ? 1 : 0);
+            if (i < band_start + band) {
+                break;
+            }
+            band_start += band;
+            depth++;
         }
 
-        // Initialize half the trees with "grow"
-        for (int i = 0; i < num_initializations / 2; i++) {
-            this->population.push_back(Evolution::grow(current_depth, engine));
+        Philox engine(seed, 0, i, Philox::INITIALIZE);
+
+        if (i - band_start < band / 2) {
+            this->population[k] = Evolution::grow(depth, engine);
         }
-        // Initialize the other half with "full", accounting for remainder.
-        for (int i = 0; i < (num_initializations / 2)
-             + (num_initializations % 2); i++) {
-            this->population.push_back(Evolution::full(current_depth, engine));
+        else {
+            this->population[k] = Evolution::full(depth, engine);
         }
     }
 }
@@ -68,62 +96,229 @@ void Population::sort() {
         });
 }
 
+/**
+ * Pick two distinct parents by tournament over the live population, as
+ * steady-state breeding does. Generational breeding uses the selection engine.
+ * @param engine   Philox
+ * @param parent_a indv_ptr, set to the first winner.
+ * @param parent_b indv_ptr, set to the second winner.
+ */
+void Population::select_parents(Philox & engine, indv_ptr & parent_a,
+        indv_ptr & parent_b) {
+    parent_a = Evolution::tournament_selection(this, engine,
+        this->TOURNAMENT_SIZE);
+
+    parent_b = nullptr;
+    while (parent_b == nullptr || parent_a == parent_b) {
+        parent_b = Evolution::tournament_selection(this, engine,
+            this->TOURNAMENT_SIZE);
+    }
+}
+
+/**
+ * Crossover or copy, then mutation. Parents are only read.
+ * @param  parent_a       indv_ptr
+ * @param  parent_b       indv_ptr
+ * @param  engine         Philox
+ * @param  crossover_rate float, [0, 1]
+ * @param  mutation_rate  float, [0, 1]
+ * @return                indv_ptr, new individual.
+ */
+indv_ptr Population::vary(const indv_ptr & parent_a, const indv_ptr & parent_b,
+        Philox & engine, const float & crossover_rate, const float & mutation_rate) {
+    indv_ptr child = nullptr;
+
+    // Should we do crossover?
+    if (Evolution::RAND(engine) < crossover_rate) {
+        child = Evolution::crossover(parent_a, parent_b, engine,
+            this->bloat_control);
+    }
+    else { // If not, make a copy.
+        child = make_shared<Individual>(*parent_a);
+    }
+
+    // Should we do mutation?
+    if (Evolution::RAND(engine) < mutation_rate) {
+        child = Evolution::mutation(child, engine);
+    }
+
+    return child;
+}
+
+/**
+ * Produce the children of places [start, end): the parents of all of them
+ * are selected in one batch, then each is crossed over or copied and
+ * mutated. Child i uses its own stream, keyed by the generation and i.
+ * Only reads the current population, so chunks can be bred concurrently.
+ * @param generation_seed uint64_t, key of this update's streams.
+ * @param start           size_t, first place.
+ * @param end             size_t, one past the last place.
+ * @param children        pop_type, the new population, places set.
+ * @param crossover_rate  float, [0, 1]
+ * @param mutation_rate   float, [0, 1]
+ */
+void Population::breed(uint64_t generation_seed, size_t start, size_t end,
+        pop_type & children, const float & crossover_rate,
+        const float & mutation_rate) {
+    vector<Philox> engines;
+    vector<size_t> parents(2 * (end - start));
+    for (size_t i = start; i < end; i++) {
+        engines.emplace_back(generation_seed, this->generation, i, Philox::BREED);
+    }
+
+    this->selection.select_pairs(engines.data(), parents.data(), end - start);
+
+    for (size_t k = 0; k < end - start; k++) {
+        children[start + k] = this->vary(this->population[parents[2 * k]],
+            this->population[parents[2 * k + 1]], engines[k], crossover_rate,
+            mutation_rate);
+    }
+}
+
+/**
+ * Steady-state breeding. Parents are picked under the population lock and
+ * varied outside it, so this can run on many threads alongside replace.
+ * @param  engine         Philox, the child's own random stream.
+ * @param  crossover_rate float, [0, 1]
+ * @param  mutation_rate  float, [0, 1]
+ * @return                indv_ptr
+ */
+indv_ptr Population::breed_steady_state(Philox & engine,
+        const float & crossover_rate, const float & mutation_rate) {
+    indv_ptr parent_a, parent_b;
+
+    #pragma omp critical (population)
+    this->select_parents(engine, parent_a, parent_b);
+
+    return this->vary(parent_a, parent_b, engine, crossover_rate, mutation_rate);
+}
+
+/**
+ * Steady-state replacement. An evaluated child takes the place of the worst
+ * of TOURNAMENT_SIZE random individuals.
+ * @param child  indv_ptr, with its fitness set.
+ * @param engine Philox
+ */
+void Population::replace(const indv_ptr & child, Philox & engine) {
+    #pragma omp critical (population)
+    {
+        size_t loser = engine.below(this->length);
+
+        for (int i = 1; i < this->TOURNAMENT_SIZE; i++) {
+            size_t contender = engine.below(this->length);
+
+            if (this->population[contender]->get_fitness()
+                > this->population[loser]->get_fitness()) {
+                loser = contender;
+            }
+        }
+
+        this->population[loser] = child;
+    }
+}
+
+/**
+ * Dynamic size limit (heavy variant of Silva and Costa's dynamic limits).
+ * The limit starts at the largest initial individual and follows the best
+ * individual's size, but never drops below where it started. Anyone else
+ * over the limit loses any tournament against someone within it, so
+ * oversized children are evaluated once and almost never reproduce. Call before breeding.
+ * @param best_index size_t, index of the best individual.
+ */
+void Population::apply_size_limit(const size_t & best_index) {
+    vector<int> sizes(this->length);
+
+    for (size_t i = 0; i < this->length; i++) {
+        sizes[i] = this->population[i]->get_tree()->num_nodes();
+    }
+
+    if (this->initial_size_limit == 0) {
+        this->initial_size_limit = *std::max_element(sizes.begin(), sizes.end());
+    }
+
+    this->size_limit = std::max(this->initial_size_limit, sizes[best_index]);
+
+    for (size_t i = 0; i < this->length; i++) {
+        if (sizes[i] > this->size_limit && i != best_index) {
+            this->population[i]->set_fitness(HUGE_VALF);
+        }
+    }
+}
+
 /**
  * Update the population based on fitness. This is the reproduction step.
- * @param engine mt19937
+ * Children are bred in OpenMP tasks, each from its own Philox stream keyed by
+ * a seed drawn from engine, the generation and the child's index, so the
+ * result is the same for any thread count.
+ * Call from inside a parallel region (as the driver does) to use the team.
+ * @param engine         mt19937
+ * @param crossover_rate float, [0, 1]
+ * @param mutation_rate  float, [0, 1]
  */
 void Population::update(mt19937 & engine, const float & crossover_rate,
         const float & mutation_rate) {
     float best_fitness = HUGE_VALF;
     size_t best_index = 0;
-    vector<indv_ptr> new_population;
+    vector<indv_ptr> new_population(this->length);
+    uint64_t generation_seed = engine();
+    generation_seed = (generation_seed << 32) | engine();
 
-    // We want an elitism of 1, so find the best individual and save it.
+    // Find the best individual for elitism, packing the fitnesses for the
+    // selection engine in the same pass.
+    vector<float> fitnesses(this->length);
     for (size_t i = 0; i < this->length; i++) {
-        if (this->population[i]->get_fitness() < best_fitness) {
-            best_fitness = this->population[i]->get_fitness();
+        fitnesses[i] = this->population[i]->get_fitness();
+
+        if (fitnesses[i] < best_fitness) {
+            best_fitness = fitnesses[i];
             best_index = i;
         }
     }
 
-    new_population.push_back(this->population[best_index]);
+    if (this->bloat_control & Evolution::DYNAMIC_LIMIT) {
+        this->apply_size_limit(best_index);
 
-    indv_ptr parent_a = nullptr;
-    indv_ptr parent_b = nullptr;
-    indv_ptr child = nullptr;
-
-    // Loop minus 1 to account for elitism.
-    for (size_t i = 0; i < this->length - 1; i++) {
-        parent_a = Evolution::tournament_selection(this, engine,
-            this->TOURNAMENT_SIZE);
-
-        while (parent_b == nullptr || parent_a == parent_b) {
-            parent_b = Evolution::tournament_selection(this, engine,
-                this->TOURNAMENT_SIZE);
+        for (size_t i = 0; i < this->length; i++) {
+            fitnesses[i] = this->population[i]->get_fitness();
         }
+    }
 
-        // Should we do crossover?
-        if (Evolution::RAND(engine) < crossover_rate) {
-            child = Evolution::crossover(parent_a, parent_b, engine);
-        }
-        else { // If not, make a copy.
-            child = make_shared<Individual>(*parent_a);
+    // Pareto selection takes error and size apart, fitness is their sum.
+    if (this->selection.get_method() == Selection::PARETO) {
+        vector<float> errors(this->length), sizes(this->length);
+        for (size_t i = 0; i < this->length; i++) {
+            sizes[i] = this->population[i]->get_tree()->num_nodes();
+            errors[i] = fitnesses[i] - sizes[i];
         }
+        this->selection.set_objectives(errors, sizes);
+    }
 
-        // Should we do mutation?
-        if (Evolution::RAND(engine) < mutation_rate) {
-            child = Evolution::mutation(child, engine);
-        }
+    this->selection.prepare(fitnesses);
 
-        new_population.push_back(child);
+    // Elitism of 1, or the first front under Pareto selection.
+    vector<size_t> elites = this->selection.elites(this->length / 2);
+    if (elites.empty()) {
+        elites.push_back(best_index);
+    }
+    for (size_t e = 0; e < elites.size(); e++) {
+        new_population[e] = this->population[elites[e]];
+    }
 
-        // Reset parents.
-        parent_a = nullptr;
-        parent_b = nullptr;
+    // Children fill the places after the elites.
+    for (size_t start = elites.size(); start < this->length;
+        start += this->BREED_CHUNK) {
+        #pragma omp task shared(new_population, crossover_rate, mutation_rate) \
+            firstprivate(start)
+        {
+            size_t end = std::min(start + this->BREED_CHUNK, this->length);
+            this->breed(generation_seed, start, end, new_population,
+                crossover_rate, mutation_rate);
+        }
     }
 
+    #pragma omp taskwait
+
     // Swap in the new pointers.
-    for (size_t i = 0; i < this->length; i++) {
-        this->population[i] = new_population[i];
-    }
+    this->population.swap(new_population);
+    this->generation++;
 }
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Philox4x32-10 counter based random engine, see:
+ *  Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC 2011.
+ *
+ * Each output block is a pure function of a 64 bit key (the seed) and a 128
+ * bit counter. The low counter word counts blocks, the other three name the
+ * stream: generation, individual and operation. Any thread or rank can open
+ * the stream it needs without touching shared engine state, and the engine
+ * itself is a few dozen bytes, so copying or creating one is free.
+ *
+ * Satisfies UniformRandomBitGenerator, so std distributions work with it,
+ * but uniform, below and coin_flip are cheaper.
+ */
+class Philox {
+public:
+    typedef uint32_t result_type;
+
+    /**
+     * Operations that get their own streams.
+     */
+    enum Operation {
+        BREED = 0,
+        INITIALIZE = 1,
+        SAMPLE = 2,
+        REPLACE = 3,
+        MIGRATE = 4
+    };
+
+    /**
+     * Constructor.
+     * @param seed       uint64_t, key shared by every stream of a run.
+     * @param generation uint32_t
+     * @param individual uint32_t
+     * @param operation  uint32_t, from the Operation enum.
+     */
+    Philox(uint64_t seed = 0, uint32_t generation = 0, uint32_t individual = 0,
+           uint32_t operation = 0) {
+        this->key[0] = (uint32_t)seed;
+        this->key[1] = (uint32_t)(seed >> 32);
+        this->counter[0] = 0;
+        this->counter[1] = generation;
+        this->counter[2] = individual;
+        this->counter[3] = operation;
+    }
+
+    /**
+     * A different stream under the same key.
+     * @param  generation uint32_t
+     * @param  individual uint32_t
+     * @param  operation  uint32_t
+     * @return            Philox
+     */
+    Philox split(uint32_t generation, uint32_t individual, uint32_t operation) const {
+        return Philox(this->get_seed(), generation, individual, operation);
+    }
+
+    /**
+     * Restart as stream (0, 0, 0) of a new key, mirrors mt19937::seed.
+     * @param seed uint64_t
+     */
+    void seed(uint64_t seed) { *this = Philox(seed); }
+
+    uint64_t get_seed() const {
+        return ((uint64_t)this->key[1] << 32) | this->key[0];
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xffffffff; }
+
+    /**
+     * Next 32 random bits.
+     * @return uint32_t
+     */
+    result_type operator()() {
+        if (this->index == 4) {
+            this->generate_block();
+        }
+        return this->block[this->index++];
+    }
+
+    /**
+     * Skip n outputs in constant time, mirrors mt19937::discard.
+     * @param n unsigned long long
+     */
+    void discard(unsigned long long n) {
+        for (; n > 0 && this->index < 4; n--) {
+            this->index++;
+        }
+
+        this->counter[0] += (uint32_t)(n / 4);
+        if (n % 4 != 0) {
+            this->generate_block();
+            this->index = n % 4;
+        }
+    }
+
+    /**
+     * Uniform float in [0, 1), 24 random bits.
+     * @return float
+     */
+    float uniform() {
+        return ((*this)() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    /**
+     * Uniform integer in [0, n), Lemire's multiply and reject method.
+     * @param  n uint32_t, > 0
+     * @return   uint32_t
+     */
+    uint32_t below(uint32_t n) {
+        uint64_t product = (uint64_t)(*this)() * n;
+        uint32_t low = (uint32_t)product;
+
+        if (low < n) {
+            uint32_t threshold = (0u - n) % n;
+            while (low < threshold) {
+                product = (uint64_t)(*this)() * n;
+                low = (uint32_t)product;
+            }
+        }
+
+        return product >> 32;
+    }
+
+    /**
+     * Fair coin.
+     * @return bool
+     */
+    bool coin_flip() { return (*this)() & 1; }
+
+private:
+    static const uint32_t M0 = 0xD2511F53;
+    static const uint32_t M1 = 0xCD9E8D57;
+    static const uint32_t W0 = 0x9E3779B9;
+    static const uint32_t W1 = 0xBB67AE85;
+
+    /**
+     * Encrypt the counter into the output block and advance the counter.
+     */
+    void generate_block() {
+        uint32_t c[4] = {this->counter[0], this->counter[1],
+                         this->counter[2], this->counter[3]};
+        uint32_t k0 = this->key[0], k1 = this->key[1];
+
+        for (int round = 0; round < 10; round++) {
+            uint64_t p0 = (uint64_t)M0 * c[0];
+            uint64_t p1 = (uint64_t)M1 * c[2];
+            uint32_t next[4] = {
+                (uint32_t)(p1 >> 32) ^ c[1] ^ k0, (uint32_t)p1,
+                (uint32_t)(p0 >> 32) ^ c[3] ^ k1, (uint32_t)p0
+            };
+            c[0] = next[0]; c[1] = next[1]; c[2] = next[2]; c[3] = next[3];
+            k0 += W0;
+            k1 += W1;
+        }
+
+        for (int i = 0; i < 4; i++) {
+            this->block[i] = c[i];
+        }
+        this->counter[0]++;
+        this->index = 0;
+    }
+
+    uint32_t key[2];
+    uint32_t counter[4];
+    uint32_t block[4] = {0, 0, 0, 0};
+    int index = 4; // Next unused word of block, 4 means empty.
+};
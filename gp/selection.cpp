@@ -0,0 +1,515 @@
+#include <cmath>
+#include <vector>
+#include <cstring>
+#include <unordered_map>
+#include <numeric>
+#include <algorithm>
+#include "random.h"
+#include "pareto.h"
+#include "selection.h"
+
+using std::vector;
+
+const size_t Selection::MAX_TOURNAMENT;
+
+/**
+ * Take the fitnesses of a new generation. Tournament only keeps the array,
+ * truncation partially sorts the best fraction to the front, rank
+ * selection sorts fully, lexicase works from the case errors and Pareto
+ * sorts the objectives into fronts, both of which must be set first.
+ * @param _fitnesses vector<float>, fitness of each individual by index.
+ */
+void Selection::prepare(const vector<float> & _fitnesses) {
+    this->fitnesses = _fitnesses;
+    const vector<float> & f = this->fitnesses;
+    size_t n = f.size();
+
+    if (this->method == TOURNAMENT) {
+        return;
+    }
+
+    if (this->method == LEXICASE) {
+        this->prepare_lexicase();
+        return;
+    }
+
+    if (this->method == PARETO) {
+        if (this->objective_errors.size() != n || this->objective_sizes.size() != n) {
+            // No objectives, fronts by fitness alone.
+            this->objective_errors = f;
+            this->objective_sizes.assign(n, 0);
+        }
+
+        this->fronts = Pareto::sort(this->objective_errors,
+            this->objective_sizes, this->crowding);
+        this->objective_errors.clear();
+        this->objective_sizes.clear();
+        return;
+    }
+
+    this->order.resize(n);
+    std::iota(this->order.begin(), this->order.end(), 0);
+
+    // Ties are broken by index so the order does not depend on the sort.
+    auto better = [&f](const uint32_t & a, const uint32_t & b) -> bool
+        {
+            return f[a] < f[b] || (f[a] == f[b] && a < b);
+        };
+
+    if (this->method == TRUNCATION) {
+        size_t kept = std::max((size_t)1, (size_t)(this->truncation * n));
+        std::nth_element(this->order.begin(), this->order.begin() + kept - 1,
+            this->order.end(), better);
+        this->order.resize(kept);
+        std::sort(this->order.begin(), this->order.end());
+        return;
+    }
+
+    std::sort(this->order.begin(), this->order.end(), better);
+}
+
+/**
+ * Take the error of every individual on every sample (case) for lexicase.
+ * The matrix is swapped in, not copied.
+ * @param _errors    vector<float>, case major, errors[c * n + i]. Left empty.
+ * @param _num_cases size_t
+ */
+void Selection::set_case_errors(vector<float> & _errors, size_t _num_cases) {
+    this->errors.swap(_errors);
+    _errors.clear();
+    this->num_cases = _num_cases;
+}
+
+/**
+ * Overwrite one individual's errors in the matrix that was set, before it
+ * is prepared, for an individual replaced after evaluation.
+ * @param i       size_t, the individual.
+ * @param _errors float pointer, its error on each case.
+ */
+void Selection::replace_case_errors(size_t i, const float * _errors) {
+    size_t n = this->errors.size() / this->num_cases;
+    for (size_t c = 0; c < this->num_cases; c++) {
+        this->errors[c * n + i] = _errors[c];
+    }
+}
+
+/**
+ * Take the two objectives for Pareto selection. Both are swapped in.
+ * @param _errors vector<float>, rmse of each individual. Left empty.
+ * @param _sizes  vector<float>, size of each individual. Left empty.
+ */
+void Selection::set_objectives(vector<float> & _errors, vector<float> & _sizes) {
+    this->objective_errors.swap(_errors);
+    this->objective_sizes.swap(_sizes);
+    _errors.clear();
+    _sizes.clear();
+}
+
+/**
+ * Individuals carried over unchanged by Pareto selection, the NSGA-II
+ * elitism: the first front, least crowded first when it has to be cut.
+ * Empty for the other methods.
+ * @param  max_count size_t
+ * @return           vector<size_t>, indices into the prepared fitnesses.
+ */
+vector<size_t> Selection::elites(size_t max_count) const {
+    vector<size_t> front;
+    if (this->method != PARETO) {
+        return front;
+    }
+
+    for (size_t i = 0; i < this->fronts.size(); i++) {
+        if (this->fronts[i] == 0) {
+            front.push_back(i);
+        }
+    }
+
+    std::stable_sort(front.begin(), front.end(),
+        [this](const size_t & a, const size_t & b) -> bool
+        {
+            return this->crowding[a] > this->crowding[b];
+        });
+
+    if (front.size() > max_count) {
+        front.resize(max_count);
+    }
+    return front;
+}
+
+/**
+ * Everything lexicase can know before a selection. Individuals with the
+ * same errors on every case always survive or fall together, so they are
+ * merged into one behavior class (duplicates and programs that compute the
+ * same thing) and lexicase filters classes instead. Thresholds are static:
+ * the best error on the case plus epsilon, the median absolute deviation of
+ * the case's errors. The classes within each threshold are kept as a bitset.
+ * Individuals with an infinite fitness (over the dynamic size limit) are
+ * left out unless nobody is finite.
+ */
+void Selection::prepare_lexicase() {
+    size_t n = this->fitnesses.size();
+    size_t m = this->num_cases;
+
+    if (m == 0 || this->errors.size() != n * m) {
+        this->num_cases = 0; // Fall back to tournaments.
+        return;
+    }
+
+    vector<uint32_t> eligible;
+    for (size_t i = 0; i < n; i++) {
+        if (this->fitnesses[i] < HUGE_VALF) {
+            eligible.push_back(i);
+        }
+    }
+    if (eligible.empty()) {
+        eligible.resize(n);
+        std::iota(eligible.begin(), eligible.end(), 0);
+    }
+
+    // Hash each individual's errors (FNV-1a over the bits), a row at a time.
+    vector<uint64_t> hashes(n, 0xcbf29ce484222325ULL);
+    for (size_t c = 0; c < m; c++) {
+        const float * row = &this->errors[c * n];
+        for (uint32_t i : eligible) {
+            uint32_t bits;
+            std::memcpy(&bits, &row[i], sizeof(bits));
+            hashes[i] = (hashes[i] ^ bits) * 0x100000001b3ULL;
+        }
+    }
+
+    // Equal hashes share a representative, checked below case by case.
+    std::unordered_map<uint64_t, uint32_t> first_seen;
+    vector<uint32_t> representative(n);
+    for (uint32_t i : eligible) {
+        representative[i] = first_seen.emplace(hashes[i], i).first->second;
+    }
+
+    for (size_t c = 0; c < m; c++) {
+        const float * row = &this->errors[c * n];
+        for (uint32_t i : eligible) {
+            if (row[i] != row[representative[i]]) {
+                representative[i] = i; // A collision, keep it on its own.
+            }
+        }
+    }
+
+    // Classes are numbered in order of their first member.
+    vector<uint32_t> class_of(n);
+    vector<uint32_t> classes; // Representative of each class.
+    vector<uint32_t> counts;
+    for (uint32_t i : eligible) {
+        if (representative[i] == i) {
+            class_of[i] = classes.size();
+            classes.push_back(i);
+            counts.push_back(0);
+        }
+        else {
+            class_of[i] = class_of[representative[i]];
+        }
+        counts[class_of[i]]++;
+    }
+
+    size_t k = classes.size();
+    this->num_classes = k;
+    this->member_offsets.assign(k + 1, 0);
+    for (size_t j = 0; j < k; j++) {
+        this->member_offsets[j + 1] = this->member_offsets[j] + counts[j];
+    }
+    this->members.resize(eligible.size());
+    vector<uint32_t> filled(this->member_offsets.begin(), this->member_offsets.end() - 1);
+    for (uint32_t i : eligible) {
+        this->members[filled[class_of[i]]++] = i;
+    }
+
+    // Thresholds over every eligible individual, errors and bits per class.
+    size_t words = (k + 63) / 64;
+    vector<float> compact(k * m);
+    this->threshold.resize(m);
+    this->pass_bits.assign(m * words, 0);
+    this->pass_counts.assign(m, 0);
+
+    vector<float> values;
+    values.reserve(eligible.size());
+    vector<bool> fails_a_case(k, false);
+
+    for (size_t c = 0; c < m; c++) {
+        const float * row = &this->errors[c * n];
+        float * class_row = &compact[c * k];
+        uint64_t * bits = &this->pass_bits[c * words];
+
+        // Median, then median of the deviations, over the finite errors.
+        values.clear();
+        float best = HUGE_VALF;
+        for (uint32_t i : eligible) {
+            best = std::min(best, row[i]);
+            if (row[i] < HUGE_VALF) {
+                values.push_back(row[i]);
+            }
+        }
+
+        float mad = 0;
+        if (! values.empty()) {
+            auto middle = values.begin() + values.size() / 2;
+            std::nth_element(values.begin(), middle, values.end());
+            float median = *middle;
+
+            for (float & value : values) {
+                value = std::fabs(value - median);
+            }
+            std::nth_element(values.begin(), middle, values.end());
+            mad = *middle;
+        }
+
+        this->threshold[c] = best + mad;
+        for (size_t j = 0; j < k; j++) {
+            class_row[j] = row[classes[j]];
+            if (class_row[j] <= this->threshold[c]) {
+                bits[j / 64] |= (uint64_t)1 << (j % 64);
+                this->pass_counts[c]++;
+            }
+            else {
+                fails_a_case[j] = true;
+            }
+        }
+    }
+
+    this->errors.swap(compact);
+
+    // Classes within threshold on every case are never filtered out, and
+    // every case has one of them left to pass it, so when there are any a
+    // selection always ends with exactly these.
+    this->universal.clear();
+    for (size_t j = 0; j < k; j++) {
+        if (! fails_a_case[j]) {
+            this->universal.insert(this->universal.end(),
+                this->members.begin() + this->member_offsets[j],
+                this->members.begin() + this->member_offsets[j + 1]);
+        }
+    }
+}
+
+/**
+ * Static epsilon-lexicase over behavior classes. Cases are shuffled lazily,
+ * one swap per case used. While many classes remain the candidates are a
+ * bitset and each case is a word-wise AND with its precomputed pass bits,
+ * once few remain they become a list checked against the case thresholds.
+ * A case that no remaining candidate passes is skipped. The survivor is
+ * picked in proportion to class size, which is what a uniform pick over the
+ * surviving individuals would give. When some classes pass every case the
+ * outcome is known up front and is drawn directly. Buffers are per thread
+ * and reused.
+ * @param  engine Philox
+ * @return        size_t, index of the selected individual.
+ */
+size_t Selection::lexicase(Philox & engine) const {
+    if (! this->universal.empty()) {
+        return this->universal[engine.below(this->universal.size())];
+    }
+
+    thread_local vector<uint64_t> candidate_bits;
+    thread_local vector<uint32_t> candidates;
+    thread_local vector<uint32_t> cases;
+
+    size_t k = this->num_classes;
+    size_t words = (k + 63) / 64;
+    uint32_t remaining = this->num_cases;
+
+    cases.resize(remaining);
+    std::iota(cases.begin(), cases.end(), 0);
+
+    // Draw the next case without replacement.
+    auto next_case = [&]() -> uint32_t {
+        uint32_t pick = engine.below(remaining);
+        uint32_t c = cases[pick];
+        cases[pick] = cases[--remaining];
+        return c;
+    };
+
+    uint32_t c = next_case();
+    candidate_bits.assign(this->pass_bits.begin() + c * words,
+        this->pass_bits.begin() + (c + 1) * words);
+    size_t count = this->pass_counts[c];
+
+    // Dense phase, until the survivors would fit in fewer ints than words.
+    while (count > 1 && remaining > 0 && count >= words) {
+        const uint64_t * bits = &this->pass_bits[next_case() * words];
+
+        size_t kept = 0;
+        for (size_t w = 0; w < words; w++) {
+            kept += __builtin_popcountll(candidate_bits[w] & bits[w]);
+        }
+
+        if (kept > 0) {
+            for (size_t w = 0; w < words; w++) {
+                candidate_bits[w] &= bits[w];
+            }
+            count = kept;
+        }
+    }
+
+    candidates.clear();
+    for (size_t w = 0; w < words; w++) {
+        for (uint64_t word = candidate_bits[w]; word != 0; word &= word - 1) {
+            candidates.push_back(w * 64 + __builtin_ctzll(word));
+        }
+    }
+
+    // Sparse phase.
+    while (candidates.size() > 1 && remaining > 0) {
+        c = next_case();
+        const float * row = &this->errors[c * k];
+        const float limit = this->threshold[c];
+
+        size_t kept = 0;
+        for (uint32_t j : candidates) {
+            kept += (row[j] <= limit);
+        }
+
+        if (kept > 0) {
+            size_t survivors = 0;
+            for (uint32_t j : candidates) {
+                if (row[j] <= limit) {
+                    candidates[survivors++] = j;
+                }
+            }
+            candidates.resize(survivors);
+        }
+    }
+
+    // Weight the surviving classes by their number of members.
+    uint32_t total = 0;
+    for (uint32_t j : candidates) {
+        total += this->member_offsets[j + 1] - this->member_offsets[j];
+    }
+
+    uint32_t target = engine.below(total);
+    for (uint32_t j : candidates) {
+        uint32_t size = this->member_offsets[j + 1] - this->member_offsets[j];
+        if (target < size) {
+            return this->members[this->member_offsets[j] + target];
+        }
+        target -= size;
+    }
+
+    return this->members.back(); // Not reached.
+}
+
+/**
+ * Tournament comparison. Lower fitness wins, or under Pareto selection the
+ * lower front and then the larger crowding distance (crowded comparison).
+ * @param  a uint32_t
+ * @param  b uint32_t
+ * @return   bool, true if a beats b.
+ */
+bool Selection::better(uint32_t a, uint32_t b) const {
+    if (this->method == PARETO) {
+        return this->fronts[a] < this->fronts[b]
+            || (this->fronts[a] == this->fronts[b]
+                && this->crowding[a] > this->crowding[b]);
+    }
+    return this->fitnesses[a] < this->fitnesses[b];
+}
+
+/**
+ * Best of tournament_size distinct random individuals. Contenders are kept
+ * on the stack, a repeated index is simply drawn again.
+ * @param  engine Philox
+ * @return        size_t, index of the winner.
+ */
+size_t Selection::tournament(Philox & engine) const {
+    uint32_t n = this->fitnesses.size();
+    size_t k = std::min(std::min(this->tournament_size, MAX_TOURNAMENT), (size_t)n);
+    uint32_t contenders[MAX_TOURNAMENT];
+    uint32_t winner = engine.below(n);
+
+    contenders[0] = winner;
+    for (size_t drawn = 1; drawn < k; ) {
+        uint32_t index = engine.below(n);
+
+        if (std::find(contenders, contenders + drawn, index) != contenders + drawn) {
+            continue;
+        }
+        contenders[drawn++] = index;
+
+        if (this->better(index, winner)) {
+            winner = index;
+        }
+    }
+
+    return winner;
+}
+
+/**
+ * Linear ranking: rank r (0 best) has probability
+ * (pressure - (2 pressure - 2) r / (n - 1)) / n. That is a uniform rank with
+ * probability 2 - pressure, otherwise the better of two distinct uniform
+ * ranks, whose minimum has probability 2 (n - 1 - r) / (n (n - 1)).
+ * Constant time, no table of probabilities.
+ * @param  engine Philox
+ * @return        size_t, a rank.
+ */
+size_t Selection::rank(Philox & engine) const {
+    uint32_t n = this->order.size();
+    uint32_t a = engine.below(n);
+
+    if (n < 2 || engine.uniform() >= this->pressure - 1) {
+        return a;
+    }
+
+    uint32_t b = engine.below(n - 1);
+    b += (b >= a); // Skip a so the two ranks are distinct.
+    return std::min(a, b);
+}
+
+/**
+ * Select one individual.
+ * @param  engine Philox
+ * @return        size_t, index into the prepared fitnesses.
+ */
+size_t Selection::select(Philox & engine) const {
+    switch (this->method) {
+        case TRUNCATION:
+            return this->order[engine.below(this->order.size())];
+        case RANK:
+            return this->order[this->rank(engine)];
+        case LEXICASE:
+            if (this->num_cases > 0) {
+                return this->lexicase(engine);
+            }
+            return this->tournament(engine);
+        default:
+            return this->tournament(engine);
+    }
+}
+
+/**
+ * Select two parents. The second is drawn again while it equals the first,
+ * a few times at most, so a population with a single candidate still
+ * terminates.
+ * @param engine Philox
+ * @param a      size_t, set to the first parent.
+ * @param b      size_t, set to the second parent.
+ */
+void Selection::select_pair(Philox & engine, size_t & a, size_t & b) const {
+    a = this->select(engine);
+    b = this->select(engine);
+
+    for (int retry = 0; retry < 8 && b == a; retry++) {
+        b = this->select(engine);
+    }
+}
+
+/**
+ * Select the parents of a batch of children before any of them is varied,
+ * so the loop only touches the packed selection data. Child k draws from
+ * its own stream exactly as select_pair would, and the stream is left
+ * where variation picks it up.
+ * @param engines Philox pointer, one stream per child, advanced.
+ * @param parents size_t pointer, 2 * count indices, child k's pair at 2k.
+ * @param count   size_t, children.
+ */
+void Selection::select_pairs(Philox * engines, size_t * parents, size_t count) const {
+    for (size_t k = 0; k < count; k++) {
+        this->select_pair(engines[k], parents[2 * k], parents[2 * k + 1]);
+    }
+}
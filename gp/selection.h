@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "random.h"
+
+using std::vector;
+
+/**
+ * Parent selection over a packed fitness array (lower is better).
+ * prepare copies the population's fitnesses once per generation and builds
+ * whatever the method needs, after that select only reads, allocates nothing
+ * and can be called from many threads with their own engines.
+ */
+class Selection {
+public:
+    /**
+     * Selection methods, selected with -r.
+     */
+    enum Method {
+        TOURNAMENT = 0, // Best of tournament_size distinct individuals.
+        TRUNCATION = 1, // Uniform among the best truncation fraction.
+        RANK = 2,       // Linear ranking with selection pressure pressure.
+        LEXICASE = 3,   // Epsilon-lexicase over the errors on each sample.
+        PARETO = 4      // Crowded tournament on error and size fronts (NSGA-II).
+    };
+
+    static const size_t MAX_TOURNAMENT = 16;
+
+    /**
+     * Constructor.
+     * @param _method          int, from the Method enum.
+     * @param _tournament_size size_t, [1, MAX_TOURNAMENT]
+     * @param _truncation      float, (0, 1], fraction kept by truncation.
+     * @param _pressure        float, [1, 2], expected offspring of the best
+     *                         individual under rank selection.
+     */
+    Selection(int _method = TOURNAMENT, size_t _tournament_size = 3,
+              float _truncation = 0.5, float _pressure = 1.8) :
+        method(_method), tournament_size(_tournament_size),
+        truncation(_truncation), pressure(_pressure) {}
+
+    void prepare(const vector<float> & _fitnesses);
+    void set_case_errors(vector<float> & _errors, size_t _num_cases);
+    void replace_case_errors(size_t i, const float * _errors);
+    void set_objectives(vector<float> & _errors, vector<float> & _sizes);
+    vector<size_t> elites(size_t max_count) const;
+    size_t select(Philox & engine) const;
+    void select_pair(Philox & engine, size_t & a, size_t & b) const;
+    void select_pairs(Philox * engines, size_t * parents, size_t count) const;
+
+    size_t get_length() const { return this->fitnesses.size(); }
+    size_t get_num_cases() const { return this->num_cases; }
+    int get_method() const { return this->method; }
+
+private:
+    size_t tournament(Philox & engine) const;
+    bool better(uint32_t a, uint32_t b) const;
+    size_t rank(Philox & engine) const;
+    void prepare_lexicase();
+    size_t lexicase(Philox & engine) const;
+
+    int method;
+    size_t tournament_size;
+    float truncation;
+    float pressure;
+
+    vector<float> fitnesses;          // Packed copy of the population's fitnesses.
+    vector<uint32_t> order;           // Indices best first, truncation and rank only.
+
+    // Lexicase only. Once prepared, errors holds one column per behavior
+    // class (individuals with identical errors) instead of per individual.
+    size_t num_cases = 0;
+    size_t num_classes = 0;
+    vector<float> errors;            // Case major, errors[c * n + i].
+    vector<float> threshold;         // Best error plus epsilon on each case.
+    vector<uint64_t> pass_bits;      // Classes within threshold, a bitset per case.
+    vector<uint32_t> pass_counts;    // Classes within threshold on each case.
+    vector<uint32_t> members;        // Individuals of each class, class j
+    vector<uint32_t> member_offsets; // from member_offsets[j].
+    vector<uint32_t> universal;      // Individuals within threshold on every case.
+
+    // Pareto only.
+    vector<float> objective_errors;  // Rmse of each individual.
+    vector<float> objective_sizes;   // Nodes or instructions of each individual.
+    vector<int> fronts;              // Non-dominated front of each individual.
+    vector<float> crowding;          // Crowding distance within the front.
+};
@@ -0,0 +1,392 @@
+#include <stack>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "evaluation.h"
+#include "individual.h"
+#include "linear.h"
+#include "serialization.h"
+
+using std::string; using std::vector;
+using std::make_shared;
+
+const uint8_t Serialization::OP_ADD;
+const uint8_t Serialization::OP_SUBTRACT;
+const uint8_t Serialization::OP_MULTIPLY;
+const uint8_t Serialization::OP_DIVIDE;
+const uint8_t Serialization::OP_VAR;
+const uint8_t Serialization::OP_CONSTANT;
+
+/**
+ * Map a token to its opcode.
+ * @param  token string, operation, variable or constant.
+ * @return       uint8_t
+ */
+static uint8_t opcode_of(const string & token) {
+    if (Evaluation::is_variable(token)) {
+        return Serialization::OP_VAR;
+    }
+    if (Evaluation::is_operation(token)) {
+        for (uint8_t o = 0; o < Evaluation::OPERATIONS.size(); o++) {
+            if (Evaluation::OPERATIONS[o] == token[0]) {
+                return o;
+            }
+        }
+    }
+    return Serialization::OP_CONSTANT;
+}
+
+/**
+ * Shortest decimal form of a float that parses back to the same float.
+ * Keeps trees readable, e.g. 6.885315f prints as "6.885315" rather than
+ * "6.88531494", while the text still round trips exactly.
+ * @param  value float
+ * @return       string
+ */
+string Serialization::format_constant(float value) {
+    char buffer[32];
+
+    for (int precision = 1; precision < 9; precision++) {
+        snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if (strtof(buffer, nullptr) == value) {
+            return buffer;
+        }
+    }
+
+    snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+}
+
+/**
+ * Rebuild a tree from a record body.
+ * @param  body   const uint8_t pointer
+ * @param  length uint32_t, body length in bytes.
+ * @return        tree_ptr
+ */
+tree_ptr Serialization::decode_tree(const uint8_t * body, uint32_t length) {
+    std::stack<node_ptr> node_stack;
+    node_ptr a, b, node;
+
+    for (uint32_t i = 0; i < length; i++) {
+        uint8_t op = body[i];
+        node = make_shared<RPNNode>();
+
+        if (op == OP_VAR) {
+            node->value = string(1, Evaluation::VAR);
+        }
+        else if (op == OP_CONSTANT) {
+            node->set_constant(read_float(body + i + 1));
+            i += sizeof(float);
+        }
+        else {
+            // Operation node, same child order as RPNTree::build_tree.
+            a = node_stack.top();
+            node_stack.pop();
+            b = node_stack.top();
+            node_stack.pop();
+
+            node->value = string(1, Evaluation::OPERATIONS[op]);
+            node->left = b;
+            node->right = a;
+            a->parent = node;
+            b->parent = node;
+        }
+
+        node_stack.push(node);
+    }
+
+    return make_shared<RPNTree>(node_stack.top());
+}
+
+/**
+ * Rebuild a linear program from a record body.
+ * @param  body   const uint8_t pointer
+ * @param  length uint32_t, body length in bytes.
+ * @return        LinearProgram
+ */
+LinearProgram Serialization::decode_linear(const uint8_t * body, uint32_t length) {
+    vector<Instruction> instructions;
+    uint32_t i = 0;
+
+    while (i < length) {
+        Instruction instr;
+        instr.op = body[i];
+        instr.dst = body[i + 1];
+        instr.src_a = body[i + 2];
+        instr.src_b = body[i + 3];
+        i += 4;
+
+        if (instr.uses_constant()) {
+            instr.constant = read_float(body + i);
+            i += sizeof(float);
+        }
+
+        instructions.push_back(instr);
+    }
+
+    return LinearProgram(instructions);
+}
+
+/**
+ * Count the tokens (tree nodes) of a tree record body.
+ * @param  body   const uint8_t pointer
+ * @param  length uint32_t, body length in bytes.
+ * @return        int
+ */
+int Serialization::num_tokens(const uint8_t * body, uint32_t length) {
+    int count = 0;
+
+    for (uint32_t i = 0; i < length; i++) {
+        if (body[i] == OP_CONSTANT) {
+            i += sizeof(float);
+        }
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * Check a tree record body before decoding it: known opcodes, whole
+ * constants, two operands on the stack for every operation and a single
+ * tree left at the end.
+ * @param  body   const uint8_t pointer
+ * @param  length uint32_t, body length in bytes.
+ * @return        bool
+ */
+bool Serialization::valid_tree(const uint8_t * body, uint32_t length) {
+    size_t depth = 0;
+
+    for (uint32_t i = 0; i < length; i++) {
+        uint8_t op = body[i];
+
+        if (op == OP_CONSTANT) {
+            if (length - i - 1 < sizeof(float)) {
+                return false;
+            }
+            i += sizeof(float);
+            depth++;
+        }
+        else if (op == OP_VAR) {
+            depth++;
+        }
+        else if (op < Evaluation::OPERATIONS.size() && depth >= 2) {
+            depth--;
+        }
+        else {
+            return false;
+        }
+    }
+
+    return depth == 1;
+}
+
+/**
+ * Check a linear record body before decoding it: known operations, registers
+ * in range and whole constants.
+ * @param  body   const uint8_t pointer
+ * @param  length uint32_t, body length in bytes.
+ * @return        bool
+ */
+bool Serialization::valid_linear(const uint8_t * body, uint32_t length) {
+    uint32_t i = 0;
+
+    while (i < length) {
+        if (length - i < 4) {
+            return false;
+        }
+
+        Instruction instr;
+        instr.op = body[i];
+        instr.dst = body[i + 1];
+        instr.src_a = body[i + 2];
+        instr.src_b = body[i + 3];
+        i += 4;
+
+        if (instr.op >= Evaluation::OPERATIONS.size()
+            || instr.dst >= LinearProgram::NUM_REGISTERS
+            || instr.src_a >= LinearProgram::NUM_REGISTERS
+            || instr.src_b > LinearProgram::CONSTANT) {
+            return false;
+        }
+
+        if (instr.uses_constant()) {
+            if (length - i < sizeof(float)) {
+                return false;
+            }
+            i += sizeof(float);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Reserve space for the length prefix of a new record.
+ * @return size_t, offset of the prefix.
+ */
+size_t GenomeWriter::begin_record() {
+    size_t start = this->buffer.size();
+    this->buffer.resize(start + sizeof(uint32_t));
+    return start;
+}
+
+/**
+ * Fill in the length prefix once the body is written.
+ * @param start size_t, offset returned by begin_record.
+ */
+void GenomeWriter::end_record(size_t start) {
+    uint32_t length = this->buffer.size() - start - sizeof(uint32_t);
+    std::memcpy(&this->buffer[start], &length, sizeof(uint32_t));
+}
+
+/**
+ * Append a raw float.
+ * @param value float
+ */
+void GenomeWriter::put_float(float value) {
+    size_t start = this->buffer.size();
+    this->buffer.resize(start + sizeof(float));
+    std::memcpy(&this->buffer[start], &value, sizeof(float));
+}
+
+/**
+ * Post order traversal of a tree.
+ * @param node  node_ptr, current node.
+ * @param visit callable, called with each node.
+ */
+template <typename Visitor>
+static void post_order(const node_ptr & node, Visitor & visit) {
+    if (node != nullptr) {
+        post_order(node->left, visit);
+        post_order(node->right, visit);
+        visit(*node);
+    }
+}
+
+/**
+ * Append a tree record.
+ * @param tree RPNTree
+ */
+void GenomeWriter::write(const RPNTree & tree) {
+    size_t start = this->begin_record();
+
+    // Constants are kept as floats in the nodes, nothing is parsed here.
+    auto visit = [this](const RPNNode & node) {
+        uint8_t op = opcode_of(node.value);
+        this->put_byte(op);
+        if (op == Serialization::OP_CONSTANT) {
+            this->put_float(node.constant);
+        }
+    };
+    post_order(tree.get_root(), visit);
+
+    this->end_record(start);
+}
+
+/**
+ * Append a tree record from a reverse polish string.
+ * @param rpn string, space separated tokens.
+ */
+void GenomeWriter::write_rpn(const string & rpn) {
+    size_t start = this->begin_record();
+    size_t begin = 0;
+
+    while (begin < rpn.size()) {
+        size_t end = rpn.find(' ', begin);
+        if (end == string::npos) {
+            end = rpn.size();
+        }
+
+        if (end > begin) {
+            string token = rpn.substr(begin, end - begin);
+            uint8_t op = opcode_of(token);
+            this->put_byte(op);
+            if (op == Serialization::OP_CONSTANT) {
+                this->put_float(strtof(token.c_str(), nullptr));
+            }
+        }
+        begin = end + 1;
+    }
+
+    this->end_record(start);
+}
+
+/**
+ * Append a linear program record.
+ * @param program LinearProgram
+ */
+void GenomeWriter::write(const LinearProgram & program) {
+    size_t start = this->begin_record();
+
+    for (const Instruction & instr : program.get_instructions()) {
+        this->put_byte(instr.op);
+        this->put_byte(instr.dst);
+        this->put_byte(instr.src_a);
+        this->put_byte(instr.src_b);
+        if (instr.uses_constant()) {
+            this->put_float(instr.constant);
+        }
+    }
+
+    this->end_record(start);
+}
+
+/**
+ * Copy a record from another buffer.
+ * @param genome GenomeView
+ */
+void GenomeWriter::write_raw(const GenomeView & genome) {
+    size_t start = this->begin_record();
+    this->buffer.insert(this->buffer.end(), genome.body, genome.body + genome.length);
+    this->end_record(start);
+}
+
+/**
+ * Move to the next record. A record whose length runs past the end of the
+ * buffer is not returned and stops the reader where it starts, so
+ * get_offset tells a clean end from a truncated one.
+ * @param  genome GenomeView, set to the next record.
+ * @return        bool, false once the buffer is exhausted or overrun.
+ */
+bool GenomeReader::next(GenomeView & genome) {
+    if (this->size - this->offset < sizeof(uint32_t)) {
+        return false;
+    }
+
+    uint32_t length;
+    std::memcpy(&length, this->data + this->offset, sizeof(uint32_t));
+    if (length > this->size - this->offset - sizeof(uint32_t)) {
+        return false;
+    }
+
+    genome.length = length;
+    genome.body = this->data + this->offset + sizeof(uint32_t);
+    this->offset += sizeof(uint32_t) + length;
+
+    return true;
+}
+
+/**
+ * Number of records in the buffer.
+ * @return size_t
+ */
+size_t GenomeReader::count() const {
+    size_t records = 0;
+    size_t offset = 0;
+    uint32_t length;
+
+    while (this->size - offset >= sizeof(uint32_t)) {
+        std::memcpy(&length, this->data + offset, sizeof(uint32_t));
+        if (length > this->size - offset - sizeof(uint32_t)) {
+            break;
+        }
+        offset += sizeof(uint32_t) + length;
+        records++;
+    }
+
+    return records;
+}
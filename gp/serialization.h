@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+
+using std::string; using std::vector;
+
+class RPNTree; class LinearProgram;
+typedef std::shared_ptr<RPNTree> tree_ptr;
+
+/**
+ * Binary genome format.
+ *
+ * A buffer is a sequence of records, each record is a uint32_t body length in
+ * bytes followed by the body. Tree bodies are the post-order tokens, one
+ * opcode byte per token with the raw 4 byte float following OP_CONSTANT.
+ * Linear bodies are four bytes per instruction (op, dst, src_a, src_b) with
+ * the raw float following when src_b is LinearProgram::CONSTANT.
+ * Values are stored in host byte order, every rank is assumed to share it.
+ * Records from outside the run, such as a checkpoint file, are checked with
+ * valid_tree or valid_linear before they are decoded.
+ */
+struct Serialization {
+    // Opcodes, the operations match the order of Evaluation::OPERATIONS.
+    static const uint8_t OP_ADD = 0;
+    static const uint8_t OP_SUBTRACT = 1;
+    static const uint8_t OP_MULTIPLY = 2;
+    static const uint8_t OP_DIVIDE = 3;
+    static const uint8_t OP_VAR = 4;
+    static const uint8_t OP_CONSTANT = 5;
+
+    static tree_ptr decode_tree(const uint8_t * body, uint32_t length);
+    static LinearProgram decode_linear(const uint8_t * body, uint32_t length);
+    static int num_tokens(const uint8_t * body, uint32_t length);
+    static bool valid_tree(const uint8_t * body, uint32_t length);
+    static bool valid_linear(const uint8_t * body, uint32_t length);
+    static string format_constant(float value);
+
+    /**
+     * Read a raw float from a possibly unaligned position.
+     * @param  src const uint8_t pointer
+     * @return     float
+     */
+    static float read_float(const uint8_t * src) {
+        float value;
+        std::memcpy(&value, src, sizeof(float));
+        return value;
+    }
+
+private:
+    Serialization() {}
+};
+
+/**
+ * A genome record inside a buffer, points into the buffer without copying.
+ */
+struct GenomeView {
+    const uint8_t * body = nullptr;
+    uint32_t length = 0; // Body length in bytes.
+};
+
+/**
+ * Appends genome records to a caller owned buffer.
+ */
+class GenomeWriter {
+public:
+    /**
+     * Constructor.
+     * @param _buffer vector<uint8_t>, records are appended, never cleared.
+     */
+    GenomeWriter(vector<uint8_t> & _buffer) : buffer(_buffer) {}
+
+    void write(const RPNTree & tree);
+    void write(const LinearProgram & program);
+    void write_rpn(const string & rpn);
+    void write_raw(const GenomeView & genome);
+
+private:
+    size_t begin_record();
+    void end_record(size_t start);
+    void put_byte(uint8_t byte) { this->buffer.push_back(byte); }
+    void put_float(float value);
+
+    vector<uint8_t> & buffer;
+};
+
+/**
+ * Walks the records of a buffer in place.
+ */
+class GenomeReader {
+public:
+    /**
+     * Constructor.
+     * @param _data const uint8_t pointer, start of the records.
+     * @param _size size_t, total size of the records in bytes.
+     */
+    GenomeReader(const uint8_t * _data, size_t _size) :
+        data(_data), size(_size) {}
+
+    bool next(GenomeView & genome);
+    size_t count() const;
+    void rewind() { this->offset = 0; }
+    size_t get_offset() const { return this->offset; }
+
+private:
+    const uint8_t * data;
+    size_t size;
+    size_t offset = 0;
+};
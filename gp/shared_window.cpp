@@ -0,0 +1,61 @@
+#include <algorithm>
+#include "transport.h"
+#include "shared_window.h"
+
+/**
+ * Make room for at least bytes, collective over the node. Every rank of the
+ * node must pass the same size. Growing doubles the capacity, so a run
+ * reallocates a handful of times, and the old contents are lost.
+ * @param node  MPI_Comm, ranks sharing memory.
+ * @param bytes size_t, bytes needed.
+ */
+void SharedWindow::reserve(MPI_Comm node, size_t bytes) {
+    if (bytes <= this->allocated && this->window != MPI_WIN_NULL) {
+        return;
+    }
+
+    size_t capacity = std::max(bytes, 2 * this->allocated);
+    capacity = std::max(capacity, (size_t)1);
+    this->release();
+
+    int node_rank;
+    MPI_Comm_rank(node, &node_rank);
+
+    void * local;
+    MPI_Win_allocate_shared(node_rank == 0 ? capacity : 0, 1, MPI_INFO_NULL, node,
+        &local, &this->window);
+
+    MPI_Aint size;
+    int unit;
+    void * leader;
+    MPI_Win_shared_query(this->window, 0, &size, &unit, &leader);
+    this->base = (uint8_t *)leader;
+    this->allocated = capacity;
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, this->window);
+}
+
+/**
+ * Make every rank's writes visible to the whole node, collective over the
+ * node.
+ * @param node MPI_Comm, ranks sharing memory.
+ */
+void SharedWindow::synchronize(MPI_Comm node) {
+    MPI_Win_sync(this->window);
+    MPI_Barrier(node);
+    MPI_Win_sync(this->window);
+}
+
+/**
+ * Free the window, collective over the node.
+ */
+void SharedWindow::release() {
+    if (this->window == MPI_WIN_NULL) {
+        return;
+    }
+
+    MPI_Win_unlock_all(this->window);
+    MPI_Win_free(&this->window);
+    this->base = nullptr;
+    this->allocated = 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "transport.h"
+
+/**
+ * One buffer per node in an MPI-3 shared-memory window. The node leader
+ * (rank 0 of the node communicator) owns the memory and every rank of the
+ * node reads and writes it through plain pointers. The window stays in a
+ * passive target epoch from allocation to release, so synchronize is the
+ * only call needed between writing and reading.
+ */
+class SharedWindow {
+public:
+    SharedWindow() {}
+    ~SharedWindow() { this->release(); }
+    SharedWindow(const SharedWindow &) = delete;
+    SharedWindow & operator=(const SharedWindow &) = delete;
+
+    void reserve(MPI_Comm node, size_t bytes);
+    void synchronize(MPI_Comm node);
+    void release();
+
+    uint8_t * data() const { return this->base; }
+    size_t capacity() const { return this->allocated; }
+
+private:
+    MPI_Win window = MPI_WIN_NULL;
+    uint8_t * base = nullptr;  // The leader's memory, mapped on every rank.
+    size_t allocated = 0;
+};
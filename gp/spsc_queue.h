@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+/**
+ * Unbounded lock-free queue for one producer thread and one consumer
+ * thread. push never waits for the consumer, pop returns false when the
+ * queue is empty. The list always holds one node the consumer has already
+ * taken, so the two threads never touch the same node's link at once.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    SpscQueue() { this->head = this->tail = new Node(); }
+    ~SpscQueue() {
+        while (this->head != nullptr) {
+            Node * next = this->head->next.load(std::memory_order_relaxed);
+            delete this->head;
+            this->head = next;
+        }
+    }
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue & operator=(const SpscQueue &) = delete;
+
+    /**
+     * Append a value, producer only.
+     * @param value T, moved in.
+     */
+    void push(T && value) {
+        Node * node = new Node();
+        node->value = std::move(value);
+        this->tail->next.store(node, std::memory_order_release);
+        this->tail = node;
+    }
+
+    /**
+     * Take the oldest value, consumer only.
+     * @param  value T, set to the value taken.
+     * @return       bool, false if there was none.
+     */
+    bool pop(T & value) {
+        Node * next = this->head->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+
+        value = std::move(next->value);
+        delete this->head;
+        this->head = next;
+        return true;
+    }
+
+private:
+    struct Node {
+        T value;
+        std::atomic<Node *> next{nullptr};
+    };
+
+    Node * head; // Consumer only, the last node taken.
+    Node * tail; // Producer only, the last node pushed.
+};
@@ -0,0 +1,169 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "population.h"
+#include "individual.h"
+#include "linear.h"
+#include "linear_population.h"
+#include "engine.h"
+#include "statistics.h"
+
+using std::vector;
+using std::shared_ptr;
+
+/**
+ * Partial results of one block of the sweep.
+ */
+struct BlockSums {
+    double rmse_sum = 0;
+    double rmse_sumsq = 0;
+    long node_sum = 0;
+    double node_sumsq = 0;
+    float max_rmse = -HUGE_VALF;
+    float min_rmse = HUGE_VALF;
+    int max_nodes = std::numeric_limits<int>::min();
+    int min_nodes = std::numeric_limits<int>::max();
+    float best_fitness = HUGE_VALF;
+    size_t best = 0;
+};
+
+/**
+ * Sample standard deviation from a sum and a sum of squares.
+ */
+static float deviation(double sum, double sumsq, size_t n) {
+    return std::sqrt((n * sumsq - sum * sum) / (n * (n - 1.0)));
+}
+
+/**
+ * Fitness and size of every individual, in population order. Sizes are
+ * counted in blocks spawned as tasks, so call this from a parallel region's
+ * single thread (or serially).
+ * @param population shared_ptr<PopulationType>
+ * @param fitnesses  vector<float>, set to one fitness per individual.
+ * @param sizes      vector<int>, set to one size per individual.
+ */
+template <typename PopulationType>
+void Statistics::pack(shared_ptr<PopulationType> population,
+        vector<float> & fitnesses, vector<int> & sizes) {
+    size_t n = population->get_length();
+    fitnesses.resize(n);
+    sizes.resize(n);
+
+    for (size_t first = 0; first < n; first += BLOCK) {
+        #pragma omp task shared(population, fitnesses, sizes) firstprivate(first, n)
+        {
+            size_t last = std::min(first + BLOCK, n);
+            for (size_t i = first; i < last; i++) {
+                fitnesses[i] = (*population)[i]->get_fitness();
+                sizes[i] = EngineTraits<PopulationType>::size((*population)[i]);
+            }
+        }
+    }
+
+    #pragma omp taskwait
+}
+
+/**
+ * Every logged statistic of a population. Rmse is fitness less size.
+ * @param  fitnesses vector<float>, one per individual.
+ * @param  sizes     vector<int>, one per individual.
+ * @return           Summary
+ */
+Summary Statistics::summarize(const vector<float> & fitnesses,
+        const vector<int> & sizes) {
+    size_t n = fitnesses.size();
+    size_t num_blocks = (n + BLOCK - 1) / BLOCK;
+    vector<BlockSums> blocks(num_blocks);
+    vector<float> rmses(n);
+
+    for (size_t b = 0; b < num_blocks; b++) {
+        #pragma omp task shared(fitnesses, sizes, blocks, rmses) firstprivate(b, n)
+        {
+            BlockSums sums;
+            size_t first = b * BLOCK;
+            size_t last = std::min(first + BLOCK, n);
+            sums.best = first;
+
+            for (size_t i = first; i < last; i++) {
+                float rmse = fitnesses[i] - sizes[i];
+                rmses[i] = rmse;
+                sums.rmse_sum += rmse;
+                sums.rmse_sumsq += (double)rmse * rmse;
+                sums.node_sum += sizes[i];
+                sums.node_sumsq += (double)sizes[i] * sizes[i];
+                sums.max_rmse = std::max(sums.max_rmse, rmse);
+                sums.min_rmse = std::min(sums.min_rmse, rmse);
+                sums.max_nodes = std::max(sums.max_nodes, sizes[i]);
+                sums.min_nodes = std::min(sums.min_nodes, sizes[i]);
+                if (fitnesses[i] < sums.best_fitness) {
+                    sums.best_fitness = fitnesses[i];
+                    sums.best = i;
+                }
+            }
+            blocks[b] = sums;
+        }
+    }
+
+    #pragma omp taskwait
+
+    // Blocks are combined in order, whoever summed them.
+    BlockSums total;
+    for (const BlockSums & sums : blocks) {
+        total.rmse_sum += sums.rmse_sum;
+        total.rmse_sumsq += sums.rmse_sumsq;
+        total.node_sum += sums.node_sum;
+        total.node_sumsq += sums.node_sumsq;
+        total.max_rmse = std::max(total.max_rmse, sums.max_rmse);
+        total.min_rmse = std::min(total.min_rmse, sums.min_rmse);
+        total.max_nodes = std::max(total.max_nodes, sums.max_nodes);
+        total.min_nodes = std::min(total.min_nodes, sums.min_nodes);
+        if (sums.best_fitness < total.best_fitness) {
+            total.best_fitness = sums.best_fitness;
+            total.best = sums.best;
+        }
+    }
+
+    Summary summary;
+    summary.max_rmse = total.max_rmse;
+    summary.min_rmse = total.min_rmse;
+    summary.mean_rmse = total.rmse_sum / n;
+    summary.rmse_std = deviation(total.rmse_sum, total.rmse_sumsq, n);
+    summary.median_rmse = Statistics::median(std::move(rmses));
+    summary.max_nodes = total.max_nodes;
+    summary.min_nodes = total.min_nodes;
+    summary.mean_nodes = total.node_sum / (double)n;
+    summary.nodes_std = deviation(total.node_sum, total.node_sumsq, n);
+    summary.median_nodes = Statistics::median(sizes);
+    summary.total_nodes = total.node_sum;
+    summary.best = total.best;
+    return summary;
+}
+
+/**
+ * Median by selection, the mean of the two middle values for an even count.
+ * @param  values vector<T>, not empty, taken by value and reordered.
+ * @return        float
+ */
+template <typename T>
+float Statistics::median(vector<T> values) {
+    size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    float upper = values[middle];
+
+    if (values.size() % 2 == 1) {
+        return upper;
+    }
+
+    // The lower middle is the largest value left of the upper one.
+    float lower = *std::max_element(values.begin(), values.begin() + middle);
+    return (lower + upper) / 2;
+}
+
+template void Statistics::pack<Population>(shared_ptr<Population>,
+    vector<float> &, vector<int> &);
+template void Statistics::pack<LinearPopulation>(shared_ptr<LinearPopulation>,
+    vector<float> &, vector<int> &);
+template float Statistics::median<float>(vector<float>);
+template float Statistics::median<int>(vector<int>);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+using std::vector;
+
+/**
+ * What the log reports about one generation.
+ */
+struct Summary {
+    float max_rmse = 0;
+    float min_rmse = 0;
+    float mean_rmse = 0;
+    float rmse_std = 0;
+    float median_rmse = 0;
+    int max_nodes = 0;
+    int min_nodes = 0;
+    float mean_nodes = 0;
+    float nodes_std = 0;
+    float median_nodes = 0;
+    long total_nodes = 0;
+    size_t best = 0; // Lowest fitness, the first one on ties.
+};
+
+/**
+ * Population statistics in one sweep over packed arrays, without sorting
+ * or reordering the population. The sweep is split into fixed blocks of
+ * BLOCK individuals, summed as tasks and combined in block order, so the
+ * result does not depend on the number of threads. Medians are found by
+ * selection in linear time.
+ */
+struct Statistics {
+    static const size_t BLOCK = 4096;
+
+    template <typename PopulationType>
+    static void pack(std::shared_ptr<PopulationType> population,
+                     vector<float> & fitnesses, vector<int> & sizes);
+    static Summary summarize(const vector<float> & fitnesses,
+                             const vector<int> & sizes);
+    template <typename T>
+    static float median(vector<T> values);
+
+private:
+    Statistics() {}
+};
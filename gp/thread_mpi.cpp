@@ -0,0 +1,1069 @@
+#ifdef NO_MPI
+
+#include <vector>
+#include <list>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <omp.h>
+#include "thread_mpi.h"
+
+using std::vector;
+
+/**
+ * Layout of a datatype: blocks of bytes at displacements from the start of
+ * an element, elements are extent bytes apart.
+ */
+struct ThreadType {
+    enum Kind { BYTE, INT, FLOAT, DOUBLE, UINT32, UINT64, DERIVED };
+
+    Kind kind;
+    size_t extent;
+    size_t size;      // Bytes of data in one element.
+    size_t alignment;
+    vector<std::pair<size_t, size_t>> blocks; // (displacement, bytes)
+    bool predefined;
+};
+
+/**
+ * A communicator shared by its members, each holds the same pointer.
+ */
+struct ThreadComm {
+    vector<int> members;        // World rank of each rank.
+    int context;                // Point to point, collectives use context + 1.
+    vector<int> sequence;       // Collectives each rank has started.
+    std::atomic<int> references;
+};
+
+struct Message {
+    int context;
+    int source;  // Rank in the communicator.
+    int tag;
+    vector<uint8_t> data;
+};
+
+/**
+ * A send completes at once, a receive once a message is matched to it, a
+ * reduction once every contribution has been received.
+ */
+struct ThreadRequest {
+    enum Kind { SEND, RECEIVE, REDUCE };
+
+    Kind kind = SEND;
+    bool done = false;       // Guarded by the owner's mailbox.
+    int context = 0;
+    int source = 0;
+    int tag = 0;
+    void * buffer = nullptr;
+    int count = 0;
+    MPI_Datatype type = nullptr;
+    MPI_Status status = {0, 0, 0, 0};
+
+    MPI_Op op = 0;
+    vector<MPI_Request> parts;           // One receive per other rank.
+    vector<vector<uint8_t>> contributions; // Every rank's values, rank order.
+};
+
+/**
+ * Messages not yet received and receives not yet matched, of one rank.
+ */
+struct Mailbox {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::list<Message> queue;
+    std::list<ThreadRequest *> posted;
+};
+
+/**
+ * Memory of every rank of a window.
+ */
+struct ThreadWin {
+    vector<uint8_t *> bases;
+    vector<MPI_Aint> sizes;
+    vector<int> units;
+    MPI_Comm comm;
+    std::atomic<int> references;
+};
+
+namespace {
+
+ThreadType basic(ThreadType::Kind kind, size_t bytes) {
+    ThreadType type;
+    type.kind = kind;
+    type.extent = bytes;
+    type.size = bytes;
+    type.alignment = bytes;
+    type.blocks = {{0, bytes}};
+    type.predefined = true;
+    return type;
+}
+
+ThreadType byte_type = basic(ThreadType::BYTE, 1);
+ThreadType int_type = basic(ThreadType::INT, sizeof(int));
+ThreadType float_type = basic(ThreadType::FLOAT, sizeof(float));
+ThreadType double_type = basic(ThreadType::DOUBLE, sizeof(double));
+ThreadType uint32_type = basic(ThreadType::UINT32, sizeof(uint32_t));
+ThreadType uint64_type = basic(ThreadType::UINT64, sizeof(uint64_t));
+
+vector<std::unique_ptr<Mailbox>> mailboxes; // One per world rank.
+ThreadComm * world_comm = nullptr;
+std::atomic<int> next_context(2);
+thread_local int world_rank = -1; // Set on every thread of a rank's team.
+
+/**
+ * Errors MPI would report, the run cannot go on.
+ */
+void fail(const char * what) {
+    std::cerr << "thread rank " << world_rank << ": " << what << std::endl;
+    std::abort();
+}
+
+/**
+ * World rank of the calling thread, which may be any thread of the rank's
+ * OpenMP team since the drivers call MPI from single regions and tasks.
+ */
+int my_rank() {
+    if (world_rank < 0) {
+        fail("MPI called from a thread outside of the ranks' OpenMP teams");
+    }
+    return world_rank;
+}
+
+int rank_in(MPI_Comm comm) {
+    int rank = my_rank();
+    for (size_t i = 0; i < comm->members.size(); i++) {
+        if (comm->members[i] == rank) {
+            return i;
+        }
+    }
+    fail("not a member of the communicator");
+    return -1;
+}
+
+bool contiguous(MPI_Datatype type) {
+    return type->blocks.size() == 1 && type->blocks[0].first == 0
+        && type->blocks[0].second == type->extent;
+}
+
+/**
+ * Append count elements at buffer to data, without the gaps.
+ */
+void pack(const void * buffer, int count, MPI_Datatype type, vector<uint8_t> & data) {
+    const uint8_t * base = (const uint8_t *)buffer;
+    if (contiguous(type)) {
+        data.insert(data.end(), base, base + count * type->extent);
+        return;
+    }
+
+    data.reserve(data.size() + count * type->size);
+    for (int e = 0; e < count; e++) {
+        for (auto & block : type->blocks) {
+            const uint8_t * start = base + e * type->extent + block.first;
+            data.insert(data.end(), start, start + block.second);
+        }
+    }
+}
+
+/**
+ * Lay bytes of packed data out as elements at buffer, at most count of them.
+ */
+void unpack(const uint8_t * data, size_t bytes, void * buffer, int count,
+        MPI_Datatype type) {
+    if (bytes > count * type->size) {
+        fail("message truncated");
+    }
+
+    uint8_t * base = (uint8_t *)buffer;
+    if (contiguous(type)) {
+        std::memcpy(base, data, bytes);
+        return;
+    }
+
+    size_t offset = 0;
+    for (int e = 0; offset < bytes; e++) {
+        for (auto & block : type->blocks) {
+            std::memcpy(base + e * type->extent + block.first, data + offset,
+                block.second);
+            offset += block.second;
+        }
+    }
+}
+
+/**
+ * Append a block to a derived type, merging it with the last one when they
+ * touch.
+ */
+void add_block(ThreadType * type, size_t displacement, size_t bytes) {
+    if (! type->blocks.empty()
+        && type->blocks.back().first + type->blocks.back().second == displacement) {
+        type->blocks.back().second += bytes;
+    }
+    else {
+        type->blocks.push_back({displacement, bytes});
+    }
+    type->size += bytes;
+}
+
+template <typename T>
+void combine(MPI_Op op, T * values, const T * other, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        values[i] = (op == MPI_SUM) ? values[i] + other[i]
+            : std::max(values[i], other[i]);
+    }
+}
+
+/**
+ * Fold other into values, both packed.
+ */
+void reduce(MPI_Op op, MPI_Datatype type, vector<uint8_t> & values,
+        const vector<uint8_t> & other) {
+    size_t count = values.size() / type->size;
+    switch (type->kind) {
+        case ThreadType::INT:
+            combine(op, (int *)values.data(), (const int *)other.data(), count);
+            break;
+        case ThreadType::FLOAT:
+            combine(op, (float *)values.data(), (const float *)other.data(), count);
+            break;
+        case ThreadType::DOUBLE:
+            combine(op, (double *)values.data(), (const double *)other.data(), count);
+            break;
+        case ThreadType::UINT32:
+            combine(op, (uint32_t *)values.data(), (const uint32_t *)other.data(), count);
+            break;
+        case ThreadType::UINT64:
+            combine(op, (uint64_t *)values.data(), (const uint64_t *)other.data(), count);
+            break;
+        default:
+            fail("reduction over an unsupported datatype");
+    }
+}
+
+bool matches(int context, int source, int tag, const Message & message) {
+    return message.context == context
+        && (source == MPI_ANY_SOURCE || source == message.source)
+        && (tag == MPI_ANY_TAG || tag == message.tag);
+}
+
+/**
+ * Mailbox locked by the caller.
+ */
+void complete(ThreadRequest * request, const Message & message) {
+    unpack(message.data.data(), message.data.size(), request->buffer,
+        request->count, request->type);
+    request->status = {message.source, message.tag, MPI_SUCCESS, message.data.size()};
+    request->done = true;
+}
+
+/**
+ * Hand a message to rank dest of comm: the first posted receive it matches
+ * takes it, otherwise it waits in the queue.
+ */
+void deliver(MPI_Comm comm, int dest, int context, int tag, vector<uint8_t> && data) {
+    if (dest < 0 || dest >= (int)comm->members.size()) {
+        fail("invalid destination rank");
+    }
+
+    Message message = {context, rank_in(comm), tag, std::move(data)};
+    Mailbox & box = *mailboxes[comm->members[dest]];
+    std::lock_guard<std::mutex> lock(box.mutex);
+
+    for (auto it = box.posted.begin(); it != box.posted.end(); ++it) {
+        ThreadRequest * request = *it;
+        if (matches(request->context, request->source, request->tag, message)) {
+            complete(request, message);
+            box.posted.erase(it);
+            box.changed.notify_all();
+            return;
+        }
+    }
+
+    box.queue.push_back(std::move(message));
+    box.changed.notify_all();
+}
+
+/**
+ * Take the oldest matching message, or post the receive for a later one.
+ */
+MPI_Request post_receive(void * buffer, int count, MPI_Datatype type, int source,
+        int tag, int context) {
+    ThreadRequest * request = new ThreadRequest();
+    request->kind = ThreadRequest::RECEIVE;
+    request->buffer = buffer;
+    request->count = count;
+    request->type = type;
+    request->source = source;
+    request->tag = tag;
+    request->context = context;
+
+    Mailbox & box = *mailboxes[my_rank()];
+    std::lock_guard<std::mutex> lock(box.mutex);
+    for (auto it = box.queue.begin(); it != box.queue.end(); ++it) {
+        if (matches(context, source, tag, *it)) {
+            complete(request, *it);
+            box.queue.erase(it);
+            return request;
+        }
+    }
+
+    box.posted.push_back(request);
+    return request;
+}
+
+/**
+ * Own mailbox locked by the caller.
+ */
+bool ready(MPI_Request request) {
+    if (request->kind == ThreadRequest::RECEIVE) {
+        return request->done;
+    }
+    if (request->kind == ThreadRequest::REDUCE) {
+        for (MPI_Request part : request->parts) {
+            if (! part->done) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Free a request that is ready, reductions fold their contributions first.
+ */
+void finish(MPI_Request * request, MPI_Status * status) {
+    ThreadRequest * r = *request;
+    if (r->kind == ThreadRequest::REDUCE) {
+        for (MPI_Request part : r->parts) {
+            delete part;
+        }
+
+        vector<uint8_t> values = r->contributions[0];
+        for (size_t i = 1; i < r->contributions.size(); i++) {
+            reduce(r->op, r->type, values, r->contributions[i]);
+        }
+        unpack(values.data(), values.size(), r->buffer, r->count, r->type);
+    }
+
+    if (status != MPI_STATUS_IGNORE) {
+        *status = r->status;
+    }
+    delete r;
+    *request = MPI_REQUEST_NULL;
+}
+
+int next_tag(MPI_Comm comm) {
+    return comm->sequence[rank_in(comm)]++;
+}
+
+void collective_send(MPI_Comm comm, int dest, int tag, const void * buffer, int count,
+        MPI_Datatype type) {
+    vector<uint8_t> data;
+    pack(buffer, count, type, data);
+    deliver(comm, dest, comm->context + 1, tag, std::move(data));
+}
+
+void collective_receive(MPI_Comm comm, int source, int tag, void * buffer, int count,
+        MPI_Datatype type) {
+    MPI_Request request = post_receive(buffer, count, type, source, tag,
+        comm->context + 1);
+    MPI_Wait(&request, MPI_STATUS_IGNORE);
+}
+
+void local_copy(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+        void * recvbuf, int recvcount, MPI_Datatype recvtype) {
+    vector<uint8_t> data;
+    pack(sendbuf, sendcount, sendtype, data);
+    unpack(data.data(), data.size(), recvbuf, recvcount, recvtype);
+}
+
+uint8_t * at(void * buffer, size_t elements, MPI_Datatype type) {
+    return (uint8_t *)buffer + elements * type->extent;
+}
+
+const uint8_t * at(const void * buffer, size_t elements, MPI_Datatype type) {
+    return (const uint8_t *)buffer + elements * type->extent;
+}
+
+/**
+ * Pointer made on rank 0 of comm, handed to every other rank.
+ */
+template <typename T>
+T * share(MPI_Comm comm, T * made) {
+    int tag = next_tag(comm);
+    if (rank_in(comm) == 0) {
+        for (size_t r = 1; r < comm->members.size(); r++) {
+            collective_send(comm, r, tag, &made, sizeof(T *), MPI_BYTE);
+        }
+        return made;
+    }
+
+    T * received;
+    collective_receive(comm, 0, tag, &received, sizeof(T *), MPI_BYTE);
+    return received;
+}
+
+} // namespace
+
+const MPI_Datatype MPI_BYTE = &byte_type;
+const MPI_Datatype MPI_INT = &int_type;
+const MPI_Datatype MPI_FLOAT = &float_type;
+const MPI_Datatype MPI_DOUBLE = &double_type;
+const MPI_Datatype MPI_UINT32_T = &uint32_type;
+const MPI_Datatype MPI_UINT64_T = &uint64_type;
+
+/**
+ * Run body on ranks threads, each a rank of MPI_COMM_WORLD, and wait for
+ * them. The caller's OpenMP threads (OMP_NUM_THREADS, or one per processor)
+ * are split evenly over the ranks.
+ * @param ranks int, > 0.
+ * @param body  function, what every rank runs.
+ */
+void ThreadMPI::run(int ranks, const std::function<void()> & body) {
+    mailboxes.clear();
+    for (int r = 0; r < ranks; r++) {
+        mailboxes.emplace_back(new Mailbox());
+    }
+
+    world_comm = new ThreadComm();
+    for (int r = 0; r < ranks; r++) {
+        world_comm->members.push_back(r);
+    }
+    world_comm->context = 0;
+    world_comm->sequence.assign(ranks, 0);
+    world_comm->references = ranks;
+
+    int threads = std::max(1, omp_get_max_threads() / ranks);
+    vector<std::thread> workers;
+    for (int r = 0; r < ranks; r++) {
+        workers.emplace_back([r, threads, &body]() {
+            world_rank = r;
+            omp_set_num_threads(threads);
+
+            // A thread's OpenMP teams reuse the threads of its first one, so
+            // tag them once and MPI calls from any of them find the rank.
+            #pragma omp parallel
+            {
+                world_rank = r;
+            }
+            body();
+        });
+    }
+    for (std::thread & worker : workers) {
+        worker.join();
+    }
+
+    delete world_comm;
+    world_comm = nullptr;
+    mailboxes.clear();
+}
+
+MPI_Comm ThreadMPI::world() {
+    return world_comm;
+}
+
+int MPI_Init(int * argc, char *** argv) {
+    return MPI_SUCCESS;
+}
+
+int MPI_Finalize() {
+    return MPI_SUCCESS;
+}
+
+int MPI_Comm_rank(MPI_Comm comm, int * rank) {
+    *rank = rank_in(comm);
+    return MPI_SUCCESS;
+}
+
+int MPI_Comm_size(MPI_Comm comm, int * size) {
+    *size = comm->members.size();
+    return MPI_SUCCESS;
+}
+
+int MPI_Comm_split(MPI_Comm comm, int color, int key, MPI_Comm * newcomm) {
+    int size = comm->members.size();
+    int mine[2] = {color, key};
+    vector<int> all(2 * size);
+    MPI_Allgather(mine, 2, MPI_INT, all.data(), 2, MPI_INT, comm);
+    int tag = next_tag(comm);
+
+    if (color == MPI_UNDEFINED) {
+        *newcomm = MPI_COMM_NULL;
+        return MPI_SUCCESS;
+    }
+
+    vector<int> group;
+    for (int r = 0; r < size; r++) {
+        if (all[2 * r] == color) {
+            group.push_back(r);
+        }
+    }
+    std::stable_sort(group.begin(), group.end(),
+        [&all](int a, int b) { return all[2 * a + 1] < all[2 * b + 1]; });
+
+    if (group[0] == rank_in(comm)) {
+        ThreadComm * made = new ThreadComm();
+        for (int r : group) {
+            made->members.push_back(comm->members[r]);
+        }
+        made->context = next_context.fetch_add(2);
+        made->sequence.assign(group.size(), 0);
+        made->references = group.size();
+
+        for (size_t i = 1; i < group.size(); i++) {
+            collective_send(comm, group[i], tag, &made, sizeof(made), MPI_BYTE);
+        }
+        *newcomm = made;
+    }
+    else {
+        collective_receive(comm, group[0], tag, newcomm, sizeof(MPI_Comm), MPI_BYTE);
+    }
+    return MPI_SUCCESS;
+}
+
+int MPI_Comm_split_type(MPI_Comm comm, int split_type, int key, MPI_Info info,
+        MPI_Comm * newcomm) {
+    // Every thread shares the process's memory.
+    return MPI_Comm_split(comm, 0, key, newcomm);
+}
+
+int MPI_Comm_free(MPI_Comm * comm) {
+    if ((*comm)->references.fetch_sub(1) == 1) {
+        delete *comm;
+    }
+    *comm = MPI_COMM_NULL;
+    return MPI_SUCCESS;
+}
+
+int MPI_Send(const void * buf, int count, MPI_Datatype type, int dest, int tag,
+        MPI_Comm comm) {
+    vector<uint8_t> data;
+    pack(buf, count, type, data);
+    deliver(comm, dest, comm->context, tag, std::move(data));
+    return MPI_SUCCESS;
+}
+
+int MPI_Isend(const void * buf, int count, MPI_Datatype type, int dest, int tag,
+        MPI_Comm comm, MPI_Request * request) {
+    MPI_Send(buf, count, type, dest, tag, comm);
+    *request = new ThreadRequest();
+    return MPI_SUCCESS;
+}
+
+int MPI_Recv(void * buf, int count, MPI_Datatype type, int source, int tag,
+        MPI_Comm comm, MPI_Status * status) {
+    MPI_Request request = post_receive(buf, count, type, source, tag, comm->context);
+    return MPI_Wait(&request, status);
+}
+
+int MPI_Irecv(void * buf, int count, MPI_Datatype type, int source, int tag,
+        MPI_Comm comm, MPI_Request * request) {
+    *request = post_receive(buf, count, type, source, tag, comm->context);
+    return MPI_SUCCESS;
+}
+
+int MPI_Iprobe(int source, int tag, MPI_Comm comm, int * flag, MPI_Status * status) {
+    Mailbox & box = *mailboxes[my_rank()];
+    std::lock_guard<std::mutex> lock(box.mutex);
+
+    *flag = 0;
+    for (const Message & message : box.queue) {
+        if (matches(comm->context, source, tag, message)) {
+            *flag = 1;
+            if (status != MPI_STATUS_IGNORE) {
+                *status = {message.source, message.tag, MPI_SUCCESS,
+                    message.data.size()};
+            }
+            break;
+        }
+    }
+    return MPI_SUCCESS;
+}
+
+int MPI_Probe(int source, int tag, MPI_Comm comm, MPI_Status * status) {
+    Mailbox & box = *mailboxes[my_rank()];
+    std::unique_lock<std::mutex> lock(box.mutex);
+
+    while (true) {
+        for (const Message & message : box.queue) {
+            if (matches(comm->context, source, tag, message)) {
+                if (status != MPI_STATUS_IGNORE) {
+                    *status = {message.source, message.tag, MPI_SUCCESS,
+                        message.data.size()};
+                }
+                return MPI_SUCCESS;
+            }
+        }
+        box.changed.wait(lock);
+    }
+}
+
+int MPI_Get_count(const MPI_Status * status, MPI_Datatype type, int * count) {
+    *count = status->bytes / type->size;
+    return MPI_SUCCESS;
+}
+
+int MPI_Wait(MPI_Request * request, MPI_Status * status) {
+    if (*request == MPI_REQUEST_NULL) {
+        return MPI_SUCCESS;
+    }
+
+    {
+        Mailbox & box = *mailboxes[my_rank()];
+        std::unique_lock<std::mutex> lock(box.mutex);
+        box.changed.wait(lock, [request]() { return ready(*request); });
+    }
+
+    finish(request, status);
+    return MPI_SUCCESS;
+}
+
+int MPI_Waitall(int count, MPI_Request requests[], MPI_Status statuses[]) {
+    for (int i = 0; i < count; i++) {
+        MPI_Wait(&requests[i], statuses == MPI_STATUSES_IGNORE ? MPI_STATUS_IGNORE
+            : &statuses[i]);
+    }
+    return MPI_SUCCESS;
+}
+
+int MPI_Waitany(int count, MPI_Request requests[], int * index, MPI_Status * status) {
+    Mailbox & box = *mailboxes[my_rank()];
+    std::unique_lock<std::mutex> lock(box.mutex);
+
+    while (true) {
+        bool active = false;
+        for (int i = 0; i < count; i++) {
+            if (requests[i] == MPI_REQUEST_NULL) {
+                continue;
+            }
+            active = true;
+
+            if (ready(requests[i])) {
+                lock.unlock();
+                *index = i;
+                finish(&requests[i], status);
+                return MPI_SUCCESS;
+            }
+        }
+
+        if (! active) {
+            *index = MPI_UNDEFINED;
+            return MPI_SUCCESS;
+        }
+        box.changed.wait(lock);
+    }
+}
+
+int MPI_Test(MPI_Request * request, int * flag, MPI_Status * status) {
+    if (*request == MPI_REQUEST_NULL) {
+        *flag = 1;
+        return MPI_SUCCESS;
+    }
+
+    {
+        Mailbox & box = *mailboxes[my_rank()];
+        std::lock_guard<std::mutex> lock(box.mutex);
+        *flag = ready(*request);
+    }
+
+    if (*flag) {
+        finish(request, status);
+    }
+    return MPI_SUCCESS;
+}
+
+int MPI_Barrier(MPI_Comm comm) {
+    int size = comm->members.size(), me = rank_in(comm);
+    int tag = next_tag(comm);
+
+    for (int r = 0; r < size; r++) {
+        if (r != me) {
+            collective_send(comm, r, tag, nullptr, 0, MPI_BYTE);
+        }
+    }
+    for (int r = 0; r < size; r++) {
+        if (r != me) {
+            collective_receive(comm, r, tag, nullptr, 0, MPI_BYTE);
+        }
+    }
+    return MPI_SUCCESS;
+}
+
+int MPI_Bcast(void * buf, int count, MPI_Datatype type, int root, MPI_Comm comm) {
+    int size = comm->members.size(), me = rank_in(comm);
+    int tag = next_tag(comm);
+
+    if (me != root) {
+        collective_receive(comm, root, tag, buf, count, type);
+        return MPI_SUCCESS;
+    }
+
+    for (int r = 0; r < size; r++) {
+        if (r != root) {
+            collective_send(comm, r, tag, buf, count, type);
+        }
+    }
+    return MPI_SUCCESS;
+}
+
+int MPI_Gather(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+        void * recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm) {
+    int size = comm->members.size();
+    vector<int> counts(size, recvcount), displs(size);
+    for (int r = 0; r < size; r++) {
+        displs[r] = r * recvcount;
+    }
+    return MPI_Gatherv(sendbuf, sendcount, sendtype, recvbuf, counts.data(),
+        displs.data(), recvtype, root, comm);
+}
+
+int MPI_Gatherv(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+        void * recvbuf, const int * recvcounts, const int * displs,
+        MPI_Datatype recvtype, int root, MPI_Comm comm) {
+    int size = comm->members.size(), me = rank_in(comm);
+    int tag = next_tag(comm);
+
+    if (me != root) {
+        collective_send(comm, root, tag, sendbuf, sendcount, sendtype);
+        return MPI_SUCCESS;
+    }
+
+    for (int r = 0; r < size; r++) {
+        uint8_t * slot = at(recvbuf, displs[r], recvtype);
+        if (r == root) {
+            local_copy(sendbuf, sendcount, sendtype, slot, recvcounts[r], recvtype);
+        }
+        else {
+            collective_receive(comm, r, tag, slot, recvcounts[r], recvtype);
+        }
+    }
+    return MPI_SUCCESS;
+}
+
+int MPI_Scatter(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+        void * recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm) {
+    int size = comm->members.size();
+    vector<int> counts(size, sendcount), displs(size);
+    for (int r = 0; r < size; r++) {
+        displs[r] = r * sendcount;
+    }
+    return MPI_Scatterv(sendbuf, counts.data(), displs.data(), sendtype, recvbuf,
+        recvcount, recvtype, root, comm);
+}
+
+int MPI_Scatterv(const void * sendbuf, const int * sendcounts, const int * displs,
+        MPI_Datatype sendtype, void * recvbuf, int recvcount, MPI_Datatype recvtype,
+        int root, MPI_Comm comm) {
+    int size = comm->members.size(), me = rank_in(comm);
+    int tag = next_tag(comm);
+
+    if (me != root) {
+        collective_receive(comm, root, tag, recvbuf, recvcount, recvtype);
+        return MPI_SUCCESS;
+    }
+
+    for (int r = 0; r < size; r++) {
+        const uint8_t * slot = at(sendbuf, displs[r], sendtype);
+        if (r == root) {
+            local_copy(slot, sendcounts[r], sendtype, recvbuf, recvcount, recvtype);
+        }
+        else {
+            collective_send(comm, r, tag, slot, sendcounts[r], sendtype);
+        }
+    }
+    return MPI_SUCCESS;
+}
+
+int MPI_Allgather(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+        void * recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm) {
+    int size = comm->members.size();
+    vector<int> counts(size, recvcount), displs(size);
+    for (int r = 0; r < size; r++) {
+        displs[r] = r * recvcount;
+    }
+    return MPI_Allgatherv(sendbuf, sendcount, sendtype, recvbuf, counts.data(),
+        displs.data(), recvtype, comm);
+}
+
+int MPI_Allgatherv(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+        void * recvbuf, const int * recvcounts, const int * displs,
+        MPI_Datatype recvtype, MPI_Comm comm) {
+    int size = comm->members.size(), me = rank_in(comm);
+    int tag = next_tag(comm);
+
+    for (int r = 0; r < size; r++) {
+        if (r != me) {
+            collective_send(comm, r, tag, sendbuf, sendcount, sendtype);
+        }
+    }
+    for (int r = 0; r < size; r++) {
+        uint8_t * slot = at(recvbuf, displs[r], recvtype);
+        if (r == me) {
+            local_copy(sendbuf, sendcount, sendtype, slot, recvcounts[r], recvtype);
+        }
+        else {
+            collective_receive(comm, r, tag, slot, recvcounts[r], recvtype);
+        }
+    }
+    return MPI_SUCCESS;
+}
+
+int MPI_Alltoall(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+        void * recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm) {
+    int size = comm->members.size(), me = rank_in(comm);
+    int tag = next_tag(comm);
+
+    for (int r = 0; r < size; r++) {
+        if (r != me) {
+            collective_send(comm, r, tag, at(sendbuf, r * sendcount, sendtype),
+                sendcount, sendtype);
+        }
+    }
+    for (int r = 0; r < size; r++) {
+        uint8_t * slot = at(recvbuf, r * recvcount, recvtype);
+        if (r == me) {
+            local_copy(at(sendbuf, r * sendcount, sendtype), sendcount, sendtype,
+                slot, recvcount, recvtype);
+        }
+        else {
+            collective_receive(comm, r, tag, slot, recvcount, recvtype);
+        }
+    }
+    return MPI_SUCCESS;
+}
+
+int MPI_Iallreduce(const void * sendbuf, void * recvbuf, int count,
+        MPI_Datatype type, MPI_Op op, MPI_Comm comm, MPI_Request * request) {
+    int size = comm->members.size(), me = rank_in(comm);
+    int tag = next_tag(comm);
+
+    ThreadRequest * r = new ThreadRequest();
+    r->kind = ThreadRequest::REDUCE;
+    r->buffer = recvbuf;
+    r->count = count;
+    r->type = type;
+    r->op = op;
+    r->contributions.resize(size);
+    pack(sendbuf == MPI_IN_PLACE ? recvbuf : sendbuf, count, type,
+        r->contributions[me]);
+
+    // Everyone sends to everyone, so every rank folds the same values in
+    // the same order.
+    for (int i = 0; i < size; i++) {
+        if (i != me) {
+            deliver(comm, i, comm->context + 1, tag,
+                vector<uint8_t>(r->contributions[me]));
+        }
+    }
+    for (int i = 0; i < size; i++) {
+        if (i != me) {
+            r->contributions[i].resize(r->contributions[me].size());
+            r->parts.push_back(post_receive(r->contributions[i].data(),
+                r->contributions[i].size(), MPI_BYTE, i, tag, comm->context + 1));
+        }
+    }
+
+    *request = r;
+    return MPI_SUCCESS;
+}
+
+int MPI_Allreduce(const void * sendbuf, void * recvbuf, int count, MPI_Datatype type,
+        MPI_Op op, MPI_Comm comm) {
+    MPI_Request request;
+    MPI_Iallreduce(sendbuf, recvbuf, count, type, op, comm, &request);
+    return MPI_Wait(&request, MPI_STATUS_IGNORE);
+}
+
+int MPI_Exscan(const void * sendbuf, void * recvbuf, int count, MPI_Datatype type,
+        MPI_Op op, MPI_Comm comm) {
+    int size = comm->members.size(), me = rank_in(comm);
+    int tag = next_tag(comm);
+
+    vector<uint8_t> mine;
+    pack(sendbuf, count, type, mine);
+    for (int r = me + 1; r < size; r++) {
+        collective_send(comm, r, tag, mine.data(), mine.size(), MPI_BYTE);
+    }
+
+    // Rank 0's result is undefined, as in MPI, and left alone.
+    vector<uint8_t> values, other(mine.size());
+    for (int r = 0; r < me; r++) {
+        collective_receive(comm, r, tag, other.data(), other.size(), MPI_BYTE);
+        if (r == 0) {
+            values = other;
+        }
+        else {
+            reduce(op, type, values, other);
+        }
+    }
+    if (me > 0) {
+        unpack(values.data(), values.size(), recvbuf, count, type);
+    }
+    return MPI_SUCCESS;
+}
+
+int MPI_Type_size(MPI_Datatype type, int * size) {
+    *size = type->size;
+    return MPI_SUCCESS;
+}
+
+int MPI_Type_create_struct(int count, const int blocklengths[],
+        const MPI_Aint displacements[], const MPI_Datatype types[],
+        MPI_Datatype * newtype) {
+    ThreadType * type = new ThreadType();
+    type->kind = ThreadType::DERIVED;
+    type->extent = 0;
+    type->size = 0;
+    type->alignment = 1;
+    type->predefined = false;
+
+    for (int i = 0; i < count; i++) {
+        for (int b = 0; b < blocklengths[i]; b++) {
+            for (auto & block : types[i]->blocks) {
+                add_block(type, displacements[i] + b * types[i]->extent + block.first,
+                    block.second);
+            }
+        }
+        type->extent = std::max(type->extent,
+            displacements[i] + blocklengths[i] * types[i]->extent);
+        type->alignment = std::max(type->alignment, types[i]->alignment);
+    }
+
+    // Padded like a C struct of these members.
+    type->extent = (type->extent + type->alignment - 1) / type->alignment
+        * type->alignment;
+    *newtype = type;
+    return MPI_SUCCESS;
+}
+
+int MPI_Type_vector(int count, int blocklength, int stride, MPI_Datatype oldtype,
+        MPI_Datatype * newtype) {
+    ThreadType * type = new ThreadType();
+    type->kind = ThreadType::DERIVED;
+    type->size = 0;
+    type->alignment = oldtype->alignment;
+    type->predefined = false;
+
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < blocklength; j++) {
+            for (auto & block : oldtype->blocks) {
+                add_block(type, ((size_t)i * stride + j) * oldtype->extent + block.first,
+                    block.second);
+            }
+        }
+    }
+    type->extent = count > 0
+        ? ((size_t)(count - 1) * stride + blocklength) * oldtype->extent : 0;
+
+    *newtype = type;
+    return MPI_SUCCESS;
+}
+
+int MPI_Type_commit(MPI_Datatype * type) {
+    return MPI_SUCCESS;
+}
+
+int MPI_Type_free(MPI_Datatype * type) {
+    if (! (*type)->predefined) {
+        delete *type;
+    }
+    *type = nullptr;
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_allocate(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm,
+        void * baseptr, MPI_Win * win) {
+    MPI_Comm window_comm;
+    MPI_Comm_split(comm, 0, rank_in(comm), &window_comm);
+    int ranks = window_comm->members.size(), me = rank_in(window_comm);
+
+    ThreadWin * made = nullptr;
+    if (me == 0) {
+        made = new ThreadWin();
+        made->bases.assign(ranks, nullptr);
+        made->sizes.assign(ranks, 0);
+        made->units.assign(ranks, 1);
+        made->comm = window_comm;
+        made->references = ranks;
+    }
+    ThreadWin * window = share(window_comm, made);
+
+    window->bases[me] = new uint8_t[std::max(size, (MPI_Aint)1)]();
+    window->sizes[me] = size;
+    window->units[me] = disp_unit;
+    MPI_Barrier(window_comm);
+
+    *(void **)baseptr = window->bases[me];
+    *win = window;
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_allocate_shared(MPI_Aint size, int disp_unit, MPI_Info info,
+        MPI_Comm comm, void * baseptr, MPI_Win * win) {
+    // Any rank's memory is visible to every thread.
+    return MPI_Win_allocate(size, disp_unit, info, comm, baseptr, win);
+}
+
+int MPI_Win_shared_query(MPI_Win win, int rank, MPI_Aint * size, int * disp_unit,
+        void * baseptr) {
+    *size = win->sizes[rank];
+    *disp_unit = win->units[rank];
+    *(void **)baseptr = win->bases[rank];
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_lock_all(int assertion, MPI_Win win) {
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_unlock_all(MPI_Win win) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_sync(MPI_Win win) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_flush(int rank, MPI_Win win) {
+    // Puts are done when they return.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_free(MPI_Win * win) {
+    ThreadWin * window = *win;
+    MPI_Comm window_comm = window->comm;
+    int me = rank_in(window_comm);
+
+    // Nobody touches this rank's memory once everyone is here.
+    MPI_Barrier(window_comm);
+    delete[] window->bases[me];
+    window->bases[me] = nullptr;
+
+    if (window->references.fetch_sub(1) == 1) {
+        delete window;
+    }
+    MPI_Comm_free(&window_comm);
+    *win = MPI_WIN_NULL;
+    return MPI_SUCCESS;
+}
+
+int MPI_Put(const void * origin, int origin_count, MPI_Datatype origin_type,
+        int target, MPI_Aint displacement, int target_count, MPI_Datatype target_type,
+        MPI_Win win) {
+    vector<uint8_t> data;
+    pack(origin, origin_count, origin_type, data);
+    unpack(data.data(), data.size(),
+        win->bases[target] + displacement * win->units[target], target_count,
+        target_type);
+    return MPI_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * In-process stand-in for the part of MPI the drivers use, compiled in with
+ * NO_MPI instead of linking an MPI library (see transport.h). Ranks are
+ * threads of one process started by ThreadMPI::run, the way mpirun starts
+ * processes, and every call keeps MPI's semantics for those ranks:
+ *
+ *  - Point to point messages are copied into the receiver's mailbox, so
+ *    sends never block. Receives match in posting order and messages from
+ *    one source in sending order, as in MPI.
+ *  - Collectives are built from messages on a context of their own, tagged
+ *    with a per communicator sequence number, so they never match user
+ *    messages or each other. Reductions add up contributions in rank order,
+ *    so every rank gets the same bits.
+ *  - Windows are plain memory shared by the threads, puts copy straight
+ *    into the target. Every rank is on one node.
+ */
+
+struct ThreadComm;
+struct ThreadRequest;
+struct ThreadType;
+struct ThreadWin;
+
+typedef ThreadComm * MPI_Comm;
+typedef ThreadRequest * MPI_Request;
+typedef ThreadType * MPI_Datatype;
+typedef ThreadWin * MPI_Win;
+typedef std::ptrdiff_t MPI_Aint;
+typedef int MPI_Info;
+typedef int MPI_Op;
+
+struct MPI_Status {
+    int MPI_SOURCE;
+    int MPI_TAG;
+    int MPI_ERROR;
+    size_t bytes; // Size of the message, for MPI_Get_count.
+};
+
+const int MPI_SUCCESS = 0;
+const int MPI_ANY_SOURCE = -1;
+const int MPI_ANY_TAG = -1;
+const int MPI_UNDEFINED = -32766;
+const int MPI_INFO_NULL = 0;
+const int MPI_MODE_NOCHECK = 1;
+const int MPI_COMM_TYPE_SHARED = 1;
+const MPI_Op MPI_SUM = 1;
+const MPI_Op MPI_MAX = 2;
+
+#define MPI_COMM_NULL ((MPI_Comm)nullptr)
+#define MPI_REQUEST_NULL ((MPI_Request)nullptr)
+#define MPI_WIN_NULL ((MPI_Win)nullptr)
+#define MPI_STATUS_IGNORE ((MPI_Status *)nullptr)
+#define MPI_STATUSES_IGNORE ((MPI_Status *)nullptr)
+#define MPI_IN_PLACE ((void *)1)
+#define MPI_COMM_WORLD (ThreadMPI::world())
+
+extern const MPI_Datatype MPI_BYTE;
+extern const MPI_Datatype MPI_INT;
+extern const MPI_Datatype MPI_FLOAT;
+extern const MPI_Datatype MPI_DOUBLE;
+extern const MPI_Datatype MPI_UINT32_T;
+extern const MPI_Datatype MPI_UINT64_T;
+
+/**
+ * Starts the thread ranks.
+ */
+class ThreadMPI {
+public:
+    static void run(int ranks, const std::function<void()> & body);
+    static MPI_Comm world();
+
+private:
+    ThreadMPI() {}
+};
+
+int MPI_Init(int * argc, char *** argv);
+int MPI_Finalize();
+
+int MPI_Comm_rank(MPI_Comm comm, int * rank);
+int MPI_Comm_size(MPI_Comm comm, int * size);
+int MPI_Comm_split(MPI_Comm comm, int color, int key, MPI_Comm * newcomm);
+int MPI_Comm_split_type(MPI_Comm comm, int split_type, int key, MPI_Info info,
+                        MPI_Comm * newcomm);
+int MPI_Comm_free(MPI_Comm * comm);
+
+int MPI_Send(const void * buf, int count, MPI_Datatype type, int dest, int tag,
+             MPI_Comm comm);
+int MPI_Isend(const void * buf, int count, MPI_Datatype type, int dest, int tag,
+              MPI_Comm comm, MPI_Request * request);
+int MPI_Recv(void * buf, int count, MPI_Datatype type, int source, int tag,
+             MPI_Comm comm, MPI_Status * status);
+int MPI_Irecv(void * buf, int count, MPI_Datatype type, int source, int tag,
+              MPI_Comm comm, MPI_Request * request);
+int MPI_Probe(int source, int tag, MPI_Comm comm, MPI_Status * status);
+int MPI_Iprobe(int source, int tag, MPI_Comm comm, int * flag, MPI_Status * status);
+int MPI_Get_count(const MPI_Status * status, MPI_Datatype type, int * count);
+int MPI_Wait(MPI_Request * request, MPI_Status * status);
+int MPI_Waitall(int count, MPI_Request requests[], MPI_Status statuses[]);
+int MPI_Waitany(int count, MPI_Request requests[], int * index, MPI_Status * status);
+int MPI_Test(MPI_Request * request, int * flag, MPI_Status * status);
+
+int MPI_Barrier(MPI_Comm comm);
+int MPI_Bcast(void * buf, int count, MPI_Datatype type, int root, MPI_Comm comm);
+int MPI_Gather(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+               void * recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+               MPI_Comm comm);
+int MPI_Gatherv(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+                void * recvbuf, const int * recvcounts, const int * displs,
+                MPI_Datatype recvtype, int root, MPI_Comm comm);
+int MPI_Scatter(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+                void * recvbuf, int recvcount, MPI_Datatype recvtype, int root,
+                MPI_Comm comm);
+int MPI_Scatterv(const void * sendbuf, const int * sendcounts, const int * displs,
+                 MPI_Datatype sendtype, void * recvbuf, int recvcount,
+                 MPI_Datatype recvtype, int root, MPI_Comm comm);
+int MPI_Allgather(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+                  void * recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm);
+int MPI_Allgatherv(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+                   void * recvbuf, const int * recvcounts, const int * displs,
+                   MPI_Datatype recvtype, MPI_Comm comm);
+int MPI_Alltoall(const void * sendbuf, int sendcount, MPI_Datatype sendtype,
+                 void * recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm);
+int MPI_Allreduce(const void * sendbuf, void * recvbuf, int count, MPI_Datatype type,
+                  MPI_Op op, MPI_Comm comm);
+int MPI_Iallreduce(const void * sendbuf, void * recvbuf, int count,
+                   MPI_Datatype type, MPI_Op op, MPI_Comm comm, MPI_Request * request);
+int MPI_Exscan(const void * sendbuf, void * recvbuf, int count, MPI_Datatype type,
+               MPI_Op op, MPI_Comm comm);
+
+int MPI_Type_size(MPI_Datatype type, int * size);
+int MPI_Type_create_struct(int count, const int blocklengths[],
+                           const MPI_Aint displacements[], const MPI_Datatype types[],
+                           MPI_Datatype * newtype);
+int MPI_Type_vector(int count, int blocklength, int stride, MPI_Datatype oldtype,
+                    MPI_Datatype * newtype);
+int MPI_Type_commit(MPI_Datatype * type);
+int MPI_Type_free(MPI_Datatype * type);
+
+int MPI_Win_allocate(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm,
+                     void * baseptr, MPI_Win * win);
+int MPI_Win_allocate_shared(MPI_Aint size, int disp_unit, MPI_Info info,
+                            MPI_Comm comm, void * baseptr, MPI_Win * win);
+int MPI_Win_shared_query(MPI_Win win, int rank, MPI_Aint * size, int * disp_unit,
+                         void * baseptr);
+int MPI_Win_lock_all(int assertion, MPI_Win win);
+int MPI_Win_unlock_all(MPI_Win win);
+int MPI_Win_sync(MPI_Win win);
+int MPI_Win_flush(int rank, MPI_Win win);
+int MPI_Win_free(MPI_Win * win);
+int MPI_Put(const void * origin, int origin_count, MPI_Datatype origin_type,
+            int target, MPI_Aint displacement, int target_count,
+            MPI_Datatype target_type, MPI_Win win);
@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * MPI for the drivers: the library by default, or the thread transport when
+ * built with NO_MPI, where ranks are threads of one process.
+ */
+#ifdef NO_MPI
+#include "thread_mpi.h"
+#else
+#include "mpi.h"
+#endif
@@ -0,0 +1,48 @@
+#include <vector>
+#include "balance.h"
+#include "work_queue.h"
+
+using std::vector;
+
+/**
+ * Queue new work, replacing anything left.
+ * @param costs vector<double>, estimated cost of each record.
+ */
+void WorkQueue::reset(const vector<double> & costs) {
+    this->order = Balance::largest_first(costs);
+    this->costs.resize(costs.size());
+    this->remaining = 0;
+
+    for (size_t k = 0; k < this->order.size(); k++) {
+        this->costs[k] = costs[this->order[k]];
+        this->remaining += this->costs[k];
+    }
+
+    this->position = 0;
+}
+
+/**
+ * Take the next chunk, worth about half of a fair share of what is left.
+ * @param  begin size_t, set to the first position in get_order.
+ * @param  end   size_t, set to one past the last position.
+ * @return       bool, false once the queue is empty.
+ */
+bool WorkQueue::next(size_t & begin, size_t & end) {
+    if (this->empty()) {
+        return false;
+    }
+
+    double target = this->remaining / (2.0 * this->workers);
+    double taken = 0;
+
+    begin = this->position;
+    end = begin;
+    do {
+        taken += this->costs[end];
+        end++;
+    } while (end < this->order.size() && taken + this->costs[end] <= target);
+
+    this->position = end;
+    this->remaining -= taken;
+    return true;
+}
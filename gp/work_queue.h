@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+using std::vector;
+
+/**
+ * Guided self-scheduling over estimated costs. Work is handed out largest
+ * first in chunks worth a fixed fraction of the cost still queued, so early
+ * chunks are big (few messages) and the last ones are single records that
+ * fill the gaps between ranks finishing at different times.
+ */
+class WorkQueue {
+public:
+    /**
+     * Constructor.
+     * @param _workers int, ranks taking work from the queue.
+     */
+    WorkQueue(int _workers) : workers(_workers) {}
+
+    void reset(const vector<double> & costs);
+    bool next(size_t & begin, size_t & end);
+
+    /**
+     * Work in queue order, chunks are ranges of it.
+     */
+    const vector<size_t> & get_order() const { return this->order; }
+    bool empty() const { return this->position == this->order.size(); }
+
+private:
+    int workers;
+    vector<size_t> order;  // Indices into costs, largest first.
+    vector<double> costs;  // In queue order.
+    size_t position = 0;   // First record not handed out.
+    double remaining = 0;  // Cost not handed out.
+};
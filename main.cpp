@@ -2,7 +2,13 @@
 #include <iostream>
 #include <getopt.h>
 #include "gp/driver.h"
+#include "gp/evolution.h"
 #include "gp/function.h"
+#include "gp/selection.h"
+#include "gp/migration.h"
+#ifdef NO_MPI
+#include "gp/thread_mpi.h"
+#endif
 
 const char MUTATION_RATE = 'm';
 const char CROSSOVER_RATE = 'c';
@@ -11,6 +17,24 @@ const char FUNCTION = 'f';
 const char POPULATION_SIZE = 'p';
 const char GENERATIONS = 'g';
 const char OUTPUT = 'o';
+const char ENGINE = 'e';
+const char TARGET_RMSE = 't';
+const char STEADY_STATE = 'a';
+const char BLOAT_CONTROL = 'b';
+const char SELECTION = 'r';
+const char REPLICATE = 'd';
+const char TOPOLOGY = 'i';
+const char MIGRATION_INTERVAL = 'k';
+const char MIGRANTS = 'n';
+const char WORK_QUEUE = 'w';
+const char PIPELINE_CHUNKS = 'l';
+const char NUM_SAMPLES = 'x';
+const char SHARD_SAMPLES = 'h';
+const char SHARE_NODES = 'j';
+const char PUT_RESULTS = 'q';
+const char THREAD_RANKS = 'u';
+const char CHECKPOINT_INTERVAL = 'v';
+const char RESUME = 'z';
 
 using namespace std;
 
@@ -23,6 +47,8 @@ int main(int argc, char ** argv) {
     int generations = -1;
     int function = -1;
     string output_dir = "";
+    DriverOptions options;
+    int thread_ranks = 1;
 
     //
     // Get command line arguments.
@@ -33,8 +59,28 @@ int main(int argc, char ** argv) {
     //  -f <int> function, from FunctionFactory::FunctionType enum
     //  -p <int> population size, > 0
     //  -g <int> generations, > 0
+    //  -o <string> output directory
+    // Optional arguments are:
+    //  -e <int> engine, from Driver::Engine enum (default tree)
+    //  -t <float> target rmse, stop once the best individual reaches it
+    //  -a asynchronous steady-state evolution instead of generations
+    //  -b <int> bloat control, sum of Evolution::BloatControl flags
+    //  -r <int> selection, from Selection::Method enum (default tournament)
+    //  -d distributed breeding, every rank keeps a replica of the population
+    //  -i <int> island model, from Migration::Topology enum (default none)
+    //  -k <int> generations between migrations (default 10)
+    //  -n <int> migrants sent to each neighbour (default 2)
+    //  -w hybrid ranks take chunks from a work queue instead of a static split
+    //  -l <int> hybrid records are streamed to each rank in this many chunks (default 1)
+    //  -x <int> samples drawn each generation (default 100)
+    //  -h replicas split the samples too, over an automatic grid of ranks
+    //  -j hybrid ranks on one node share records and results in shared memory
+    //  -q hybrid ranks put their results into an RMA window on the master
+    //  -u <int> ranks run as threads of this process, in a build without MPI (default 1)
+    //  -v <int> generations between binary checkpoints, also written on SIGTERM (default 0, none)
+    //  -z <string> checkpoint file to resume the run from
     //
-    while((c = getopt(argc, argv, "m:c:s:f:p:g:o:")) != -1) {
+    while((c = getopt(argc, argv, "m:c:s:f:p:g:o:e:t:ab:r:di:k:n:wl:x:hjqu:v:z:")) != -1) {
         switch(c) {
             case MUTATION_RATE:
                 mutation_rate = stof(optarg);
@@ -79,6 +125,124 @@ int main(int argc, char ** argv) {
                 output_dir = optarg;
                 break;
 
+            case ENGINE:
+                options.engine = stoi(optarg);
+
+                if (options.engine != Driver::TREE && options.engine != Driver::LINEAR) {
+                    cerr << "Invalid engine: " << options.engine << endl;
+                    return 1;
+                }
+                break;
+            case TARGET_RMSE:
+                options.target_rmse = stof(optarg);
+
+                if (options.target_rmse < 0) {
+                    cerr << "Invalid target rmse: " << options.target_rmse << endl;
+                    return 1;
+                }
+                break;
+            case STEADY_STATE:
+                options.steady_state = true;
+                break;
+            case BLOAT_CONTROL:
+                options.bloat_control = stoi(optarg);
+
+                if (options.bloat_control < 0 || options.bloat_control > 7) {
+                    cerr << "Invalid bloat control: " << options.bloat_control << endl;
+                    return 1;
+                }
+                break;
+            case SELECTION:
+                options.selection = stoi(optarg);
+
+                if (options.selection < Selection::TOURNAMENT
+                    || options.selection > Selection::PARETO) {
+                    cerr << "Invalid selection: " << options.selection << endl;
+                    return 1;
+                }
+                break;
+            case REPLICATE:
+                options.replicate = true;
+                break;
+            case TOPOLOGY:
+                options.topology = stoi(optarg);
+
+                if (options.topology < Migration::NONE
+                    || options.topology > Migration::RANDOM) {
+                    cerr << "Invalid topology: " << options.topology << endl;
+                    return 1;
+                }
+                break;
+            case WORK_QUEUE:
+                options.work_queue = true;
+                break;
+            case PIPELINE_CHUNKS:
+                options.pipeline_chunks = stoi(optarg);
+
+                if (options.pipeline_chunks < 1) {
+                    cerr << "Invalid number of chunks: " << options.pipeline_chunks << endl;
+                    return 1;
+                }
+                break;
+            case NUM_SAMPLES:
+                options.num_samples = stoi(optarg);
+
+                if (options.num_samples < 1) {
+                    cerr << "Invalid number of samples: " << options.num_samples << endl;
+                    return 1;
+                }
+                break;
+            case SHARD_SAMPLES:
+                options.shard_samples = true;
+                break;
+            case SHARE_NODES:
+                options.share_nodes = true;
+                break;
+            case PUT_RESULTS:
+                options.put_results = true;
+                break;
+            case THREAD_RANKS:
+                thread_ranks = stoi(optarg);
+
+                if (thread_ranks < 1) {
+                    cerr << "Invalid number of thread ranks: " << thread_ranks << endl;
+                    return 1;
+                }
+#ifndef NO_MPI
+                if (thread_ranks > 1) {
+                    cerr << "Thread ranks need a build with NO_MPI=1, start ranks with mpirun instead" << endl;
+                    return 1;
+                }
+#endif
+                break;
+            case CHECKPOINT_INTERVAL:
+                options.checkpoint_interval = stoi(optarg);
+
+                if (options.checkpoint_interval < 0) {
+                    cerr << "Invalid checkpoint interval: " << options.checkpoint_interval << endl;
+                    return 1;
+                }
+                break;
+            case RESUME:
+                options.resume_file = optarg;
+                break;
+            case MIGRATION_INTERVAL:
+                options.migration_interval = stoi(optarg);
+
+                if (options.migration_interval < 1) {
+                    cerr << "Invalid migration interval: " << options.migration_interval << endl;
+                    return 1;
+                }
+                break;
+            case MIGRANTS:
+                options.migrants = stoi(optarg);
+
+                if (options.migrants < 1) {
+                    cerr << "Invalid number of migrants: " << options.migrants << endl;
+                    return 1;
+                }
+                break;
+
             default:
                 cerr << "Invalid usage commnand line arguments, exiting..." << endl;
                 return 1;
@@ -99,10 +263,54 @@ int main(int argc, char ** argv) {
             return 1;
     }
 
-    // Construct the driver and start computation.
+    // Only generational runs whose master holds the population checkpoint.
+    if ((options.checkpoint_interval > 0 || ! options.resume_file.empty()) &&
+        (options.steady_state || options.topology != Migration::NONE ||
+         options.replicate || options.shard_samples)) {
+            cerr << "Checkpoints are not supported with -a, -i, -d or -h" << endl;
+            return 1;
+    }
+
+    // Work queues, streaming, shared memory and result windows belong to hybrid mode.
+    if ((options.work_queue || options.pipeline_chunks > 1 || options.share_nodes ||
+         options.put_results) &&
+        (options.steady_state || options.topology != Migration::NONE ||
+         options.replicate || options.shard_samples)) {
+            cerr << "-w, -l, -j and -q are not supported with -a, -i, -d or -h" << endl;
+            return 1;
+    }
+
+    // Node memory is only shared by the static split.
+    if (options.share_nodes && (options.work_queue || options.pipeline_chunks > 1)) {
+        cerr << "-j is not supported with -w or -l" << endl;
+        return 1;
+    }
+
+    // Steady-state parents are always picked by tournament over the live population.
+    if (options.steady_state && options.selection != Selection::TOURNAMENT) {
+        cerr << "Only tournament selection (-r 0) is supported with -a" << endl;
+        return 1;
+    }
+
+    // Steady-state replacement has no generation to move the dynamic limit at.
+    if (options.steady_state && (options.bloat_control & Evolution::DYNAMIC_LIMIT)) {
+        cerr << "The dynamic limit (-b 4) is not supported with -a" << endl;
+        return 1;
+    }
+
+    // Construct the driver and start computation, once per rank.
+#ifdef NO_MPI
+    ThreadMPI::run(thread_ranks, [&]() {
+        Driver driver(mutation_rate, crossover_rate, seed, function,
+                               population_size, generations, output_dir, options);
+
+        driver.evolve(argc, argv);
+    });
+#else
     Driver driver(mutation_rate, crossover_rate, seed, function,
-                           population_size, generations, output_dir);
+                           population_size, generations, output_dir, options);
 
     driver.evolve(argc, argv);
+#endif
     return 0;
 }
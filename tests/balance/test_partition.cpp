@@ -0,0 +1,72 @@
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include "../../gp/balance.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::vector;
+
+TEST_CASE("Largest first ordering", "[unit]") {
+    vector<double> costs = {3, 9, 1, 9, 4};
+    vector<size_t> expected = {1, 3, 4, 0, 2};
+    REQUIRE(Balance::largest_first(costs) == expected);
+}
+
+TEST_CASE("Partition balances a skewed population", "[unit]") {
+    // One huge program and many small ones, a count split puts the huge one
+    // on a rank along with a full share of the rest.
+    vector<double> costs(101, 3);
+    costs[0] = 100;
+
+    vector<vector<int>> assignment;
+    vector<double> loads = Balance::partition(costs, 4, assignment);
+
+    REQUIRE(assignment.size() == 4);
+    REQUIRE(assignment[0] == vector<int>{0});
+
+    // Every individual is assigned exactly once.
+    vector<int> all;
+    for (auto & part : assignment) {
+        all.insert(all.end(), part.begin(), part.end());
+    }
+    std::sort(all.begin(), all.end());
+    for (int i = 0; i < 101; i++) {
+        REQUIRE(all[i] == i);
+    }
+
+    // Within a part indices stay largest first.
+    for (auto & part : assignment) {
+        for (size_t j = 1; j < part.size(); j++) {
+            REQUIRE(costs[part[j - 1]] >= costs[part[j]]);
+        }
+    }
+
+    REQUIRE(loads[0] == 100);
+    REQUIRE(Balance::imbalance(loads) < 1.05);
+}
+
+TEST_CASE("Partition follows capacities", "[unit]") {
+    vector<double> costs(300, 1);
+    for (size_t i = 0; i < costs.size(); i += 7) {
+        costs[i] = 5;
+    }
+
+    // A node with twice the ranks takes twice the work.
+    vector<vector<int>> assignment;
+    vector<double> loads = Balance::partition(costs, {2, 1}, assignment);
+    REQUIRE(assignment.size() == 2);
+    REQUIRE(assignment[0].size() + assignment[1].size() == costs.size());
+    REQUIRE(loads[0] / 2 == Approx(loads[1]).epsilon(0.02));
+
+    // Equal capacities split like the plain partition.
+    vector<vector<int>> weighted, plain;
+    Balance::partition(costs, {1, 1, 1}, weighted);
+    Balance::partition(costs, 3, plain);
+    REQUIRE(weighted == plain);
+}
+
+TEST_CASE("Imbalance is the largest load over the mean", "[unit]") {
+    REQUIRE(Balance::imbalance({1, 1, 1, 1}) == Approx(1));
+    REQUIRE(Balance::imbalance({4, 0, 0, 0}) == Approx(4));
+    REQUIRE(Balance::imbalance({}) == Approx(1));
+}
@@ -0,0 +1,176 @@
+#include <random>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+#include "../../gp/engine.h"
+#include "../../gp/checkpoint.h"
+#include "../../gp/population.h"
+#include "../../gp/individual.h"
+#include "../../gp/linear.h"
+#include "../../gp/linear_population.h"
+#include "../../gp/serialization.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::mt19937; using std::vector;
+
+const char * FILE_NAME = "test_checkpoint.bin";
+
+/**
+ * Records of every individual, in order.
+ */
+template <typename PopulationType>
+vector<uint8_t> records(PopulationType & population) {
+    vector<uint8_t> buffer;
+    GenomeWriter writer(buffer);
+    for (size_t i = 0; i < population.get_length(); i++) {
+        EngineTraits<PopulationType>::encode(population[i], writer);
+    }
+    return buffer;
+}
+
+/**
+ * Fitness i for individual i.
+ */
+template <typename PopulationType>
+void rank_fitnesses(PopulationType & population) {
+    for (size_t i = 0; i < population.get_length(); i++) {
+        population[i]->set_fitness(i);
+    }
+}
+
+/**
+ * Save a population one update in, load it elsewhere and check both breed
+ * the same next generation.
+ */
+template <typename PopulationType>
+void check_resume(int engine_type) {
+    typedef EngineTraits<PopulationType> Traits;
+    mt19937 engine(5);
+    PopulationType population(100, 4);
+    population.initialize(engine, Traits::MIN_INIT, Traits::MAX_INIT);
+    rank_fitnesses(population);
+    population.update(engine, 0.9, 0.1);
+    rank_fitnesses(population);
+
+    {
+        Checkpoint checkpoint(FILE_NAME, engine_type, 5, 1, 100, 100);
+        checkpoint.save(population, engine, 7);
+    }
+
+    Checkpoint checkpoint(FILE_NAME, engine_type, 5, 1, 100, 100);
+    PopulationType resumed(100, 4);
+    mt19937 resumed_engine(0);
+    int generation = 0;
+    REQUIRE(checkpoint.load(FILE_NAME, resumed, resumed_engine, generation));
+
+    REQUIRE(generation == 7);
+    REQUIRE(resumed_engine == engine);
+    REQUIRE(resumed.get_state().generation == population.get_state().generation);
+    REQUIRE(resumed.get_state().size_limit == population.get_state().size_limit);
+    REQUIRE(records(resumed) == records(population));
+    for (size_t i = 0; i < population.get_length(); i++) {
+        REQUIRE(resumed[i]->get_fitness() == population[i]->get_fitness());
+    }
+
+    population.update(engine, 0.9, 0.1);
+    resumed.update(resumed_engine, 0.9, 0.1);
+    REQUIRE(records(resumed) == records(population));
+
+    // Another run's checkpoint is refused and leaves the population alone.
+    Checkpoint other(FILE_NAME, engine_type, 6, 1, 100, 100);
+    PopulationType untouched(100, 4);
+    REQUIRE(! other.load(FILE_NAME, untouched, resumed_engine, generation));
+    REQUIRE(untouched.get_length() == 0);
+
+    std::remove(FILE_NAME);
+}
+
+TEST_CASE("Tree checkpoint resumes exactly", "[unit]") {
+    check_resume<Population>(0);
+}
+
+TEST_CASE("Linear checkpoint resumes exactly", "[unit]") {
+    check_resume<LinearPopulation>(1);
+}
+
+TEST_CASE("Missing or truncated checkpoints are refused", "[unit]") {
+    Checkpoint checkpoint(FILE_NAME, 0, 5, 1, 100, 100);
+    Population population(100);
+    mt19937 engine(0);
+    int generation = 0;
+    REQUIRE(! checkpoint.load("no_such_checkpoint.bin", population, engine, generation));
+
+    FILE * file = fopen(FILE_NAME, "wb");
+    fputs("GPCKPT", file);
+    fclose(file);
+    REQUIRE(! checkpoint.load(FILE_NAME, population, engine, generation));
+    std::remove(FILE_NAME);
+}
+
+/**
+ * Try to resume from a tree checkpoint after changing its bytes.
+ */
+template <typename Change>
+bool load_changed(Change change) {
+    mt19937 engine(5);
+    Population population(100);
+    population.initialize(engine, 2, 6);
+    rank_fitnesses(population);
+    {
+        Checkpoint checkpoint(FILE_NAME, 0, 5, 1, 100, 100);
+        checkpoint.save(population, engine, 3);
+    }
+
+    FILE * file = fopen(FILE_NAME, "rb");
+    vector<uint8_t> bytes;
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        bytes.push_back(c);
+    }
+    fclose(file);
+
+    CheckpointHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    change(bytes, header.records_offset);
+
+    file = fopen(FILE_NAME, "wb");
+    fwrite(bytes.data(), 1, bytes.size(), file);
+    fclose(file);
+
+    Checkpoint checkpoint(FILE_NAME, 0, 5, 1, 100, 100);
+    Population resumed(100);
+    int generation = 0;
+    bool loaded = checkpoint.load(FILE_NAME, resumed, engine, generation);
+    std::remove(FILE_NAME);
+    return loaded;
+}
+
+TEST_CASE("Corrupt genome records are refused", "[unit]") {
+    REQUIRE(load_changed([](vector<uint8_t> &, size_t) {}));
+
+    // A length prefix that runs past the end of the file.
+    REQUIRE(! load_changed([](vector<uint8_t> & bytes, size_t records) {
+        uint32_t length = 0xFFFFFF00;
+        std::memcpy(&bytes[records], &length, sizeof(length));
+    }));
+
+    // Trailing bytes after the last record.
+    REQUIRE(! load_changed([](vector<uint8_t> & bytes, size_t records) {
+        bytes.push_back(0);
+        CheckpointHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        header.records_bytes++;
+        std::memcpy(bytes.data(), &header, sizeof(header));
+    }));
+
+    // An unknown opcode.
+    REQUIRE(! load_changed([](vector<uint8_t> & bytes, size_t records) {
+        bytes[records + sizeof(uint32_t)] = 200;
+    }));
+
+    // An operation with nothing on the stack.
+    REQUIRE(! load_changed([](vector<uint8_t> & bytes, size_t records) {
+        bytes[records + sizeof(uint32_t)] = Serialization::OP_ADD;
+    }));
+}
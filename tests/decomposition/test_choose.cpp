@@ -0,0 +1,45 @@
+#include "../../gp/decomposition.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+TEST_CASE("Large populations split individuals only", "[unit]") {
+    Decomposition d = Decomposition::choose(10000, 100, 8);
+    REQUIRE(d.individual_blocks == 8);
+    REQUIRE(d.sample_shards == 1);
+}
+
+TEST_CASE("Small populations shard the samples", "[unit]") {
+    // 64 individuals fill two blocks, the other factor goes to samples.
+    Decomposition d = Decomposition::choose(64, 100000, 8);
+    REQUIRE(d.individual_blocks == 2);
+    REQUIRE(d.sample_shards == 4);
+
+    // Fewer individuals than ranks.
+    d = Decomposition::choose(4, 100000, 16);
+    REQUIRE(d.individual_blocks == 1);
+    REQUIRE(d.sample_shards == 16);
+}
+
+TEST_CASE("Neither fits, both are kept as large as possible", "[unit]") {
+    // 16 individuals and 128 samples over 4 ranks: four sample shards keep
+    // half of each minimum, four blocks only an eighth of MIN_INDIVIDUALS.
+    Decomposition d = Decomposition::choose(16, 128, 4);
+    REQUIRE(d.individual_blocks * d.sample_shards == 4);
+    REQUIRE(d.individual_blocks == 1);
+    REQUIRE(d.sample_shards == 4);
+
+    // With few samples too, splitting individuals loses the least.
+    d = Decomposition::choose(16, 16, 4);
+    REQUIRE(d.individual_blocks == 4);
+    REQUIRE(d.sample_shards == 1);
+}
+
+TEST_CASE("Shards cover the samples", "[unit]") {
+    size_t begin, end, expected = 0;
+    for (int shard = 0; shard < 7; shard++) {
+        Decomposition::shard_range(100, shard, 7, begin, end);
+        REQUIRE(begin == expected);
+        REQUIRE(end - begin >= 14);
+        expected = end;
+    }
+    REQUIRE(expected == 100);
+}
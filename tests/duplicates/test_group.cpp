@@ -0,0 +1,51 @@
+#include <vector>
+#include <string>
+#include "../../gp/serialization.h"
+#include "../../gp/duplicates.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::vector; using std::string;
+
+/**
+ * Encode rpn strings and return views of the records.
+ * @param  rpns   vector<string>
+ * @param  buffer vector<uint8_t>, holds the records.
+ * @return        vector<GenomeView>
+ */
+vector<GenomeView> encode(const vector<string> & rpns, vector<uint8_t> & buffer) {
+    GenomeWriter writer(buffer);
+    for (const string & rpn : rpns) {
+        writer.write_rpn(rpn);
+    }
+
+    vector<GenomeView> genomes(rpns.size());
+    GenomeReader reader(buffer.data(), buffer.size());
+    for (size_t i = 0; i < genomes.size(); i++) {
+        reader.next(genomes[i]);
+    }
+    return genomes;
+}
+
+TEST_CASE("Identical genomes share a group", "[unit]") {
+    vector<uint8_t> buffer;
+    vector<GenomeView> genomes = encode({"x 1 +", "x x *", "x 1 +", "x 2 +",
+        "x x *", "x 1 +"}, buffer);
+
+    vector<size_t> unique;
+    vector<size_t> groups = Duplicates::group(genomes, unique);
+
+    REQUIRE(unique == vector<size_t>{0, 1, 3});
+    REQUIRE(groups == vector<size_t>{0, 1, 0, 2, 1, 0});
+}
+
+TEST_CASE("Distinct genomes are all unique", "[unit]") {
+    vector<uint8_t> buffer;
+    vector<GenomeView> genomes = encode({"x", "1", "x 1 -", "1 x -"}, buffer);
+
+    vector<size_t> unique;
+    vector<size_t> groups = Duplicates::group(genomes, unique);
+
+    REQUIRE(unique.size() == 4);
+    REQUIRE(groups == vector<size_t>{0, 1, 2, 3});
+    REQUIRE(Duplicates::hash(genomes[2]) != Duplicates::hash(genomes[3]));
+}
@@ -61,3 +61,35 @@ TEST_CASE("Test robustness, crossover a bunch", "[unit]") {
         );
     }
 }
+
+TEST_CASE("Size fair crossover bounds the inserted subtree", "[unit]") {
+    mt19937 engine(0);
+
+    // A single terminal of a can only take a subtree of at most 3 nodes.
+    indv_ptr indv_a = make_shared<Individual>("x 2 +");
+    indv_ptr indv_b = Evolution::full(8, engine);
+
+    for (int i = 0; i < 1000; i++) {
+        indv_ptr child = Evolution::crossover(indv_a, indv_b, engine,
+            Evolution::SIZE_FAIR);
+        REQUIRE(child->get_tree()->num_nodes() <= 5);
+    }
+}
+
+TEST_CASE("Depth limited crossover rejects deep children", "[unit]") {
+    mt19937 engine(1);
+    const int max_depth = Evolution::MAX_DEPTH;
+
+    indv_ptr indv_a = Evolution::full(max_depth, engine);
+    indv_ptr indv_b = Evolution::full(4, engine);
+
+    for (int i = 0; i < 100; i++) {
+        indv_ptr child = Evolution::crossover(indv_a, indv_b, engine,
+            Evolution::DEPTH_LIMIT);
+        REQUIRE(get_depth(child->get_tree()->get_root()) <= max_depth);
+    }
+
+    // Grow and full are capped.
+    REQUIRE(get_depth(Evolution::full(max_depth + 3, engine)
+        ->get_tree()->get_root()) == max_depth);
+}
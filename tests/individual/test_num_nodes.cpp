@@ -35,3 +35,13 @@ TEST_CASE("Full with incremental depths.", "[unit]") {
         }
     }
 }
+
+
+TEST_CASE("Depth and subtree sizes.", "[unit]") {
+    RPNTree tree(make_test_tree());
+    REQUIRE(tree.depth() == 4);
+
+    // Post order: 2, 4, 5, 3, 1, 7, 8, 6, root.
+    std::vector<int> expected = {1, 1, 1, 3, 5, 1, 1, 3, 9};
+    REQUIRE(tree.subtree_sizes() == expected);
+}
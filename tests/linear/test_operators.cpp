@@ -0,0 +1,67 @@
+#include <random>
+#include "../../gp/linear.h"
+#include "../../gp/linear_evolution.h"
+#include "../../gp/linear_population.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::mt19937;
+
+/**
+ * Every register index must be in range for the program to run.
+ */
+void require_valid(const LinearProgram & program) {
+    REQUIRE(program.length() >= 1);
+    REQUIRE(program.length() <= LinearProgram::MAX_LENGTH);
+
+    for (const Instruction & instr : program.get_instructions()) {
+        REQUIRE(instr.op < 4);
+        REQUIRE(instr.dst < LinearProgram::NUM_REGISTERS);
+        REQUIRE(instr.src_a < LinearProgram::NUM_REGISTERS);
+        REQUIRE(instr.src_b <= LinearProgram::CONSTANT);
+    }
+}
+
+TEST_CASE("Linear crossover robustness", "[unit]") {
+    mt19937 engine(0);
+    linear_indv_ptr parent_a = LinearEvolution::random_program(10, engine);
+    linear_indv_ptr parent_b = LinearEvolution::random_program(3, engine);
+
+    for (int i = 0; i < 1000; i++) {
+        linear_indv_ptr child = LinearEvolution::crossover(parent_a, parent_b, engine);
+        require_valid(child->get_program());
+
+        // Parents are untouched.
+        REQUIRE(parent_a->get_program().length() == 10);
+        REQUIRE(parent_b->get_program().length() == 3);
+    }
+}
+
+TEST_CASE("Linear mutation robustness", "[unit]") {
+    mt19937 engine(0);
+    linear_indv_ptr indv = LinearEvolution::random_program(1, engine);
+
+    for (int i = 0; i < 10000; i++) {
+        REQUIRE(LinearEvolution::mutation(indv, engine) == indv);
+        require_valid(indv->get_program());
+    }
+}
+
+TEST_CASE("Linear population initialize", "[unit]") {
+    mt19937 engine(0);
+    LinearPopulation pop(50);
+    pop.initialize(engine, 4, 8);
+
+    REQUIRE(pop.get_length() == 50);
+    for (size_t i = 0; i < pop.get_length(); i++) {
+        REQUIRE(pop[i]->get_program().length() >= 4);
+        REQUIRE(pop[i]->get_program().length() <= 8);
+        pop[i]->set_fitness(i);
+    }
+
+    pop.update(engine, 0.75, 0.5);
+    REQUIRE(pop.get_length() == 50);
+    REQUIRE(pop[0]->get_fitness() == 0); // Elitism.
+    for (size_t i = 0; i < pop.get_length(); i++) {
+        require_valid(pop[i]->get_program());
+    }
+}
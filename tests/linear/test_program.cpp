@@ -0,0 +1,87 @@
+#include <vector>
+#include <string>
+#include "../../gp/linear.h"
+#include "../../gp/evaluation.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::vector; using std::string;
+
+/**
+ * Make an instruction for testing.
+ */
+Instruction make_instruction(uint8_t op, uint8_t dst, uint8_t src_a,
+                             uint8_t src_b, float constant = 0) {
+    Instruction instr;
+    instr.op = op;
+    instr.dst = dst;
+    instr.src_a = src_a;
+    instr.src_b = src_b;
+    instr.constant = constant;
+    return instr;
+}
+
+TEST_CASE("Linear program evaluation", "[unit]") {
+    // r1 = x * x; r2 = x + 1 (intron); r0 = r1 - 3
+    vector<Instruction> instructions = {
+        make_instruction(2, 1, 0, 2),
+        make_instruction(0, 2, 0, LinearProgram::CONSTANT, 1),
+        make_instruction(1, 0, 1, LinearProgram::CONSTANT, 3)
+    };
+    LinearProgram program(instructions);
+
+    REQUIRE(program.evaluate(2) == 1);
+    REQUIRE(program.evaluate(-1) == -2);
+
+    vector<float> samples = {2, -1, 0.5};
+    vector<float> out;
+    program.evaluate(samples, out);
+
+    REQUIRE(out.size() == samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        REQUIRE(out[i] == program.evaluate(samples[i]));
+    }
+}
+
+TEST_CASE("Linear program protected division", "[unit]") {
+    // r0 = x / 0
+    LinearProgram program({make_instruction(3, 0, 0, LinearProgram::CONSTANT, 0)});
+    REQUIRE(program.evaluate(5) == 1);
+}
+
+TEST_CASE("Linear program intron detection", "[unit]") {
+    vector<Instruction> instructions = {
+        make_instruction(2, 1, 0, 2),                            // Effective.
+        make_instruction(0, 2, 0, LinearProgram::CONSTANT, 1),   // Intron, r2 never read.
+        make_instruction(0, 3, 3, 3),                            // Intron.
+        make_instruction(1, 0, 1, LinearProgram::CONSTANT, 3),   // Effective.
+        make_instruction(0, 1, 1, 1)                             // Intron, r1 overwritten after use.
+    };
+    LinearProgram program(instructions);
+
+    vector<bool> expected = {true, false, false, true, false};
+    REQUIRE(program.effective_instructions() == expected);
+    REQUIRE(program.num_effective() == 2);
+}
+
+TEST_CASE("Linear program string round trip", "[unit]") {
+    vector<Instruction> instructions = {
+        make_instruction(3, 1, 2, LinearProgram::CONSTANT, -7.123456789),
+        make_instruction(1, 0, 1, 3)
+    };
+    LinearProgram program(instructions);
+    LinearProgram parsed(program.to_string());
+
+    REQUIRE(parsed.get_instructions() == program.get_instructions());
+}
+
+TEST_CASE("Linear program rmse", "[unit]") {
+    // r0 = x + 1
+    LinearProgram program({make_instruction(0, 0, 0, LinearProgram::CONSTANT, 1)});
+
+    vector<float> samples = {1, 2, 3};
+    vector<float> ground_truth = {2, 3, 4};
+    REQUIRE(Evaluation::assign_rmse(program, samples, ground_truth) == 0);
+
+    ground_truth = {3, 4, 5};
+    REQUIRE(Evaluation::assign_rmse(program, samples, ground_truth) == 1);
+}
@@ -0,0 +1,157 @@
+#include <random>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <fstream>
+#include <cstdio>
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../../gp/spsc_queue.h"
+#include "../../gp/logger.h"
+#include "../../gp/population.h"
+#include "../../gp/individual.h"
+#include "../../gp/engine.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::mt19937; using std::vector; using std::string;
+
+/**
+ * Lines of a text file.
+ */
+vector<string> read_lines(const string & file_name) {
+    vector<string> lines;
+    std::ifstream file(file_name);
+    string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+TEST_CASE("Queue hands values to another thread in order", "[unit]") {
+    SpscQueue<int> queue;
+    int count = 100000;
+
+    std::thread producer([&queue, count]() {
+        for (int i = 0; i < count; i++) {
+            queue.push(int(i));
+        }
+    });
+
+    int expected = 0, value;
+    while (expected < count) {
+        if (queue.pop(value)) {
+            REQUIRE(value == expected);
+            expected++;
+        }
+    }
+    producer.join();
+    REQUIRE(! queue.pop(value));
+}
+
+TEST_CASE("Logger writes every generation by the time it is destroyed", "[unit]") {
+    string dir = "test_logger_output";
+    mt19937 engine(1);
+    auto population = std::make_shared<Population>(20);
+    population->initialize(engine, 2, 4);
+    for (size_t i = 0; i < population->get_length(); i++) {
+        (*population)[i]->set_fitness(i + EngineTraits<Population>::size((*population)[i]));
+    }
+
+    {
+        Logger logger(dir, 7);
+        logger.add_column("extra");
+        logger.initialize();
+        for (int generation = 0; generation < 50; generation++) {
+            logger.log(population, generation, 0.5, {generation * 2.0});
+        }
+    }
+
+    vector<string> log = read_lines(dir + "/log7.csv");
+    vector<string> archive = read_lines(dir + "/archive7.csv");
+    REQUIRE(log.size() == 51);
+    REQUIRE(archive.size() == 51);
+    REQUIRE(log[0].substr(log[0].size() - 6) == ",extra");
+    for (int generation = 0; generation < 50; generation++) {
+        REQUIRE(log[generation + 1].substr(0, log[generation + 1].find(','))
+            == std::to_string(generation));
+        REQUIRE(log[generation + 1].substr(log[generation + 1].rfind(',') + 1)
+            == std::to_string(generation * 2));
+    }
+
+    std::remove((dir + "/log7.csv").c_str());
+    std::remove((dir + "/archive7.csv").c_str());
+    rmdir(dir.c_str());
+}
+
+/**
+ * Handler currently installed for a signal.
+ */
+void (*current_handler(int signal))(int) {
+    struct sigaction action;
+    sigaction(signal, nullptr, &action);
+    return action.sa_handler;
+}
+
+TEST_CASE("Handlers are put back once the last logger is destroyed", "[unit]") {
+    string dir = "test_logger_handlers";
+    REQUIRE(current_handler(SIGHUP) == SIG_DFL);
+
+    {
+        Logger first(dir, 1);
+        first.initialize();
+        REQUIRE(current_handler(SIGHUP) != SIG_DFL);
+        {
+            Logger second(dir, 2);
+            second.initialize();
+        }
+        REQUIRE(current_handler(SIGHUP) != SIG_DFL);
+    }
+    REQUIRE(current_handler(SIGHUP) == SIG_DFL);
+
+    for (string name : {"log1.csv", "archive1.csv", "log2.csv", "archive2.csv"}) {
+        std::remove((dir + "/" + name).c_str());
+    }
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("A signal ends the process once every logger has flushed", "[unit]") {
+    string dir = "test_logger_signal";
+    mt19937 engine(1);
+    auto population = std::make_shared<Population>(20);
+    population->initialize(engine, 2, 4);
+    for (size_t i = 0; i < population->get_length(); i++) {
+        (*population)[i]->set_fitness(i + EngineTraits<Population>::size((*population)[i]));
+    }
+
+    // Two islands log in a child, which is then sent SIGHUP (Catch handles
+    // SIGTERM itself, so the loggers would leave it alone).
+    pid_t child = fork();
+    if (child == 0) {
+        Logger first(dir, 1), second(dir, 2);
+        first.initialize();
+        second.initialize();
+        for (int generation = 0; generation < 50; generation++) {
+            first.log(population, generation, 0.5);
+            second.log(population, generation, 0.5);
+        }
+        std::raise(SIGHUP);
+        while (true) {
+            pause();
+        }
+    }
+
+    int status;
+    waitpid(child, &status, 0);
+    REQUIRE(WIFSIGNALED(status));
+    REQUIRE(WTERMSIG(status) == SIGHUP);
+    REQUIRE(read_lines(dir + "/log1.csv").size() == 51);
+    REQUIRE(read_lines(dir + "/log2.csv").size() == 51);
+
+    for (string name : {"log1.csv", "archive1.csv", "log2.csv", "archive2.csv"}) {
+        std::remove((dir + "/" + name).c_str());
+    }
+    rmdir(dir.c_str());
+}
@@ -0,0 +1,59 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "../../gp/migration.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::vector;
+
+TEST_CASE("Ring sends to the next island", "[unit]") {
+    REQUIRE(Migration::destinations(Migration::RING, 0, 4, 1, 5) == vector<int>{1});
+    REQUIRE(Migration::destinations(Migration::RING, 3, 4, 1, 5) == vector<int>{0});
+    REQUIRE(Migration::destinations(Migration::RING, 0, 1, 1, 5).empty());
+    REQUIRE(Migration::destinations(Migration::NONE, 0, 4, 1, 5).empty());
+}
+
+TEST_CASE("Torus sends east and south", "[unit]") {
+    // 6 islands make a 2 by 3 grid.
+    REQUIRE(Migration::destinations(Migration::TORUS, 0, 6, 1, 5) == vector<int>{1, 3});
+    REQUIRE(Migration::destinations(Migration::TORUS, 5, 6, 1, 5) == vector<int>{3, 2});
+
+    // A prime number of islands is a single row, only east is left.
+    REQUIRE(Migration::destinations(Migration::TORUS, 4, 5, 1, 5) == vector<int>{0});
+
+    // Every island receives from as many islands as it sends to.
+    for (int size : {2, 4, 9, 12}) {
+        vector<int> in(size, 0), out(size, 0);
+        for (int rank = 0; rank < size; rank++) {
+            for (int d : Migration::destinations(Migration::TORUS, rank, size, 1, 5)) {
+                REQUIRE(d != rank);
+                out[rank]++;
+                in[d]++;
+            }
+        }
+        REQUIRE(in == out);
+    }
+}
+
+TEST_CASE("Random destinations are other islands and reproducible", "[unit]") {
+    vector<int> counts(4, 0);
+    for (uint32_t generation = 0; generation < 400; generation++) {
+        vector<int> d = Migration::destinations(Migration::RANDOM, 2, 4, 7, generation);
+        REQUIRE(d.size() == 1);
+        REQUIRE(d[0] != 2);
+        REQUIRE(d == Migration::destinations(Migration::RANDOM, 2, 4, 7, generation));
+        counts[d[0]]++;
+    }
+
+    REQUIRE(counts[0] > 100);
+    REQUIRE(counts[1] > 100);
+    REQUIRE(counts[3] > 100);
+}
+
+TEST_CASE("Best and worst individuals", "[unit]") {
+    vector<float> fitnesses = {3, NAN, 1, 4, 1, 2};
+
+    REQUIRE(Migration::best(fitnesses, 3) == vector<size_t>{2, 4, 5});
+    REQUIRE(Migration::worst(fitnesses, 2) == vector<size_t>{1, 3});
+    REQUIRE(Migration::best(fitnesses, 10).size() == 6);
+}
@@ -0,0 +1,111 @@
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <omp.h>
+#include "../../gp/random.h"
+#include "../../gp/pareto.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::vector;
+
+/**
+ * Fronts by the definition: peel off the non-dominated individuals,
+ * O(n^2) per front.
+ */
+vector<int> brute_force_fronts(const vector<float> & first,
+        const vector<float> & second) {
+    size_t n = first.size();
+    vector<int> fronts(n, -1);
+    size_t assigned = 0;
+
+    for (int front = 0; assigned < n; front++) {
+        vector<size_t> members;
+        for (size_t i = 0; i < n; i++) {
+            if (fronts[i] != -1) {
+                continue;
+            }
+
+            bool dominated = false;
+            for (size_t j = 0; j < n && ! dominated; j++) {
+                dominated = fronts[j] == -1
+                    && Pareto::dominates(first[j], second[j], first[i], second[i]);
+            }
+            if (! dominated) {
+                members.push_back(i);
+            }
+        }
+
+        for (size_t i : members) {
+            fronts[i] = front;
+        }
+        assigned += members.size();
+    }
+
+    return fronts;
+}
+
+TEST_CASE("Dominance", "[unit]") {
+    REQUIRE(Pareto::dominates(1, 1, 2, 2));
+    REQUIRE(Pareto::dominates(1, 2, 2, 2));
+    REQUIRE(! Pareto::dominates(1, 1, 1, 1));
+    REQUIRE(! Pareto::dominates(1, 3, 2, 2));
+}
+
+TEST_CASE("Non-dominated sort matches the definition", "[unit]") {
+    // Small integer objectives so there are plenty of ties.
+    for (uint32_t trial = 0; trial < 20; trial++) {
+        Philox engine(trial, 0, 0, Philox::SAMPLE);
+        size_t n = 1 + engine.below(300);
+
+        vector<float> first(n), second(n);
+        for (size_t i = 0; i < n; i++) {
+            first[i] = engine.below(20);
+            second[i] = engine.below(20);
+        }
+
+        vector<float> crowding;
+        REQUIRE(Pareto::sort(first, second, crowding) == brute_force_fronts(first, second));
+        REQUIRE(crowding.size() == n);
+    }
+}
+
+TEST_CASE("Crowding distance", "[unit]") {
+    // One front of four evenly spaced points.
+    vector<float> first = {0, 1, 2, 3};
+    vector<float> second = {3, 2, 1, 0};
+
+    vector<float> crowding;
+    vector<int> fronts = Pareto::sort(first, second, crowding);
+
+    REQUIRE(fronts == vector<int>{0, 0, 0, 0});
+    REQUIRE(std::isinf(crowding[0]));
+    REQUIRE(std::isinf(crowding[3]));
+    REQUIRE(crowding[1] == Approx(4.0 / 3));
+    REQUIRE(crowding[2] == Approx(4.0 / 3));
+}
+
+TEST_CASE("Front is ordered and NaN is worst", "[unit]") {
+    vector<float> first = {NAN, 3, 1, 2, 1};
+    vector<float> second = {1, 1, 4, 2, 5};
+
+    // NaN counts as infinite error, so (3, 1) dominates it.
+    REQUIRE(Pareto::front(first, second) == vector<size_t>{2, 3, 1});
+}
+
+TEST_CASE("Non-dominated sort throughput", "[.benchmark]") {
+    // Hidden, run with: ./a.out "[benchmark]"
+    for (size_t n : {10000, 1000000}) {
+        vector<float> first(n), second(n);
+        Philox engine(1, 0, 0, Philox::SAMPLE);
+        for (size_t i = 0; i < n; i++) {
+            first[i] = engine.uniform();
+            second[i] = engine.below(100); // Sizes are small integers.
+        }
+
+        vector<float> crowding;
+        double start = omp_get_wtime();
+        vector<int> fronts = Pareto::sort(first, second, crowding);
+        std::cout << "pareto sort, n " << n << ": " << omp_get_wtime() - start
+            << "s" << std::endl;
+    }
+}
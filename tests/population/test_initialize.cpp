@@ -1,4 +1,7 @@
 #include <random>
+#include <string>
+#include <vector>
+#include "omp.h"
 #include "../evolution/utils.h"
 #include "../../gp/population.h"
 #include "../../gp/individual.h"
@@ -24,3 +27,51 @@ TEST_CASE("Test initialize", "[unit]") {
         REQUIRE_NOTHROW(Evaluation::evaluate_rpn(pop[i]->get_tree()->get_rpn_string(), 0));
     }
 }
+
+/**
+ * Rpn strings of a population built with some number of threads.
+ * @param  threads int
+ * @return         vector<string>
+ */
+std::vector<std::string> initialize_with_threads(int threads) {
+    mt19937 engine(3);
+    Population pop(1001);
+
+    omp_set_num_threads(threads);
+    pop.initialize(engine, 2, 6);
+
+    std::vector<std::string> rpns;
+    for (size_t i = 0; i < pop.get_length(); i++) {
+        rpns.push_back(pop[i]->get_tree()->get_rpn_string());
+    }
+    return rpns;
+}
+
+TEST_CASE("Initialize is identical for any thread count", "[unit]") {
+    std::vector<std::string> one_thread = initialize_with_threads(1);
+    REQUIRE(one_thread.size() == 1001);
+    REQUIRE(initialize_with_threads(3) == one_thread);
+    REQUIRE(initialize_with_threads(8) == one_thread);
+}
+
+TEST_CASE("Shards match the full population", "[unit]") {
+    size_t len = 103;
+    size_t shards = 4;
+    Population full(len);
+    full.initialize_shard(42, 2, 6, 0, 1);
+
+    for (size_t first = 0; first < shards; first++) {
+        Population shard(len);
+        shard.initialize_shard(42, 2, 6, first, shards);
+        REQUIRE(shard.get_length() == (len - first + shards - 1) / shards);
+
+        for (size_t k = 0; k < shard.get_length(); k++) {
+            REQUIRE(shard[k]->get_tree()->get_rpn_string()
+                == full[first + k * shards]->get_tree()->get_rpn_string());
+        }
+    }
+
+    // The ramp still covers every depth with grow and full.
+    REQUIRE(get_depth(full[0]->get_tree()->get_root()) <= 2);
+    REQUIRE(get_depth(full[len - 1]->get_tree()->get_root()) == 6);
+}
@@ -0,0 +1,113 @@
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "omp.h"
+#include "../../gp/population.h"
+#include "../../gp/individual.h"
+#include "../../gp/evolution.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::mt19937; using std::vector; using std::string;
+
+/**
+ * Initialize, assign fitnesses and breed a few generations.
+ * @param  threads int, size of the thread team.
+ * @return         vector<string>, rpn strings of the final population.
+ */
+vector<string> breed_with_threads(int threads) {
+    mt19937 engine(7);
+    Population pop(101);
+    pop.initialize(engine, 2, 6);
+
+    omp_set_num_threads(threads);
+    for (int generation = 0; generation < 5; generation++) {
+        for (size_t i = 0; i < pop.get_length(); i++) {
+            pop[i]->set_fitness(pop[i]->get_tree()->num_nodes() + i % 7);
+        }
+
+        #pragma omp parallel
+        #pragma omp single
+        pop.update(engine, 0.75, 0.2);
+    }
+
+    vector<string> rpns;
+    for (size_t i = 0; i < pop.get_length(); i++) {
+        rpns.push_back(pop[i]->get_tree()->get_rpn_string());
+    }
+    return rpns;
+}
+
+TEST_CASE("Update is identical for any thread count", "[unit]") {
+    vector<string> one_thread = breed_with_threads(1);
+    REQUIRE(one_thread.size() == 101);
+    REQUIRE(breed_with_threads(2) == one_thread);
+    REQUIRE(breed_with_threads(4) == one_thread);
+}
+
+TEST_CASE("Update keeps the best individual", "[unit]") {
+    mt19937 engine(0);
+    Population pop(20);
+    pop.initialize(engine, 2, 4);
+
+    for (size_t i = 0; i < pop.get_length(); i++) {
+        pop[i]->set_fitness(100 + i);
+    }
+    pop[13]->set_fitness(1);
+    indv_ptr best = pop[13];
+
+    pop.update(engine, 0.75, 0.2);
+    REQUIRE(pop.get_length() == 20);
+    REQUIRE(pop[0] == best);
+}
+
+TEST_CASE("Replace takes the place of a tournament loser", "[unit]") {
+    mt19937 engine(3);
+    Population pop(10);
+    pop.initialize(engine, 2, 4);
+
+    for (size_t i = 0; i < pop.get_length(); i++) {
+        pop[i]->set_fitness(i);
+    }
+    indv_ptr best = pop[0];
+
+    for (uint32_t i = 0; i < 50; i++) {
+        Philox child_engine(11, 0, i, Philox::BREED);
+        indv_ptr child = pop.breed_steady_state(child_engine, 0.75, 0.2);
+        child->set_fitness(100);
+
+        Philox replace_engine(11, 0, i, Philox::REPLACE);
+        pop.replace(child, replace_engine);
+        REQUIRE(pop.get_length() == 10);
+    }
+
+    // The best only loses a tournament made up entirely of itself.
+    bool kept = false;
+    for (size_t i = 0; i < pop.get_length(); i++) {
+        kept = kept || pop[i] == best;
+    }
+    REQUIRE(kept);
+}
+
+TEST_CASE("Dynamic limit keeps oversized individuals from breeding", "[unit]") {
+    mt19937 engine(5);
+    Population pop(50, Evolution::DYNAMIC_LIMIT);
+    pop.initialize(engine, 2, 4);
+
+    int limit = 0;
+    for (size_t i = 0; i < pop.get_length(); i++) {
+        pop[i]->set_fitness(1000 - i);
+        limit = std::max(limit, pop[i]->get_tree()->num_nodes());
+    }
+    pop[49]->set_fitness(1); // Also the best, so it stays.
+
+    for (int generation = 0; generation < 10; generation++) {
+        pop.update(engine, 1.0, 0.2);
+
+        // Only children of parents within the limit, so at most 2x its size.
+        for (size_t i = 0; i < pop.get_length(); i++) {
+            REQUIRE(pop[i]->get_tree()->num_nodes() < 2 * limit);
+            pop[i]->set_fitness(pop[i]->get_tree()->num_nodes());
+        }
+    }
+}
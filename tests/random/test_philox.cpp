@@ -0,0 +1,90 @@
+#include <vector>
+#include <cstdint>
+#include "../../gp/random.h"
+#include "../../gp/evolution.h"
+#include "../../gp/individual.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::vector;
+
+TEST_CASE("Philox matches the Random123 known answers", "[Philox]") {
+    Philox zero;
+    REQUIRE(zero() == 0x6627e8d5);
+    REQUIRE(zero() == 0xe169c58d);
+    REQUIRE(zero() == 0xbc57ac4c);
+    REQUIRE(zero() == 0x9b00dbd8);
+
+    // Counter {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+    // key {0xa4093822, 0x299f31d0}. The block counter is reached by discard.
+    Philox pi(0x299f31d0a4093822ull, 0x85a308d3, 0x13198a2e, 0x03707344);
+    pi.discard(4ull * 0x243f6a88);
+    REQUIRE(pi() == 0xd16cfe09);
+    REQUIRE(pi() == 0x94fdcceb);
+    REQUIRE(pi() == 0x5001e420);
+    REQUIRE(pi() == 0x24126ea1);
+}
+
+TEST_CASE("Philox discard skips the same outputs as drawing them", "[Philox]") {
+    for (unsigned long long skip : {1ull, 3ull, 4ull, 5ull, 17ull}) {
+        Philox drawn(42, 1, 2, Philox::BREED), skipped(42, 1, 2, Philox::BREED);
+        drawn();
+        skipped();
+
+        for (unsigned long long i = 0; i < skip; i++) {
+            drawn();
+        }
+        skipped.discard(skip);
+
+        REQUIRE(drawn() == skipped());
+    }
+}
+
+TEST_CASE("Philox streams are reproducible and distinct", "[Philox]") {
+    Philox a(7, 3, 11, Philox::BREED);
+    Philox b = Philox(7).split(3, 11, Philox::BREED);
+    Philox other_individual(7, 3, 12, Philox::BREED);
+    Philox other_operation(7, 3, 11, Philox::INITIALIZE);
+
+    vector<uint32_t> first, second, third, fourth;
+    for (int i = 0; i < 8; i++) {
+        first.push_back(a());
+        second.push_back(b());
+        third.push_back(other_individual());
+        fourth.push_back(other_operation());
+    }
+
+    REQUIRE(first == second);
+    REQUIRE(first != third);
+    REQUIRE(first != fourth);
+}
+
+TEST_CASE("Philox draws stay in range", "[Philox]") {
+    Philox engine(1234);
+
+    for (int i = 0; i < 10000; i++) {
+        float u = engine.uniform();
+        REQUIRE(u >= 0.0f);
+        REQUIRE(u < 1.0f);
+
+        uint32_t n = 1 + i % 9;
+        REQUIRE(engine.below(n) < n);
+
+        double erc = Evolution::EPHEMERAL_RANDOM_CONSTANTS(engine);
+        REQUIRE(erc >= -10);
+        REQUIRE(erc < 10);
+    }
+}
+
+TEST_CASE("Operators give the same trees from the same stream", "[Philox]") {
+    Philox a(99, 0, 5, Philox::INITIALIZE), b(99, 0, 5, Philox::INITIALIZE);
+
+    indv_ptr grown_a = Evolution::grow(5, a);
+    indv_ptr grown_b = Evolution::grow(5, b);
+    REQUIRE(grown_a->get_tree()->get_rpn_string()
+        == grown_b->get_tree()->get_rpn_string());
+
+    indv_ptr mutant_a = Evolution::mutation(Evolution::full(4, a), a);
+    indv_ptr mutant_b = Evolution::mutation(Evolution::full(4, b), b);
+    REQUIRE(mutant_a->get_tree()->get_rpn_string()
+        == mutant_b->get_tree()->get_rpn_string());
+}
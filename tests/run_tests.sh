@@ -1,9 +1,18 @@
 #!/bin/bash
 
+# The thread transport stands in for MPI, so its tests are built from the
+# sources with NO_MPI rather than linked with the MPI objects.
+THREAD_MPI_SOURCES="../gp/thread_mpi.cpp ../gp/exchange.cpp ../gp/shared_window.cpp
+    ../gp/serialization.cpp ../gp/evaluation.cpp ../gp/individual.cpp ../gp/linear.cpp"
+
 function compile_and_run_tests_in_dir {
     for test in $1/*.cpp;
     do
-        mpic++ --std=c++11 catch_main.o ../gp/*.o $test -fopenmp
+        if [ "$(basename $1)" == "thread_mpi" ]; then
+            g++ --std=c++11 -DNO_MPI -pthread catch_main.o $THREAD_MPI_SOURCES $test -fopenmp
+        else
+            mpic++ --std=c++11 catch_main.o ../gp/*.o $test -fopenmp
+        fi
         ./a.out
     done
 }
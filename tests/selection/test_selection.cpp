@@ -0,0 +1,340 @@
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+#include "../../gp/random.h"
+#include "../../gp/selection.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::vector;
+
+/**
+ * Fitness i for individual i, so index 0 is the best.
+ */
+vector<float> ascending(size_t n) {
+    vector<float> fitnesses(n);
+    for (size_t i = 0; i < n; i++) {
+        fitnesses[i] = i;
+    }
+    return fitnesses;
+}
+
+TEST_CASE("Tournament of the whole population picks the best", "[unit]") {
+    vector<float> fitnesses = {5, 2, 7};
+    Selection selection(Selection::TOURNAMENT, 3);
+    selection.prepare(fitnesses);
+
+    Philox engine(1, 0, 0, Philox::BREED);
+    for (int i = 0; i < 100; i++) {
+        REQUIRE(selection.select(engine) == 1);
+    }
+}
+
+TEST_CASE("Truncation only picks the best fraction", "[unit]") {
+    vector<float> fitnesses = ascending(100);
+    Selection selection(Selection::TRUNCATION, 3, 0.25);
+    selection.prepare(fitnesses);
+
+    vector<int> counts(100, 0);
+    Philox engine(2, 0, 0, Philox::BREED);
+    for (int i = 0; i < 10000; i++) {
+        counts[selection.select(engine)]++;
+    }
+
+    for (size_t i = 0; i < 100; i++) {
+        if (i < 25) {
+            REQUIRE(counts[i] > 0);
+        }
+        else {
+            REQUIRE(counts[i] == 0);
+        }
+    }
+}
+
+TEST_CASE("Rank selection follows the linear ranking", "[unit]") {
+    // With pressure 2 the worst individual is never picked and the best is
+    // picked about 2 / n of the time.
+    size_t n = 10;
+    vector<float> fitnesses = ascending(n);
+    std::reverse(fitnesses.begin(), fitnesses.end()); // Best is now last.
+
+    Selection selection(Selection::RANK, 3, 0.5, 2.0);
+    selection.prepare(fitnesses);
+
+    vector<int> counts(n, 0);
+    int draws = 100000;
+    Philox engine(3, 0, 0, Philox::BREED);
+    for (int i = 0; i < draws; i++) {
+        counts[selection.select(engine)]++;
+    }
+
+    REQUIRE(counts[0] == 0);
+    REQUIRE(counts[n - 1] == Approx(draws * 2.0 / n).epsilon(0.05));
+    REQUIRE(counts[n - 1] > counts[n / 2]);
+}
+
+TEST_CASE("Selection pairs are distinct", "[unit]") {
+    vector<float> fitnesses = ascending(50);
+
+    for (int method = Selection::TOURNAMENT; method <= Selection::RANK; method++) {
+        Selection selection(method);
+        selection.prepare(fitnesses);
+
+        Philox engine(4, 0, method, Philox::BREED);
+        for (int i = 0; i < 1000; i++) {
+            size_t a, b;
+            selection.select_pair(engine, a, b);
+            REQUIRE(a < 50);
+            REQUIRE(b < 50);
+            REQUIRE(a != b);
+        }
+    }
+}
+
+TEST_CASE("Batched pairs match drawing each child's pair", "[unit]") {
+    vector<float> fitnesses = ascending(50);
+
+    for (int method = Selection::TOURNAMENT; method <= Selection::RANK; method++) {
+        Selection selection(method);
+        selection.prepare(fitnesses);
+
+        vector<Philox> engines;
+        for (uint32_t i = 0; i < 16; i++) {
+            engines.emplace_back(4, 1, i, Philox::BREED);
+        }
+        vector<size_t> parents(32);
+        selection.select_pairs(engines.data(), parents.data(), 16);
+
+        for (uint32_t i = 0; i < 16; i++) {
+            Philox engine(4, 1, i, Philox::BREED);
+            size_t a, b;
+            selection.select_pair(engine, a, b);
+            REQUIRE(parents[2 * i] == a);
+            REQUIRE(parents[2 * i + 1] == b);
+            // Variation continues each stream where selection left it.
+            REQUIRE(engines[i]() == engine());
+        }
+    }
+}
+
+TEST_CASE("Selection pair terminates with one candidate", "[unit]") {
+    vector<float> fitnesses = {1};
+    Selection selection(Selection::TOURNAMENT);
+    selection.prepare(fitnesses);
+
+    size_t a, b;
+    Philox engine(5, 0, 0, Philox::BREED);
+    selection.select_pair(engine, a, b);
+    REQUIRE(a == 0);
+    REQUIRE(b == 0);
+}
+
+/**
+ * Case major errors from one row per individual.
+ */
+vector<float> case_major(const vector<vector<float>> & rows) {
+    size_t n = rows.size(), m = rows[0].size();
+    vector<float> errors(n * m);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t c = 0; c < m; c++) {
+            errors[c * n + i] = rows[i][c];
+        }
+    }
+    return errors;
+}
+
+TEST_CASE("Lexicase picks specialists over a generalist", "[unit]") {
+    // 0 and 1 are each perfect on one case, 2 is better on average but never
+    // the best on any case.
+    vector<float> errors = case_major({{0, 10}, {10, 0}, {6, 6}, {10, 10}, {10, 10}});
+    vector<float> fitnesses = {10, 10, 6, 14, 14};
+
+    Selection selection(Selection::LEXICASE);
+    selection.set_case_errors(errors, 2);
+    selection.prepare(fitnesses);
+    REQUIRE(selection.get_num_cases() == 2);
+
+    vector<int> counts(5, 0);
+    Philox engine(7, 0, 0, Philox::BREED);
+    for (int i = 0; i < 1000; i++) {
+        counts[selection.select(engine)]++;
+    }
+
+    REQUIRE(counts[0] > 400);
+    REQUIRE(counts[1] > 400);
+    REQUIRE(counts[0] + counts[1] == 1000);
+}
+
+TEST_CASE("Replaced errors take the individual's place", "[unit]") {
+    // 2 is replaced by an individual perfect on both cases after evaluation.
+    vector<float> errors = case_major({{5, 5}, {6, 6}, {9, 9}});
+    vector<float> fitnesses = {5, 6, 0};
+    float perfect[2] = {0, 0};
+
+    Selection selection(Selection::LEXICASE);
+    selection.set_case_errors(errors, 2);
+    selection.replace_case_errors(2, perfect);
+    selection.prepare(fitnesses);
+
+    Philox engine(11, 0, 0, Philox::BREED);
+    for (int i = 0; i < 100; i++) {
+        REQUIRE(selection.select(engine) == 2);
+    }
+}
+
+TEST_CASE("Lexicase keeps everyone within epsilon", "[unit]") {
+    // Median 1 and median absolute deviation 1, so errors up to 1 tie.
+    vector<float> errors = case_major({{0}, {1}, {1}, {5}, {5}});
+    vector<float> fitnesses = {1, 1, 1, 1, 1};
+
+    Selection selection(Selection::LEXICASE);
+    selection.set_case_errors(errors, 1);
+    selection.prepare(fitnesses);
+
+    vector<int> counts(5, 0);
+    Philox engine(8, 0, 0, Philox::BREED);
+    for (int i = 0; i < 3000; i++) {
+        counts[selection.select(engine)]++;
+    }
+
+    REQUIRE(counts[0] > 800);
+    REQUIRE(counts[1] > 800);
+    REQUIRE(counts[2] > 800);
+    REQUIRE(counts[3] == 0);
+    REQUIRE(counts[4] == 0);
+}
+
+TEST_CASE("Lexicase skips individuals over the size limit", "[unit]") {
+    vector<float> errors = case_major({{0, 0}, {1, 1}, {9, 9}, {9, 9}, {9, 9}});
+    vector<float> fitnesses = {HUGE_VALF, 1, 9, 9, 9};
+
+    Selection selection(Selection::LEXICASE);
+    selection.set_case_errors(errors, 2);
+    selection.prepare(fitnesses);
+
+    Philox engine(9, 0, 0, Philox::BREED);
+    for (int i = 0; i < 100; i++) {
+        REQUIRE(selection.select(engine) == 1);
+    }
+}
+
+TEST_CASE("Lexicase without errors falls back to tournaments", "[unit]") {
+    vector<float> fitnesses = {5, 2, 7};
+    Selection selection(Selection::LEXICASE);
+    selection.prepare(fitnesses);
+    REQUIRE(selection.get_num_cases() == 0);
+
+    Philox engine(10, 0, 0, Philox::BREED);
+    REQUIRE(selection.select(engine) == 1);
+}
+
+TEST_CASE("Pareto keeps the front as elites", "[unit]") {
+    // Front: 0 (small, inaccurate), 1 (middle), 2 (large, accurate).
+    vector<float> errors = {9, 5, 1, 6, 9, 9};
+    vector<float> sizes = {1, 3, 9, 4, 9, 2};
+    vector<float> fitnesses(6);
+    for (size_t i = 0; i < 6; i++) {
+        fitnesses[i] = errors[i] + sizes[i];
+    }
+
+    Selection selection(Selection::PARETO);
+    selection.set_objectives(errors, sizes);
+    selection.prepare(fitnesses);
+
+    // Boundaries first, they have infinite crowding distance.
+    vector<size_t> elites = selection.elites(10);
+    REQUIRE(elites == vector<size_t>{0, 2, 1});
+    REQUIRE(selection.elites(2) == vector<size_t>{0, 2});
+
+    // A tournament of everyone is won by a boundary of the front.
+    Selection everyone(Selection::PARETO, 6);
+    errors = {9, 5, 1, 6, 9, 9};
+    sizes = {1, 3, 9, 4, 9, 2};
+    everyone.set_objectives(errors, sizes);
+    everyone.prepare(fitnesses);
+
+    Philox engine(13, 0, 0, Philox::BREED);
+    size_t winner = everyone.select(engine);
+    REQUIRE((winner == 0 || winner == 2));
+}
+
+TEST_CASE("Other methods have no elites", "[unit]") {
+    vector<float> fitnesses = ascending(10);
+    Selection selection(Selection::TOURNAMENT);
+    selection.prepare(fitnesses);
+    REQUIRE(selection.elites(5).empty());
+}
+
+TEST_CASE("Selection throughput", "[.benchmark]") {
+    // Hidden, run with: ./a.out "[benchmark]"
+    for (size_t n : {1000000, 10000000}) {
+        vector<float> fitnesses = ascending(n);
+        vector<size_t> out(n);
+
+        for (int method = Selection::TOURNAMENT; method <= Selection::RANK; method++) {
+            Selection selection(method);
+
+            double start = omp_get_wtime();
+            selection.prepare(fitnesses);
+            double prepared = omp_get_wtime();
+
+            Philox engine(6, 0, 0, Philox::BREED);
+            for (size_t i = 0; i < n; i++) {
+                out[i] = selection.select(engine);
+            }
+            double single = omp_get_wtime();
+
+            // The parents of n / 2 children in breeding sized batches, each
+            // child with its own stream as in Population::update.
+            const long chunk = 16;
+            #pragma omp parallel for schedule(static)
+            for (long first = 0; first < (long)n / 2; first += chunk) {
+                long count = std::min(chunk, (long)n / 2 - first);
+                Philox engines[chunk];
+                for (long k = 0; k < count; k++) {
+                    engines[k] = Philox(6, 0, first + k, Philox::BREED);
+                }
+                selection.select_pairs(engines, out.data() + 2 * first, count);
+            }
+            double batch = omp_get_wtime();
+
+            std::cout << "method " << method << ", n " << n
+                << ": prepare " << prepared - start
+                << "s, per call " << single - prepared
+                << "s, batch " << batch - single << "s" << std::endl;
+        }
+    }
+}
+
+TEST_CASE("Lexicase generation time", "[.benchmark]") {
+    // One generation's worth of selections over Evaluation::NUM_SAMPLES cases.
+    size_t m = 100;
+
+    for (size_t n : {1000, 10000, 100000}) {
+        vector<float> errors(n * m);
+        Philox noise(11, 0, 0, Philox::SAMPLE);
+        for (float & error : errors) {
+            error = noise.uniform() * 10;
+        }
+        vector<float> fitnesses = ascending(n);
+        vector<size_t> out(n);
+
+        Selection selection(Selection::LEXICASE);
+        double start = omp_get_wtime();
+        selection.set_case_errors(errors, m);
+        selection.prepare(fitnesses);
+        double prepared = omp_get_wtime();
+
+        vector<Philox> engines;
+        for (size_t i = 0; i < n / 2; i++) {
+            engines.emplace_back(12, 0, i, Philox::BREED);
+        }
+        selection.select_pairs(engines.data(), out.data(), n / 2);
+        double done = omp_get_wtime();
+
+        std::cout << "lexicase, n " << n << ", " << m << " cases: prepare "
+            << prepared - start << "s, " << n << " selections "
+            << done - prepared << "s" << std::endl;
+    }
+}
@@ -0,0 +1,178 @@
+#include <cmath>
+#include <random>
+#include <string>
+#include <cstring>
+#include <vector>
+#include "../../gp/evolution.h"
+#include "../../gp/evaluation.h"
+#include "../../gp/individual.h"
+#include "../../gp/linear.h"
+#include "../../gp/linear_evolution.h"
+#include "../../gp/serialization.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::mt19937; using std::vector; using std::string;
+
+TEST_CASE("Tree round trip \"x 4 5 + * x 8 / +\"", "[unit]") {
+    RPNTree tree("x 4 5 + * x 8 / +");
+
+    vector<uint8_t> buffer;
+    GenomeWriter writer(buffer);
+    writer.write(tree);
+
+    // 9 opcodes, 3 constants and the length prefix.
+    REQUIRE(buffer.size() == sizeof(uint32_t) + 9 + 3 * sizeof(float));
+
+    GenomeView genome;
+    GenomeReader reader(buffer.data(), buffer.size());
+    REQUIRE(reader.next(genome));
+    REQUIRE(! reader.next(genome));
+
+    reader.rewind();
+    reader.next(genome);
+    tree_ptr decoded = Serialization::decode_tree(genome.body, genome.length);
+    REQUIRE(decoded->get_rpn_string() == tree.get_rpn_string());
+    REQUIRE(Serialization::num_tokens(genome.body, genome.length) == 9);
+}
+
+TEST_CASE("Tree round trip is exact for random trees", "[unit]") {
+    mt19937 engine(0);
+    vector<float> samples = {-3, -0.5, 0, 0.25, 7};
+    vector<float> ground_truth = {1, 2, 3, 4, 5};
+
+    for (int i = 0; i < 200; i++) {
+        indv_ptr indv = Evolution::grow(6, engine);
+        string rpn = indv->get_tree()->get_rpn_string();
+
+        vector<uint8_t> buffer;
+        GenomeWriter writer(buffer);
+        writer.write(*(indv->get_tree()));
+        writer.write_rpn(rpn);
+
+        GenomeReader reader(buffer.data(), buffer.size());
+        REQUIRE(reader.count() == 2);
+
+        GenomeView from_tree, from_rpn;
+        reader.next(from_tree);
+        reader.next(from_rpn);
+
+        // Both writers agree byte for byte.
+        REQUIRE(from_tree.length == from_rpn.length);
+        REQUIRE(std::equal(from_tree.body, from_tree.body + from_tree.length,
+                           from_rpn.body));
+
+        // Decoding and encoding again gives the same bytes.
+        vector<uint8_t> again;
+        GenomeWriter(again).write(
+            *Serialization::decode_tree(from_tree.body, from_tree.length));
+        REQUIRE(again == vector<uint8_t>(buffer.begin(),
+            buffer.begin() + sizeof(uint32_t) + from_tree.length));
+
+        // Evaluating the record matches evaluating the text.
+        for (float x : samples) {
+            REQUIRE(Evaluation::evaluate_encoded(from_tree, x)
+                    == Evaluation::evaluate_rpn(rpn, x));
+        }
+        REQUIRE(Evaluation::assign_rmse(from_tree, samples, ground_truth)
+                == Approx(Evaluation::assign_rmse(rpn, samples, ground_truth)));
+
+        // Binary is smaller than the text form.
+        REQUIRE(from_tree.length < rpn.size());
+    }
+}
+
+TEST_CASE("Linear round trip is exact", "[unit]") {
+    mt19937 engine(1);
+    vector<uint8_t> buffer;
+    GenomeWriter writer(buffer);
+    vector<LinearProgram> programs;
+
+    for (int i = 0; i < 50; i++) {
+        programs.push_back(LinearEvolution::random_program(1 + i, engine)->get_program());
+        writer.write(programs.back());
+    }
+
+    GenomeReader reader(buffer.data(), buffer.size());
+    REQUIRE(reader.count() == programs.size());
+
+    GenomeView genome;
+    for (size_t i = 0; i < programs.size(); i++) {
+        REQUIRE(reader.next(genome));
+        LinearProgram decoded = Serialization::decode_linear(genome.body, genome.length);
+        REQUIRE(decoded.get_instructions() == programs[i].get_instructions());
+    }
+}
+
+TEST_CASE("Format constants", "[unit]") {
+    REQUIRE(Serialization::format_constant(5) == "5");
+    REQUIRE(Serialization::format_constant(std::stof("6.885315")) == "6.885315");
+    REQUIRE(Serialization::format_constant(std::stof("-3.141593")) == "-3.141593");
+
+    float tricky = 0.1f + 0.2f;
+    REQUIRE(std::stof(Serialization::format_constant(tricky)) == tricky);
+}
+
+TEST_CASE("Constants keep full precision", "[unit]") {
+    float constant = std::nextafter(6.885315f, 7.0f);
+    RPNTree tree("x 1 +");
+    tree.node_at(1)->set_constant(constant);
+    REQUIRE(std::stof(tree.node_at(1)->value) == constant);
+
+    // Copies and the encoded record carry the exact float.
+    RPNTree copy(tree);
+    vector<uint8_t> buffer;
+    GenomeWriter(buffer).write(copy);
+    GenomeView genome;
+    GenomeReader(buffer.data(), buffer.size()).next(genome);
+    REQUIRE(Serialization::read_float(genome.body + 2) == constant);
+    REQUIRE(Serialization::decode_tree(genome.body, genome.length)
+            ->get_rpn_string() == tree.get_rpn_string());
+
+    // New constants match their text form.
+    mt19937 engine(2);
+    for (int i = 0; i < 50; i++) {
+        tree_ptr grown = Evolution::grow(6, engine)->get_tree();
+        for (int n = 0; n < grown->num_nodes(); n++) {
+            node_ptr node = grown->node_at(n);
+            if (node->is_leaf() && ! Evaluation::is_variable(node->value)) {
+                REQUIRE(std::stof(node->value) == node->constant);
+            }
+        }
+    }
+}
+
+TEST_CASE("Malformed records are rejected", "[unit]") {
+    vector<uint8_t> buffer;
+    GenomeWriter(buffer).write(RPNTree("x 4 5 + *"));
+    GenomeView genome;
+    GenomeReader(buffer.data(), buffer.size()).next(genome);
+    REQUIRE(Serialization::valid_tree(genome.body, genome.length));
+
+    // Missing operand, leftover operand, unknown opcode, cut constant.
+    vector<uint8_t> body(genome.body, genome.body + genome.length);
+    REQUIRE(! Serialization::valid_tree(body.data() + 1, body.size() - 1));
+    REQUIRE(! Serialization::valid_tree(body.data(), body.size() - 1));
+    REQUIRE(! Serialization::valid_tree(body.data(), 0));
+    body[0] = 9;
+    REQUIRE(! Serialization::valid_tree(body.data(), body.size()));
+    REQUIRE(! Serialization::valid_tree(genome.body, 3));
+
+    // r1 = r0 * 2.5; r0 = r1 + r2
+    LinearProgram program("* 1 0 4 2.5;+ 0 1 2 0;");
+    buffer.clear();
+    GenomeWriter(buffer).write(program);
+    GenomeReader(buffer.data(), buffer.size()).next(genome);
+    REQUIRE(Serialization::valid_linear(genome.body, genome.length));
+    REQUIRE(! Serialization::valid_linear(genome.body, genome.length - 1));
+    body.assign(genome.body, genome.body + genome.length);
+    body[1] = LinearProgram::NUM_REGISTERS;
+    REQUIRE(! Serialization::valid_linear(body.data(), body.size()));
+
+    // A length prefix past the end stops the reader where it is.
+    uint32_t length = buffer.size();
+    std::memcpy(buffer.data(), &length, sizeof(length));
+    GenomeReader reader(buffer.data(), buffer.size());
+    REQUIRE(! reader.next(genome));
+    REQUIRE(reader.get_offset() == 0);
+    REQUIRE(reader.count() == 0);
+}
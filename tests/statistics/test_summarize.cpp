@@ -0,0 +1,99 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include <memory>
+#include <numeric>
+#include <algorithm>
+#include "../../gp/statistics.h"
+#include "../../gp/population.h"
+#include "../../gp/individual.h"
+#include "../../gp/engine.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::mt19937; using std::vector;
+
+/**
+ * Median of a sorted copy.
+ */
+template <typename T>
+float sorted_median(vector<T> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    if (n % 2 == 1) {
+        return values[n / 2];
+    }
+    return (values[n / 2 - 1] + values[n / 2]) / 2.0f;
+}
+
+TEST_CASE("Medians of odd and even counts", "[unit]") {
+    REQUIRE(Statistics::median(vector<int>{5, 1, 3}) == 3);
+    REQUIRE(Statistics::median(vector<int>{4, 1, 3, 2}) == 2.5);
+    REQUIRE(Statistics::median(vector<float>{7}) == 7);
+    REQUIRE(Statistics::median(vector<float>{2, 2, 9, 2}) == 2);
+}
+
+TEST_CASE("Summary matches a sort over more than one block", "[unit]") {
+    mt19937 engine(3);
+    std::uniform_real_distribution<float> rmse(0, 100);
+    std::uniform_int_distribution<int> size(1, 60);
+    size_t n = Statistics::BLOCK * 2 + 17;
+    vector<float> fitnesses(n);
+    vector<int> sizes(n);
+    for (size_t i = 0; i < n; i++) {
+        sizes[i] = size(engine);
+        fitnesses[i] = rmse(engine) + sizes[i];
+    }
+    // A tie for the best in a later block keeps the first one.
+    fitnesses[Statistics::BLOCK + 5] = -1;
+    fitnesses[Statistics::BLOCK * 2 + 3] = -1;
+
+    Summary summary = Statistics::summarize(fitnesses, sizes);
+
+    vector<float> rmses(n);
+    for (size_t i = 0; i < n; i++) {
+        rmses[i] = fitnesses[i] - sizes[i];
+    }
+    double mean = std::accumulate(rmses.begin(), rmses.end(), 0.0) / n;
+    double squares = 0;
+    for (float value : rmses) {
+        squares += (value - mean) * (value - mean);
+    }
+    long total = std::accumulate(sizes.begin(), sizes.end(), 0L);
+
+    REQUIRE(summary.best == Statistics::BLOCK + 5);
+    REQUIRE(summary.max_rmse == *std::max_element(rmses.begin(), rmses.end()));
+    REQUIRE(summary.min_rmse == *std::min_element(rmses.begin(), rmses.end()));
+    REQUIRE(summary.mean_rmse == Approx(mean));
+    REQUIRE(summary.rmse_std == Approx(std::sqrt(squares / (n - 1))));
+    REQUIRE(summary.median_rmse == sorted_median(rmses));
+    REQUIRE(summary.max_nodes == *std::max_element(sizes.begin(), sizes.end()));
+    REQUIRE(summary.min_nodes == *std::min_element(sizes.begin(), sizes.end()));
+    REQUIRE(summary.mean_nodes == Approx(total / (double)n));
+    REQUIRE(summary.median_nodes == sorted_median(sizes));
+    REQUIRE(summary.total_nodes == total);
+}
+
+TEST_CASE("Packing leaves the population order alone", "[unit]") {
+    mt19937 engine(1);
+    auto population = std::make_shared<Population>(50);
+    population->initialize(engine, 2, 4);
+    for (size_t i = 0; i < population->get_length(); i++) {
+        (*population)[i]->set_fitness(50 - i);
+    }
+    vector<Individual *> order;
+    for (size_t i = 0; i < population->get_length(); i++) {
+        order.push_back((*population)[i].get());
+    }
+
+    vector<float> fitnesses;
+    vector<int> sizes;
+    Statistics::pack(population, fitnesses, sizes);
+    Summary summary = Statistics::summarize(fitnesses, sizes);
+
+    REQUIRE(summary.best == 49);
+    for (size_t i = 0; i < population->get_length(); i++) {
+        REQUIRE((*population)[i].get() == order[i]);
+        REQUIRE(fitnesses[i] == 50 - i);
+        REQUIRE(sizes[i] == EngineTraits<Population>::size((*population)[i]));
+    }
+}
@@ -0,0 +1,316 @@
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include "omp.h"
+#include "../../gp/thread_mpi.h"
+#include "../../gp/exchange.h"
+#include "../../gp/individual.h"
+#include "../../gp/serialization.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::vector; using std::string;
+
+// Ranks record what they saw, the checks run once every rank is done since
+// Catch's assertions are not thread safe.
+const int RANKS = 4;
+
+/**
+ * Rank of the calling thread in MPI_COMM_WORLD.
+ */
+int world_rank() {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    return rank;
+}
+
+TEST_CASE("Messages from one source arrive in order", "[unit]") {
+    const int count = 200;
+    vector<vector<int>> received(RANKS);
+
+    ThreadMPI::run(RANKS, [&received]() {
+        int rank = world_rank();
+        if (rank > 0) {
+            for (int i = 0; i < count; i++) {
+                int value = rank * count + i;
+                MPI_Send(&value, 1, MPI_INT, 0, 5, MPI_COMM_WORLD);
+            }
+            return;
+        }
+
+        for (int i = 0; i < count * (RANKS - 1); i++) {
+            int value;
+            MPI_Status status;
+            MPI_Recv(&value, 1, MPI_INT, MPI_ANY_SOURCE, 5, MPI_COMM_WORLD, &status);
+            received[status.MPI_SOURCE].push_back(value);
+        }
+    });
+
+    for (int source = 1; source < RANKS; source++) {
+        REQUIRE(received[source].size() == (size_t)count);
+        for (int i = 0; i < count; i++) {
+            REQUIRE(received[source][i] == source * count + i);
+        }
+    }
+}
+
+TEST_CASE("Receives match in posting order", "[unit]") {
+    int first = 0, second = 0;
+
+    ThreadMPI::run(RANKS, [&first, &second]() {
+        int rank = world_rank();
+        MPI_Request requests[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+
+        // Both receives are posted before anything is sent.
+        if (rank == 0) {
+            MPI_Irecv(&first, 1, MPI_INT, 1, 7, MPI_COMM_WORLD, &requests[0]);
+            MPI_Irecv(&second, 1, MPI_INT, MPI_ANY_SOURCE, 7, MPI_COMM_WORLD,
+                &requests[1]);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        if (rank == 1) {
+            int values[2] = {10, 20};
+            MPI_Send(&values[0], 1, MPI_INT, 0, 7, MPI_COMM_WORLD);
+            MPI_Send(&values[1], 1, MPI_INT, 0, 7, MPI_COMM_WORLD);
+        }
+        MPI_Waitall(2, requests, MPI_STATUSES_IGNORE);
+    });
+
+    REQUIRE(first == 10);
+    REQUIRE(second == 20);
+}
+
+TEST_CASE("Waitany is undefined once every request is null", "[unit]") {
+    vector<int> order;
+    int after = 0, empty = 0;
+
+    ThreadMPI::run(RANKS, [&order, &after, &empty]() {
+        int rank = world_rank();
+        if (rank > 0) {
+            MPI_Send(&rank, 1, MPI_INT, 0, 3, MPI_COMM_WORLD);
+            return;
+        }
+
+        vector<int> values(RANKS - 1);
+        vector<MPI_Request> requests(RANKS - 1);
+        for (int r = 1; r < RANKS; r++) {
+            MPI_Irecv(&values[r - 1], 1, MPI_INT, r, 3, MPI_COMM_WORLD,
+                &requests[r - 1]);
+        }
+
+        int index;
+        MPI_Waitany(requests.size(), requests.data(), &index, MPI_STATUS_IGNORE);
+        while (index != MPI_UNDEFINED) {
+            order.push_back(values[index]);
+            MPI_Waitany(requests.size(), requests.data(), &index, MPI_STATUS_IGNORE);
+        }
+        after = index;
+
+        MPI_Request none[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+        MPI_Waitany(2, none, &empty, MPI_STATUS_IGNORE);
+    });
+
+    std::sort(order.begin(), order.end());
+    REQUIRE(order == vector<int>({1, 2, 3}));
+    REQUIRE(after == MPI_UNDEFINED);
+    REQUIRE(empty == MPI_UNDEFINED);
+}
+
+TEST_CASE("Collectives give MPI's results", "[unit]") {
+    vector<vector<int>> scattered(RANKS);
+    vector<int> gathered;
+    vector<int> sums(RANKS), maxima(RANKS), prefixes(RANKS, -1);
+    vector<double> float_sums(RANKS);
+
+    ThreadMPI::run(RANKS, [&]() {
+        int rank = world_rank();
+
+        // Rank r gets r + 1 values.
+        vector<int> counts = {1, 2, 3, 4}, displacements = {0, 1, 3, 6};
+        vector<int> values(10);
+        for (int i = 0; i < 10; i++) {
+            values[i] = i;
+        }
+        vector<int> mine(rank + 1);
+        MPI_Scatterv(values.data(), counts.data(), displacements.data(), MPI_INT,
+            mine.data(), rank + 1, MPI_INT, 0, MPI_COMM_WORLD);
+        scattered[rank] = mine;
+
+        // And sends them back scaled.
+        for (int & value : mine) {
+            value *= 10;
+        }
+        vector<int> all(rank == 0 ? 10 : 0);
+        MPI_Gatherv(mine.data(), mine.size(), MPI_INT, all.data(), counts.data(),
+            displacements.data(), MPI_INT, 0, MPI_COMM_WORLD);
+        if (rank == 0) {
+            gathered = all;
+        }
+
+        int value = rank + 1;
+        MPI_Allreduce(&value, &sums[rank], 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+        MPI_Allreduce(&value, &maxima[rank], 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+        double half = value / 2.0;
+        MPI_Allreduce(&half, &float_sums[rank], 1, MPI_DOUBLE, MPI_SUM,
+            MPI_COMM_WORLD);
+        MPI_Exscan(&value, &prefixes[rank], 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    });
+
+    REQUIRE(scattered[0] == vector<int>({0}));
+    REQUIRE(scattered[1] == vector<int>({1, 2}));
+    REQUIRE(scattered[2] == vector<int>({3, 4, 5}));
+    REQUIRE(scattered[3] == vector<int>({6, 7, 8, 9}));
+    REQUIRE(gathered == vector<int>({0, 10, 20, 30, 40, 50, 60, 70, 80, 90}));
+    for (int r = 0; r < RANKS; r++) {
+        REQUIRE(sums[r] == 10);
+        REQUIRE(maxima[r] == RANKS);
+        REQUIRE(float_sums[r] == 5);
+    }
+    // Rank 0's result is undefined and left alone.
+    REQUIRE(prefixes == vector<int>({-1, 1, 3, 6}));
+}
+
+TEST_CASE("Put through a vector type lands at strided indices", "[unit]") {
+    const int per_rank = 3;
+    vector<float> window_values;
+
+    ThreadMPI::run(RANKS, [&window_values]() {
+        int rank = world_rank();
+        float * base = nullptr;
+        MPI_Win window;
+        MPI_Aint bytes = (rank == 0) ? RANKS * per_rank * sizeof(float) : 0;
+        MPI_Win_allocate(bytes, sizeof(float), MPI_INFO_NULL, MPI_COMM_WORLD,
+            &base, &window);
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+
+        // Value k of rank r goes to index r + k * RANKS.
+        vector<float> values(per_rank);
+        for (int k = 0; k < per_rank; k++) {
+            values[k] = rank * 100 + k;
+        }
+        MPI_Datatype target;
+        MPI_Type_vector(per_rank, 1, RANKS, MPI_FLOAT, &target);
+        MPI_Type_commit(&target);
+        MPI_Put(values.data(), per_rank, MPI_FLOAT, 0, rank, 1, target, window);
+        MPI_Type_free(&target);
+        MPI_Win_flush(0, window);
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        if (rank == 0) {
+            MPI_Win_sync(window);
+            window_values.assign(base, base + RANKS * per_rank);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Win_unlock_all(window);
+        MPI_Win_free(&window);
+    });
+
+    REQUIRE(window_values.size() == (size_t)(RANKS * per_rank));
+    for (int r = 0; r < RANKS; r++) {
+        for (int k = 0; k < per_rank; k++) {
+            REQUIRE(window_values[r + k * RANKS] == r * 100 + k);
+        }
+    }
+}
+
+TEST_CASE("Exchange scatters records and gathers results", "[unit]") {
+    vector<string> rpns = {"x", "x 1 +", "x x * 2 -", "3", "x 2 / x *", "x 4 5 + *"};
+    // Ranks get different numbers of records, rank 2 none and some twice.
+    vector<vector<int>> assignment = {{0, 1}, {2, 3, 4}, {}, {5, 1}};
+    vector<float> gathered;
+    vector<int> records(RANKS);
+
+    ThreadMPI::run(RANKS, [&]() {
+        int rank = world_rank();
+        Exchange exchange(rank, RANKS, 0);
+
+        vector<uint8_t> buffer;
+        if (rank == 0) {
+            GenomeWriter writer(buffer);
+            for (const string & rpn : rpns) {
+                writer.write_rpn(rpn);
+            }
+            vector<GenomeView> unique;
+            GenomeReader reader(buffer.data(), buffer.size());
+            GenomeView genome;
+            while (reader.next(genome)) {
+                unique.push_back(genome);
+            }
+            exchange.pack(assignment, unique);
+        }
+
+        int received;
+        const uint8_t * data = exchange.scatter(received);
+
+        // Every record's result is its number of tokens.
+        vector<float> results;
+        GenomeReader reader(data, received);
+        GenomeView genome;
+        while (reader.next(genome)) {
+            results.push_back(Serialization::num_tokens(genome.body, genome.length));
+        }
+        records[rank] = results.size();
+
+        const float * all = exchange.gather(results, assignment, 1);
+        if (rank == 0) {
+            gathered.assign(all, all + 7);
+        }
+    });
+
+    REQUIRE(records == vector<int>({2, 3, 0, 2}));
+    vector<float> expected;
+    for (const vector<int> & assigned : assignment) {
+        for (int i : assigned) {
+            RPNTree tree(rpns[i]);
+            expected.push_back(tree.num_nodes());
+        }
+    }
+    REQUIRE(gathered == expected);
+}
+
+TEST_CASE("Ranks share the caller's OpenMP threads", "[unit]") {
+    vector<int> threads(RANKS);
+    int before = omp_get_max_threads();
+
+    omp_set_num_threads(5 * RANKS);
+    ThreadMPI::run(RANKS, [&threads]() {
+        threads[world_rank()] = omp_get_max_threads();
+    });
+    omp_set_num_threads(before);
+
+    REQUIRE(threads == vector<int>(RANKS, 5));
+}
+
+TEST_CASE("Any thread of a rank's team can make MPI calls", "[unit]") {
+    vector<int> sums(RANKS);
+    int before = omp_get_max_threads();
+
+    omp_set_num_threads(2 * RANKS);
+    ThreadMPI::run(RANKS, [&sums]() {
+        int rank = world_rank();
+        vector<int> ranks(omp_get_max_threads(), -1);
+
+        // Every thread of the team sees the rank, and the reduction runs
+        // on whichever thread enters the single region.
+        #pragma omp parallel
+        {
+            ranks[omp_get_thread_num()] = world_rank();
+            #pragma omp barrier
+            #pragma omp single
+            {
+                int value = rank + 1;
+                MPI_Allreduce(&value, &sums[rank], 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+            }
+        }
+
+        for (int seen : ranks) {
+            if (seen != rank) {
+                sums[rank] = -1;
+            }
+        }
+    });
+    omp_set_num_threads(before);
+
+    REQUIRE(sums == vector<int>(RANKS, 10));
+}
@@ -0,0 +1,65 @@
+#include <vector>
+#include "../../gp/random.h"
+#include "../../gp/work_queue.h"
+#include "../../third-party/Catch2/single_include/catch2/catch.hpp"
+
+using std::vector;
+
+TEST_CASE("Chunks cover every record once, largest first", "[unit]") {
+    vector<double> costs(500);
+    Philox engine(1, 0, 0, Philox::SAMPLE);
+    for (double & cost : costs) {
+        cost = 1 + engine.below(100);
+    }
+
+    WorkQueue queue(4);
+    queue.reset(costs);
+
+    vector<int> seen(costs.size(), 0);
+    vector<double> chunk_costs;
+    size_t begin, end, expected = 0;
+    while (queue.next(begin, end)) {
+        REQUIRE(begin == expected);
+        REQUIRE(end > begin);
+        expected = end;
+
+        double chunk = 0;
+        for (size_t k = begin; k < end; k++) {
+            seen[queue.get_order()[k]]++;
+            chunk += costs[queue.get_order()[k]];
+        }
+        chunk_costs.push_back(chunk);
+    }
+
+    REQUIRE(expected == costs.size());
+    REQUIRE(queue.empty());
+    for (int count : seen) {
+        REQUIRE(count == 1);
+    }
+
+    // Guided: chunks shrink and the first is about an eighth of the total.
+    double total = 0;
+    for (double cost : costs) {
+        total += cost;
+    }
+    REQUIRE(chunk_costs.front() <= total / 8);
+    REQUIRE(chunk_costs.front() > total / 8 - 100);
+    REQUIRE(chunk_costs.back() < chunk_costs.front() / 10);
+}
+
+TEST_CASE("A record over the target is a chunk of its own", "[unit]") {
+    vector<double> costs = {1, 1000, 1, 1};
+    WorkQueue queue(2);
+    queue.reset(costs);
+
+    size_t begin, end;
+    REQUIRE(queue.next(begin, end));
+    REQUIRE(end - begin == 1);
+    REQUIRE(queue.get_order()[begin] == 1);
+
+    // Reset drops what was left.
+    queue.reset(vector<double>{5});
+    REQUIRE(queue.next(begin, end));
+    REQUIRE((begin == 0 && end == 1));
+    REQUIRE(! queue.next(begin, end));
+}